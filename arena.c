@@ -0,0 +1,102 @@
+/*
+ * arena.c
+ * Size-class allocator for variable-size keys built on slab pools
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "arena.h"
+
+/*
+ * Index of the smallest class holding "size" bytes,
+ * ARENA_CLASS_COUNT if the block is too large for any class
+ */
+static size_t size_class(size_t size) {
+    size_t class_size = ARENA_MIN_CLASS;
+    size_t index = 0;
+
+    while (index < ARENA_CLASS_COUNT && class_size < size) {
+        class_size <<= 1;
+        index++;
+    }
+
+    return index;
+}
+
+KeyArena *init_key_arena(size_t chunk_objects) {
+    if (chunk_objects == 0) {
+        fprintf(stderr, "Key arena chunk size must be positive!\n");
+        return NULL;
+    }
+
+    KeyArena *arena = (KeyArena *)calloc(1, sizeof(KeyArena));
+    if (!arena) {
+        fprintf(stderr, "Could not allocate key arena!\n");
+        return NULL;
+    }
+
+    arena->chunk_objects = chunk_objects;
+    arena->bytes_used = 0;
+
+    return arena;
+}
+
+void *arena_alloc(KeyArena *arena, size_t size) {
+    if (!arena) {
+        fprintf(stderr, "Key arena is not valid or is null!\n");
+        return NULL;
+    }
+
+    size_t index = size_class(size);
+    if (index == ARENA_CLASS_COUNT) {
+        void *block = malloc(size);
+        if (block)
+            arena->bytes_used += size;
+        return block;
+    }
+
+    if (!arena->classes[index]) {
+        arena->classes[index] = init_slab_pool((size_t)ARENA_MIN_CLASS << index, arena->chunk_objects);
+        if (!arena->classes[index])
+            return NULL;
+    }
+
+    void *block = slab_alloc(arena->classes[index]);
+    if (block)
+        arena->bytes_used += (size_t)ARENA_MIN_CLASS << index;
+
+    return block;
+}
+
+void arena_free(KeyArena *arena, void *block, size_t size) {
+    if (!arena || !block)
+        return;
+
+    size_t index = size_class(size);
+    if (index == ARENA_CLASS_COUNT) {
+        arena->bytes_used -= size;
+        free(block);
+        return;
+    }
+
+    arena->bytes_used -= (size_t)ARENA_MIN_CLASS << index;
+    slab_free(arena->classes[index], block);
+}
+
+void free_key_arena(KeyArena *arena) {
+    if (!arena) {
+        fprintf(stderr, "Key arena is not valid or is null!\n");
+        return;
+    }
+
+    for (size_t i = 0; i < ARENA_CLASS_COUNT; i++) {
+        if (arena->classes[i])
+            free_slab_pool(arena->classes[i]);
+    }
+
+    free(arena);
+    arena = NULL;
+
+    return;
+}
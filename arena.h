@@ -0,0 +1,49 @@
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#include <stddef.h>
+
+#include "slab.h"
+
+#define SUCCESS 0
+#define FAILURE -1
+#define IS_NULL -2
+
+/*
+ * Size classes served from slab pools: 32, 64, ..., 4096 bytes.
+ * Larger blocks go straight to malloc
+ */
+#define ARENA_MIN_CLASS 32
+#define ARENA_CLASS_COUNT 8
+
+/*
+ * Variable-size block allocator for cache-owned keys
+ * Each size class is a slab pool created on first use
+ */
+typedef struct KeyArena {
+    size_t chunk_objects;
+    size_t bytes_used;
+    SlabPool *classes[ARENA_CLASS_COUNT];
+} KeyArena;
+
+/*
+ * Initialize arena whose pools grow by "chunk_objects" blocks at a time
+ */
+KeyArena *init_key_arena(size_t chunk_objects);
+
+/*
+ * Allocate block of at least "size" bytes
+ */
+void *arena_alloc(KeyArena *arena, size_t size);
+
+/*
+ * Return block of "size" bytes (same size as passed to arena_alloc)
+ */
+void arena_free(KeyArena *arena, void *block, size_t size);
+
+/*
+ * Free every pool and the arena itself
+ */
+void free_key_arena(KeyArena *arena);
+
+#endif // _ARENA_H_
@@ -0,0 +1,390 @@
+/*
+ * bench.c
+ * Throughput, latency, hit ratio and memory of one cache under
+ * synthetic workloads. Every run is forked, so peak RSS is its own.
+ *
+ * usage: bench [-w workload] [-p policy] [-c capacity] [-k keys]
+ *              [-n ops] [-s skew] [-r read_ratio] [-l sample]
+ *
+ * workload: uniform, zipf, scan, loop, mix or all (default)
+ * policy:   lru (default), clock, buffered, slru, 2q, arc, tinylfu
+ *
+ * Reads are read-through: a miss is followed by a put of the key.
+ * mix is zipf traffic where only "read_ratio" of the operations
+ * are reads and the rest blind puts.
+ * One in "sample" operations is timed for the latency quantiles
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "lru_cache.h"
+
+#define TRACE_CHUNK 65536
+
+/*
+ * Latency histogram: 16 linear sub-buckets per power of two,
+ * quantiles are within about 6% of the real value
+ */
+#define LATENCY_SUB_BITS 4
+#define LATENCY_BUCKETS (64 << LATENCY_SUB_BITS)
+
+/*
+ * Top bit of a trace item marks a write
+ */
+#define WRITE_BIT 0x80000000u
+
+typedef enum {
+    WORKLOAD_UNIFORM,
+    WORKLOAD_ZIPF,
+    WORKLOAD_SCAN,
+    WORKLOAD_LOOP,
+    WORKLOAD_MIX,
+    WORKLOAD_COUNT
+} Workload;
+
+static const char *workload_names[] = { "uniform", "zipf", "scan", "loop", "mix" };
+
+typedef struct BenchCache {
+    const char *name;
+    const EvictionPolicy *policy;
+    bool buffered;
+} BenchCache;
+
+static const BenchCache caches[] = {
+    { "lru", &lru_policy, false },
+    { "clock", &clock_policy, false },
+    { "buffered", &lru_policy, true },
+    { "slru", &slru_policy, false },
+    { "2q", &two_queue_policy, false },
+    { "arc", &arc_policy, false },
+    { "tinylfu", &tinylfu_policy, false },
+};
+
+typedef struct BenchConfig {
+    const BenchCache *cache;
+    size_t capacity;
+    size_t keys;
+    size_t ops;
+    double skew;
+    double read_ratio;
+    size_t sample;
+} BenchConfig;
+
+/*
+ * Zipf generator of Gray et al. ("Quickly generating billion-record
+ * synthetic databases"), O(1) per draw after an O(keys) setup
+ */
+typedef struct Zipf {
+    size_t keys;
+    double theta;
+    double alpha;
+    double zetan;
+    double eta;
+} Zipf;
+
+static unsigned int trace[TRACE_CHUNK];
+static u_int64_t latency[LATENCY_BUCKETS];
+static char value[] = "value";
+
+static unsigned long long rng_state = 42;
+
+static unsigned long long next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static double next_unit(void) {
+    return (double)(next_random() >> 11) / (double)(1ULL << 53);
+}
+
+static u_int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u_int64_t)ts.tv_sec * 1000000000u + (u_int64_t)ts.tv_nsec;
+}
+
+static void init_zipf(Zipf *zipf, size_t keys, double theta) {
+    double zeta2 = 1.0 + 1.0 / pow(2.0, theta);
+    zipf->zetan = 0;
+    for (size_t i = 1; i <= keys; i++)
+        zipf->zetan += 1.0 / pow((double)i, theta);
+
+    zipf->keys = keys;
+    zipf->theta = theta;
+    zipf->alpha = 1.0 / (1.0 - theta);
+    zipf->eta = (1.0 - pow(2.0 / (double)keys, 1.0 - theta)) / (1.0 - zeta2 / zipf->zetan);
+}
+
+/*
+ * Key rank drawn from the distribution,
+ * ranks are scattered over the key space by a multiplicative permutation
+ */
+static unsigned int next_zipf(const Zipf *zipf) {
+    double u = next_unit();
+    double uz = u * zipf->zetan;
+    size_t rank;
+    if (uz < 1.0)
+        rank = 0;
+    else if (uz < 1.0 + pow(0.5, zipf->theta))
+        rank = 1;
+    else
+        rank = (size_t)((double)zipf->keys * pow(zipf->eta * u - zipf->eta + 1.0, zipf->alpha));
+    if (rank >= zipf->keys)
+        rank = zipf->keys - 1;
+
+    return (unsigned int)(((unsigned long long)rank * 2654435761u) % zipf->keys);
+}
+
+/*
+ * Fill the trace with the next "count" operations starting at "offset"
+ */
+static void generate_trace(Workload workload, const BenchConfig *config, const Zipf *zipf,
+                           size_t offset, size_t count) {
+    size_t loop = config->capacity + config->capacity / 4;
+    for (size_t i = 0; i < count; i++) {
+        size_t op = offset + i;
+        switch (workload) {
+        case WORKLOAD_UNIFORM:
+            trace[i] = (unsigned int)(next_random() % config->keys);
+            break;
+        case WORKLOAD_ZIPF:
+            trace[i] = next_zipf(zipf);
+            break;
+        case WORKLOAD_SCAN:
+            /*
+             * Zipf traffic interrupted by one-off scans of cold keys
+             */
+            if ((op / 1000) % 10 == 9)
+                trace[i] = (unsigned int)((config->keys + op) & ~WRITE_BIT);
+            else
+                trace[i] = next_zipf(zipf);
+            break;
+        case WORKLOAD_LOOP:
+            /*
+             * Cyclic scan slightly larger than the cache
+             */
+            trace[i] = (unsigned int)(op % loop);
+            break;
+        case WORKLOAD_MIX:
+            trace[i] = next_zipf(zipf);
+            if (next_unit() >= config->read_ratio)
+                trace[i] |= WRITE_BIT;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+static void record_latency(u_int64_t ns) {
+    unsigned int bucket = (unsigned int)ns;
+    if (ns >= (1u << LATENCY_SUB_BITS)) {
+        unsigned int exponent = 63 - (unsigned int)__builtin_clzll(ns) - LATENCY_SUB_BITS;
+        bucket = ((exponent + 1) << LATENCY_SUB_BITS) + (unsigned int)((ns >> exponent) & ((1u << LATENCY_SUB_BITS) - 1));
+    }
+
+    latency[bucket]++;
+}
+
+/*
+ * Upper bound in nanoseconds of the bucket holding quantile "q"
+ */
+static u_int64_t latency_quantile(double q) {
+    u_int64_t total = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++)
+        total += latency[i];
+    if (total == 0)
+        return 0;
+
+    u_int64_t rank = (u_int64_t)(q * (double)total);
+    if (rank >= total)
+        rank = total - 1;
+
+    u_int64_t seen = 0;
+    int bucket = 0;
+    for (; bucket < LATENCY_BUCKETS; bucket++) {
+        seen += latency[bucket];
+        if (seen > rank)
+            break;
+    }
+
+    if (bucket < (1 << LATENCY_SUB_BITS))
+        return (u_int64_t)bucket + 1;
+    unsigned int exponent = (unsigned int)(bucket >> LATENCY_SUB_BITS) - 1;
+    u_int64_t sub = (u_int64_t)(bucket & ((1 << LATENCY_SUB_BITS) - 1)) + (1u << LATENCY_SUB_BITS);
+
+    return (sub + 1) << exponent;
+}
+
+static inline void run_op(LRUCache *lru, unsigned int *item) {
+    if (*item & WRITE_BIT) {
+        *item &= ~WRITE_BIT;
+        put_bytes(lru, item, sizeof(*item), value, sizeof(value) - 1);
+    } else if (get_value(lru, item, sizeof(*item), NULL, NULL) != SUCCESS) {
+        put_bytes(lru, item, sizeof(*item), value, sizeof(value) - 1);
+    }
+}
+
+/*
+ * Replay the workload, returns seconds spent in the cache.
+ * Trace generation runs between timed chunks
+ */
+static double replay(LRUCache *lru, Workload workload, const BenchConfig *config, const Zipf *zipf) {
+    u_int64_t elapsed = 0;
+    for (size_t offset = 0; offset < config->ops; offset += TRACE_CHUNK) {
+        size_t count = config->ops - offset < TRACE_CHUNK ? config->ops - offset : TRACE_CHUNK;
+        generate_trace(workload, config, zipf, offset, count);
+
+        u_int64_t start = now_ns();
+        for (size_t i = 0; i < count; i++) {
+            if (i % config->sample != 0) {
+                run_op(lru, &trace[i]);
+                continue;
+            }
+
+            u_int64_t op_start = now_ns();
+            run_op(lru, &trace[i]);
+            record_latency(now_ns() - op_start);
+        }
+        elapsed += now_ns() - start;
+    }
+
+    return (double)elapsed / 1e9;
+}
+
+static void run_workload(Workload workload, const BenchConfig *config) {
+    Zipf zipf;
+    if (workload == WORKLOAD_ZIPF || workload == WORKLOAD_SCAN || workload == WORKLOAD_MIX)
+        init_zipf(&zipf, config->keys, config->skew);
+
+    LRUCache *lru;
+    if (config->cache->buffered)
+        lru = init_buffered_cache(config->capacity);
+    else
+        lru = init_policy_cache(config->capacity, config->cache->policy);
+    if (!lru)
+        exit(EXIT_FAILURE);
+
+    double seconds = replay(lru, workload, config, &zipf);
+
+    CacheStats stats;
+    cache_stats_snapshot(lru, &stats);
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    printf("%s,%s,%zu,%zu,%zu,%.2f,%.2f,%.3f,%.0f,%llu,%llu,%llu,%.4f,%ld\n",
+           workload_names[workload], config->cache->name, config->capacity, config->keys, config->ops,
+           config->skew, workload == WORKLOAD_MIX ? config->read_ratio : 1.0, seconds,
+           (double)config->ops / seconds, (unsigned long long)latency_quantile(0.5),
+           (unsigned long long)latency_quantile(0.99), (unsigned long long)latency_quantile(0.999),
+           stats_hit_ratio(&stats), usage.ru_maxrss);
+    fflush(stdout);
+
+    free_lru(lru);
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "usage: %s [-w uniform|zipf|scan|loop|mix|all] [-p lru|clock|buffered|slru|2q|arc|tinylfu]\n"
+                    "          [-c capacity] [-k keys] [-n ops] [-s skew] [-r read_ratio] [-l sample]\n", name);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+    BenchConfig config = {
+        .cache = &caches[0],
+        .capacity = 100000,
+        .keys = 1000000,
+        .ops = 4000000,
+        .skew = 0.99,
+        .read_ratio = 0.9,
+        .sample = 16,
+    };
+    int first = WORKLOAD_UNIFORM, last = WORKLOAD_COUNT - 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "w:p:c:k:n:s:r:l:")) != -1) {
+        switch (opt) {
+        case 'w':
+            if (strcmp(optarg, "all") == 0)
+                break;
+            for (first = 0; first < WORKLOAD_COUNT && strcmp(optarg, workload_names[first]) != 0; first++)
+                ;
+            if (first == WORKLOAD_COUNT)
+                usage(argv[0]);
+            last = first;
+            break;
+        case 'p':
+            config.cache = NULL;
+            for (size_t p = 0; p < sizeof(caches) / sizeof(caches[0]); p++) {
+                if (strcmp(optarg, caches[p].name) == 0)
+                    config.cache = &caches[p];
+            }
+            if (!config.cache)
+                usage(argv[0]);
+            break;
+        case 'c':
+            config.capacity = strtoul(optarg, NULL, 10);
+            break;
+        case 'k':
+            config.keys = strtoul(optarg, NULL, 10);
+            break;
+        case 'n':
+            config.ops = strtoul(optarg, NULL, 10);
+            break;
+        case 's':
+            config.skew = strtod(optarg, NULL);
+            break;
+        case 'r':
+            config.read_ratio = strtod(optarg, NULL);
+            break;
+        case 'l':
+            config.sample = strtoul(optarg, NULL, 10);
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    /*
+     * The zipf generator needs 0 < skew < 1, keys must leave
+     * the top bit of a trace item to mark writes
+     */
+    if (config.capacity == 0 || config.keys < 2 || config.keys >= WRITE_BIT / 2 || config.ops == 0
+            || config.skew <= 0 || config.skew >= 1 || config.read_ratio < 0 || config.read_ratio > 1
+            || config.sample == 0) {
+        fprintf(stderr, "Benchmark parameters are out of range!\n");
+        usage(argv[0]);
+    }
+
+    printf("workload,eviction,capacity,keys,ops,skew,read_ratio,seconds,ops_per_s,"
+           "p50_ns,p99_ns,p999_ns,hit_ratio,peak_rss_kb\n");
+    fflush(stdout);
+
+    for (int w = first; w <= last; w++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            fprintf(stderr, "Could not fork benchmark run!\n");
+            exit(EXIT_FAILURE);
+        }
+        if (pid == 0) {
+            run_workload((Workload)w, &config);
+            exit(EXIT_SUCCESS);
+        }
+
+        int status;
+        if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "Benchmark run %s failed!\n", workload_names[w]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    return 0;
+}
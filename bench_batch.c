@@ -0,0 +1,96 @@
+/*
+ * bench_batch.c
+ * Lookup throughput of mget against a get_value loop, by batch size.
+ * The cache is larger than the last level cache, so nearly every probe
+ * misses in cache and the interleaving of mget has stalls to overlap
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "lru_cache.h"
+
+#define CACHE_KEYS (1 << 20)
+#define LOOKUPS (1 << 22)
+#define MAX_BATCH 256
+
+static unsigned int keys[CACHE_KEYS];
+static unsigned int trace[LOOKUPS];
+static char value[] = "value";
+
+static const void *batch_keys[MAX_BATCH];
+static size_t batch_lens[MAX_BATCH];
+static void *batch_values[MAX_BATCH];
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static unsigned long long rng_state = 42;
+
+static unsigned long long next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static size_t run_scalar(LRUCache *lru) {
+    size_t hits = 0;
+    for (size_t i = 0; i < LOOKUPS; i++) {
+        if (get_value(lru, &keys[trace[i]], sizeof(keys[0]), NULL, NULL) == SUCCESS)
+            hits++;
+    }
+
+    return hits;
+}
+
+static size_t run_batched(LRUCache *lru, size_t batch) {
+    size_t hits = 0;
+    for (size_t i = 0; i < LOOKUPS; i += batch) {
+        for (size_t j = 0; j < batch; j++) {
+            batch_keys[j] = &keys[trace[i + j]];
+            batch_lens[j] = sizeof(keys[0]);
+        }
+        hits += mget(lru, batch_keys, batch_lens, batch, batch_values, NULL);
+    }
+
+    return hits;
+}
+
+int main(void) {
+    LRUCache *lru = init_lru_cache(CACHE_KEYS);
+    if (!lru)
+        exit(EXIT_FAILURE);
+
+    for (size_t i = 0; i < CACHE_KEYS; i++) {
+        keys[i] = (unsigned int)(i * 2654435761u);
+        put_bytes(lru, &keys[i], sizeof(keys[i]), value, sizeof(value) - 1);
+    }
+    for (size_t i = 0; i < LOOKUPS; i++)
+        trace[i] = next_random() % CACHE_KEYS;
+
+    printf("mode,batch,keys,lookups,seconds,mops_per_s\n");
+
+    double start = now_ns();
+    size_t hits = run_scalar(lru);
+    double seconds = (now_ns() - start) / 1e9;
+    if (hits != LOOKUPS)
+        exit(EXIT_FAILURE);
+    printf("get_value,1,%d,%d,%.3f,%.2f\n", CACHE_KEYS, LOOKUPS, seconds, LOOKUPS / seconds / 1e6);
+
+    for (size_t batch = 1; batch <= MAX_BATCH; batch *= 2) {
+        start = now_ns();
+        hits = run_batched(lru, batch);
+        seconds = (now_ns() - start) / 1e9;
+        if (hits != LOOKUPS)
+            exit(EXIT_FAILURE);
+        printf("mget,%zu,%d,%d,%.3f,%.2f\n", batch, CACHE_KEYS, LOOKUPS, seconds, LOOKUPS / seconds / 1e6);
+    }
+
+    free_lru(lru);
+
+    return 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * bench_hash.c
+ * Microbenchmark of the hash functions on short and long keys
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hash.h"
+
+#define KEY_COUNT 4096
+#define MAX_KEY_LEN 256
+#define TOTAL_BYTES (256UL * 1024 * 1024)
+
+static char keys[KEY_COUNT][MAX_KEY_LEN + 1];
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/*
+ * Random printable keys of exactly "len" bytes
+ */
+static void fill_keys(size_t len) {
+    for (int i = 0; i < KEY_COUNT; i++) {
+        for (size_t j = 0; j < len; j++)
+            keys[i][j] = (char)('!' + rand() % 94);
+        keys[i][len] = '\0';
+    }
+}
+
+typedef struct BenchHash {
+    const char *name;
+    HashFunction hash_fn;
+} BenchHash;
+
+/*
+ * Original API: NUL terminated key, length found while hashing
+ */
+static Fnv32_t fnv_str_hash(const void *key, size_t len) {
+    (void)len;
+    return fnv_32a_str((const char *)key, FNV1_32A_INIT);
+}
+
+int main(void) {
+    static const size_t key_lens[] = { 8, 16, 24, 40, 64, 80, 120, 256 };
+    static const BenchHash hashes[] = {
+        { "fnv_32a_str", fnv_str_hash },
+        { "fnv_hash", fnv_hash },
+        { "murmur_hash", murmur_hash },
+    };
+
+    srand(42);
+    printf("hash,key_len,ns_per_hash,gb_per_s\n");
+
+    for (size_t l = 0; l < sizeof(key_lens) / sizeof(key_lens[0]); l++) {
+        size_t len = key_lens[l];
+        size_t rounds = TOTAL_BYTES / (len * KEY_COUNT);
+        fill_keys(len);
+
+        for (size_t h = 0; h < sizeof(hashes) / sizeof(hashes[0]); h++) {
+            volatile Fnv32_t sink = 0;
+            Fnv32_t acc = 0;
+
+            double start = now_ns();
+            for (size_t r = 0; r < rounds; r++) {
+                for (int i = 0; i < KEY_COUNT; i++)
+                    acc ^= hashes[h].hash_fn(keys[i], len);
+            }
+            double elapsed = now_ns() - start;
+            sink = acc;
+            (void)sink;
+
+            double count = (double)rounds * KEY_COUNT;
+            printf("%s,%zu,%.2f,%.2f\n", hashes[h].name, len, elapsed / count, (count * (double)len) / elapsed);
+        }
+    }
+
+    exit(EXIT_SUCCESS);
+}
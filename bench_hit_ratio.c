@@ -0,0 +1,152 @@
+/*
+ * bench_hit_ratio.c
+ * Hit ratio of the eviction policies on identical access traces.
+ * Every miss is followed by a put, as a read-through cache would do
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "lru_cache.h"
+
+#define KEY_SPACE 100000
+#define ACCESSES 2000000
+#define ZIPF_SKEW 0.99
+
+typedef enum {
+    WORKLOAD_UNIFORM,
+    WORKLOAD_ZIPF,
+    WORKLOAD_LOOP,
+    WORKLOAD_ZIPF_SCAN
+} Workload;
+
+static const char *workload_names[] = { "uniform", "zipf", "loop", "zipf_scan" };
+
+typedef struct BenchCache {
+    const char *name;
+    const EvictionPolicy *policy;
+    bool buffered;
+} BenchCache;
+
+static const BenchCache caches[] = {
+    { "lru", &lru_policy, false },
+    { "clock", &clock_policy, false },
+    { "buffered", &lru_policy, true },
+    { "slru", &slru_policy, false },
+    { "2q", &two_queue_policy, false },
+    { "arc", &arc_policy, false },
+    { "tinylfu", &tinylfu_policy, false },
+};
+
+static double zipf_cdf[KEY_SPACE];
+static unsigned int trace[ACCESSES];
+static char value[] = "value";
+
+static unsigned long long rng_state = 42;
+
+static unsigned long long next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static void init_zipf(double skew) {
+    double sum = 0;
+    for (int i = 0; i < KEY_SPACE; i++) {
+        sum += 1.0 / pow(i + 1, skew);
+        zipf_cdf[i] = sum;
+    }
+    for (int i = 0; i < KEY_SPACE; i++)
+        zipf_cdf[i] /= sum;
+}
+
+/*
+ * Key rank drawn by binary search over the CDF,
+ * ranks are scattered over the key space by a multiplicative permutation
+ */
+static unsigned int next_zipf(void) {
+    double u = (double)(next_random() >> 11) / (double)(1ULL << 53);
+    int low = 0, high = KEY_SPACE - 1;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (zipf_cdf[mid] < u)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return (unsigned int)(((unsigned long long)low * 2654435761u) % KEY_SPACE);
+}
+
+static void generate_trace(Workload workload, size_t capacity) {
+    rng_state = 42;
+    for (size_t i = 0; i < ACCESSES; i++) {
+        switch (workload) {
+        case WORKLOAD_UNIFORM:
+            trace[i] = next_random() % KEY_SPACE;
+            break;
+        case WORKLOAD_ZIPF:
+            trace[i] = next_zipf();
+            break;
+        case WORKLOAD_LOOP:
+            /*
+             * Cyclic scan slightly larger than the cache
+             */
+            trace[i] = i % (capacity + capacity / 4);
+            break;
+        case WORKLOAD_ZIPF_SCAN:
+            /*
+             * Zipf traffic interrupted by one-off scans of cold keys
+             */
+            if ((i / 1000) % 10 == 9)
+                trace[i] = KEY_SPACE + (unsigned int)i;
+            else
+                trace[i] = next_zipf();
+            break;
+        }
+    }
+}
+
+static double replay(LRUCache *lru) {
+    size_t hits = 0;
+    for (size_t i = 0; i < ACCESSES; i++) {
+        if (get_value(lru, &trace[i], sizeof(trace[i]), NULL, NULL) == SUCCESS)
+            hits++;
+        else
+            put_bytes(lru, &trace[i], sizeof(trace[i]), value, sizeof(value) - 1);
+    }
+
+    return (double)hits / ACCESSES;
+}
+
+int main(void) {
+    static const size_t capacities[] = { 1000, 10000 };
+
+    init_zipf(ZIPF_SKEW);
+    printf("workload,eviction,capacity,accesses,hit_ratio\n");
+
+    for (int w = WORKLOAD_UNIFORM; w <= WORKLOAD_ZIPF_SCAN; w++) {
+        for (size_t c = 0; c < sizeof(capacities) / sizeof(capacities[0]); c++) {
+            generate_trace((Workload)w, capacities[c]);
+
+            for (size_t p = 0; p < sizeof(caches) / sizeof(caches[0]); p++) {
+                LRUCache *lru;
+                if (caches[p].buffered)
+                    lru = init_buffered_cache(capacities[c]);
+                else
+                    lru = init_policy_cache(capacities[c], caches[p].policy);
+                if (!lru)
+                    exit(EXIT_FAILURE);
+
+                printf("%s,%s,%zu,%d,%.4f\n", workload_names[w], caches[p].name,
+                       capacities[c], ACCESSES, replay(lru));
+
+                free_lru(lru);
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+/*
+ * bench_sharded.c
+ * Multithreaded throughput of the sharded cache.
+ * One shard is the same as a cache behind a single global lock.
+ * CLOCK and buffered shards take the lock shared for gets
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "sharded.h"
+
+#define KEY_COUNT (1 << 17)
+#define CAPACITY (1 << 16)
+#define THREAD_OPS 200000
+#define MAX_THREADS 64
+#define SHARDS 64
+
+/*
+ * Percentage of operations that are gets
+ */
+#define READ_PERCENT 90
+
+static char keys[KEY_COUNT][24];
+static char value[] = "value";
+static const char *eviction_names[] = { "lru", "clock", "buffered" };
+static ShardedLRUCache *(*const init_caches[])(size_t capacity, size_t shard_count) = {
+    init_sharded_cache,
+    init_sharded_clock_cache,
+    init_sharded_buffered_cache,
+};
+static ShardedLRUCache *cache;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void *worker(void *arg) {
+    unsigned long long state = (unsigned long long)(size_t)arg * 0x9E3779B97F4A7C15ULL + 1;
+
+    for (int i = 0; i < THREAD_OPS; i++) {
+        /*
+         * xorshift64, cheap enough not to dominate the measurement
+         */
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        const char *key = keys[state % KEY_COUNT];
+        if ((state >> 32) % 100 < READ_PERCENT)
+            sharded_get_value(cache, key, strlen(key), NULL, NULL);
+        else
+            sharded_put_bytes(cache, key, strlen(key), value, sizeof(value) - 1);
+    }
+
+    return NULL;
+}
+
+int main(void) {
+    static const size_t shard_counts[] = { 1, SHARDS };
+    pthread_t threads[MAX_THREADS];
+
+    for (int i = 0; i < KEY_COUNT; i++)
+        snprintf(keys[i], sizeof(keys[i]), "key:%d", i);
+
+    printf("eviction,shards,threads,ops,seconds,mops_per_s\n");
+
+    for (size_t mode = 0; mode < sizeof(init_caches) / sizeof(init_caches[0]); mode++) {
+        for (size_t s = 0; s < sizeof(shard_counts) / sizeof(shard_counts[0]); s++) {
+            for (size_t thread_count = 1; thread_count <= MAX_THREADS; thread_count <<= 1) {
+                cache = init_caches[mode](CAPACITY, shard_counts[s]);
+                if (!cache)
+                    exit(EXIT_FAILURE);
+
+                /*
+                 * Warm up so gets mostly hit
+                 */
+                for (int i = 0; i < CAPACITY; i++)
+                    sharded_put_bytes(cache, keys[i], strlen(keys[i]), value, sizeof(value) - 1);
+
+                double start = now_ns();
+                for (size_t t = 0; t < thread_count; t++)
+                    pthread_create(&threads[t], NULL, worker, (void *)(t + 1));
+                for (size_t t = 0; t < thread_count; t++)
+                    pthread_join(threads[t], NULL);
+                double elapsed = (now_ns() - start) / 1e9;
+
+                double ops = (double)THREAD_OPS * thread_count;
+                printf("%s,%zu,%zu,%.0f,%.3f,%.2f\n", eviction_names[mode], cache->shard_count,
+                       thread_count, ops, elapsed, ops / elapsed / 1e6);
+
+                free_sharded_cache(cache);
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,84 @@
+/*
+ * bench_typed.c
+ * Lookup throughput of a typed u_int64_t cache against get_value
+ * on an LRUCache holding the same keys as 8 byte binary keys.
+ * Both are larger than the last level cache, so the count of
+ * dependent memory accesses per lookup dominates
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "lru_cache.h"
+#include "typed_cache.h"
+
+TYPED_CACHE_INIT(ids, u_int64_t, u_int64_t, typed_hash_u64, typed_equal)
+
+#define CACHE_KEYS (1 << 20)
+#define LOOKUPS (1 << 22)
+
+static u_int64_t keys[CACHE_KEYS];
+static u_int32_t trace[LOOKUPS];
+static char value[] = "value";
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static unsigned long long rng_state = 42;
+
+static unsigned long long next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+int main(void) {
+    LRUCache *lru = init_lru_cache(CACHE_KEYS);
+    ids_cache_t *typed = ids_init(CACHE_KEYS);
+    if (!lru || !typed)
+        exit(EXIT_FAILURE);
+
+    for (size_t i = 0; i < CACHE_KEYS; i++) {
+        keys[i] = next_random();
+        put_bytes(lru, &keys[i], sizeof(keys[i]), value, sizeof(value) - 1);
+        ids_put(typed, keys[i], i);
+    }
+    for (size_t i = 0; i < LOOKUPS; i++)
+        trace[i] = (u_int32_t)(next_random() % CACHE_KEYS);
+
+    printf("mode,keys,lookups,seconds,mops_per_s\n");
+
+    double start = now_ns();
+    size_t hits = 0;
+    for (size_t i = 0; i < LOOKUPS; i++) {
+        if (get_value(lru, &keys[trace[i]], sizeof(keys[0]), NULL, NULL) == SUCCESS)
+            hits++;
+    }
+    double seconds = (now_ns() - start) / 1e9;
+    if (hits != LOOKUPS)
+        exit(EXIT_FAILURE);
+    printf("get_value,%d,%d,%.3f,%.2f\n", CACHE_KEYS, LOOKUPS, seconds, LOOKUPS / seconds / 1e6);
+
+    start = now_ns();
+    hits = 0;
+    u_int64_t sum = 0, found = 0;
+    for (size_t i = 0; i < LOOKUPS; i++) {
+        if (ids_get(typed, keys[trace[i]], &found) == SUCCESS) {
+            hits++;
+            sum += found;
+        }
+    }
+    seconds = (now_ns() - start) / 1e9;
+    if (hits != LOOKUPS || sum == 0)
+        exit(EXIT_FAILURE);
+    printf("typed_get,%d,%d,%.3f,%.2f\n", CACHE_KEYS, LOOKUPS, seconds, LOOKUPS / seconds / 1e6);
+
+    ids_free(typed);
+    free_lru(lru);
+
+    return 0;
+}
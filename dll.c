@@ -131,6 +131,99 @@ int delete_at_end(DLL *dll) {
     return SUCCESS;
 }
 
+int link_at_front(DLL *dll, Node *node) {
+    if (!dll || !node) {
+        fprintf(stderr, "Doubly linked list or node is not valid or is null!\n");
+        return IS_NULL;
+    }
+
+    node->prev = NULL;
+    node->next = dll->head;
+
+    if (dll->head)
+        dll->head->prev = node;
+    else
+        dll->tail = node;
+
+    dll->head = node;
+    (dll->list_size)++;
+
+    return SUCCESS;
+}
+
+int link_at_end(DLL *dll, Node *node) {
+    if (!dll || !node) {
+        fprintf(stderr, "Doubly linked list or node is not valid or is null!\n");
+        return IS_NULL;
+    }
+
+    node->next = NULL;
+    node->prev = dll->tail;
+
+    if (dll->tail)
+        dll->tail->next = node;
+    else
+        dll->head = node;
+
+    dll->tail = node;
+    (dll->list_size)++;
+
+    return SUCCESS;
+}
+
+int unlink_node(DLL *dll, Node *node) {
+    if (!dll || !node) {
+        fprintf(stderr, "Doubly linked list or node is not valid or is null!\n");
+        return IS_NULL;
+    }
+
+    if (node->prev)
+        node->prev->next = node->next;
+    else
+        dll->head = node->next;
+
+    if (node->next)
+        node->next->prev = node->prev;
+    else
+        dll->tail = node->prev;
+
+    node->prev = NULL;
+    node->next = NULL;
+    (dll->list_size)--;
+
+    return SUCCESS;
+}
+
+int move_to_front(DLL *dll, Node *node) {
+    if (!dll || !node) {
+        fprintf(stderr, "Doubly linked list or node is not valid or is null!\n");
+        return IS_NULL;
+    }
+
+    /*
+     * Already at the top of the list
+     */
+    if (dll->head == node)
+        return SUCCESS;
+
+    /*
+     * Connect previous and next nodes
+     * of the node, then place it at the top
+     */
+    node->prev->next = node->next;
+    if (node->next)
+        node->next->prev = node->prev;
+    else
+        dll->tail = node->prev;
+
+    node->prev = NULL;
+    node->next = dll->head;
+    dll->head->prev = node;
+    dll->head = node;
+
+    return SUCCESS;
+}
+
 void print_list(DLL *dll) {
     if (!dll) {
         fprintf(stderr, "Doubly linked list is not valid or is null!\n");
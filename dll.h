@@ -33,6 +33,16 @@ int insert_at_end(DLL *dll, void *data);
 int delete_at_front(DLL *dll);
 int delete_at_end(DLL *dll);
 void print_list(DLL *dll);
+
+/*
+ * Intrusive variants
+ * Node storage is owned by the caller, the list only rewires links
+ */
+int link_at_front(DLL *dll, Node *node);
+int link_at_end(DLL *dll, Node *node);
+int unlink_node(DLL *dll, Node *node);
+int move_to_front(DLL *dll, Node *node);
+
 void free_dll(DLL *dll);
 
 #endif
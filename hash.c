@@ -5,12 +5,100 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
 #include <stdbool.h>
 #include <string.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "hash.h"
 
+/*
+ * Shared tombstone marker, never dereferenced for its fields
+ */
+HashEntry hash_tombstone = { NULL, 0, NULL, 0 };
+
+static int rebuild_table(HashTable *table, size_t new_size);
+static int start_rehash(HashTable *table, size_t new_size);
+static int linear_search(const char *key, size_t key_len, Fnv32_t hval, HashTable *table);
+
+/*
+ * CONTROL BYTES
+ * Tag stored for a full slot, top 7 bits of the hash
+ */
+static inline unsigned char hash_tag(Fnv32_t hval) {
+    return (unsigned char)(hval >> 25);
+}
+
+/*
+ * CONTROL BYTES
+ * Bit i of the result is set when ctrl[i] == byte,
+ * for CTRL_GROUP_WIDTH bytes starting at ctrl
+ */
+static inline unsigned int group_match(const unsigned char *ctrl, unsigned char byte) {
+#if defined(__AVX2__)
+    __m256i group = _mm256_loadu_si256((const __m256i *)ctrl);
+    return (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(group, _mm256_set1_epi8((char)byte)));
+#elif defined(__SSE2__)
+    __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+    return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)byte)));
+#else
+    unsigned int mask = 0;
+    for (unsigned int i = 0; i < CTRL_GROUP_WIDTH; i++) {
+        if (ctrl[i] == byte)
+            mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+/*
+ * CONTROL BYTES
+ * Bit i of the result is set when ctrl[i] is empty or deleted
+ */
+static inline unsigned int group_match_free(const unsigned char *ctrl) {
+#if defined(__AVX2__)
+    return (unsigned int)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i *)ctrl));
+#elif defined(__SSE2__)
+    return (unsigned int)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl));
+#else
+    unsigned int mask = 0;
+    for (unsigned int i = 0; i < CTRL_GROUP_WIDTH; i++) {
+        if (ctrl[i] & 0x80)
+            mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+/*
+ * CONTROL BYTES
+ * Update slot's control byte and its mirrors past the end of the array
+ */
+static inline void set_ctrl_bytes(unsigned char *ctrl, size_t table_size, size_t index, unsigned char byte) {
+    ctrl[index] = byte;
+    for (size_t mirror = index + table_size; mirror < table_size + CTRL_GROUP_WIDTH; mirror += table_size)
+        ctrl[mirror] = byte;
+}
+
+static inline void set_ctrl(HashTable *table, size_t index, unsigned char byte) {
+    set_ctrl_bytes(table->ctrl, table->table_size, index, byte);
+}
+
+static unsigned char *alloc_ctrl(size_t table_size) {
+    unsigned char *ctrl = (unsigned char *)malloc(table_size + CTRL_GROUP_WIDTH);
+    if (ctrl == NULL) {
+        printf("Could not allocate control byte array!\n");
+        return NULL;
+    }
+
+    memset(ctrl, CTRL_EMPTY, table_size + CTRL_GROUP_WIDTH);
+    return ctrl;
+}
+
 /*
  * Hash function
  */
@@ -27,6 +115,108 @@ Fnv32_t fnv_32a_str(const char *str, Fnv32_t hval) {
     return hval;
 }
 
+/*
+ * FNV-1a over a buffer of known length
+ */
+Fnv32_t fnv_32a_buf(const void *buf, size_t len, Fnv32_t hval) {
+    const unsigned char *s = (const unsigned char *)buf;
+    const unsigned char *end = s + len;
+
+    while (s < end) {
+        hval ^= (Fnv32_t)*s++;
+        hval *= FNV_32_PRIME;
+    }
+
+    return hval;
+}
+
+/*
+ * MurmurHash64A by Austin Appleby (public domain)
+ * Consumes the key 8 bytes per multiply
+ */
+u_int64_t murmur_hash64a(const void *key, size_t len, u_int64_t seed) {
+    const u_int64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+
+    u_int64_t h = seed ^ (len * m);
+
+    const unsigned char *data = (const unsigned char *)key;
+    const unsigned char *end = data + (len & ~(size_t)7);
+
+    while (data != end) {
+        u_int64_t k;
+        /* unaligned keys are fine, compilers turn this into a single load */
+        memcpy(&k, data, sizeof(k));
+        data += sizeof(k);
+
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+
+        h ^= k;
+        h *= m;
+    }
+
+    switch (len & 7) {
+    case 7: h ^= (u_int64_t)data[6] << 48; /* fall through */
+    case 6: h ^= (u_int64_t)data[5] << 40; /* fall through */
+    case 5: h ^= (u_int64_t)data[4] << 32; /* fall through */
+    case 4: h ^= (u_int64_t)data[3] << 24; /* fall through */
+    case 3: h ^= (u_int64_t)data[2] << 16; /* fall through */
+    case 2: h ^= (u_int64_t)data[1] << 8; /* fall through */
+    case 1: h ^= (u_int64_t)data[0];
+            h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+
+    return h;
+}
+
+/*
+ * HashFunction: FNV-1a, default of every table
+ */
+Fnv32_t fnv_hash(const void *key, size_t len) {
+    return fnv_32a_buf(key, len, FNV1_32A_INIT);
+}
+
+/*
+ * HashFunction: MurmurHash64A folded to 32 bits
+ */
+Fnv32_t murmur_hash(const void *key, size_t len) {
+    u_int64_t h = murmur_hash64a(key, len, FNV1_32A_INIT);
+    return (Fnv32_t)(h ^ (h >> 32));
+}
+
+/*
+ * Hash of a key with the table's hash function, as stored in HashEntry
+ */
+Fnv32_t hash_key(const HashTable *table, const char *key, size_t key_len) {
+    return table->hash_fn(key, key_len);
+}
+
+/*
+ * Count a search of the current arrays that took "probes" steps
+ */
+static inline void record_probes(HashTable *table, size_t probes) {
+    if (!table->probe_hist)
+        return;
+
+    if (probes > HASH_PROBE_BUCKETS)
+        probes = HASH_PROBE_BUCKETS;
+    __atomic_fetch_add(&table->probe_hist[probes - 1], 1, __ATOMIC_RELAXED);
+}
+
+/*
+ * Entries match on hash first, so the key bytes are
+ * compared only for a likely hit
+ */
+static inline bool entry_matches(const HashEntry *entry, const char *key, size_t key_len, Fnv32_t hval) {
+    return entry->hash == hval && entry->key_len == key_len && memcmp(entry->key, key, key_len) == 0;
+}
+
 /*
  * UTILITY
  * Get index using key and hash function
@@ -37,8 +227,8 @@ int get_index(const char *key, size_t table_size) {
         return IS_NULL;
     }
 
-    Fnv32_t hval = fnv_32a_str(key, FNV1_32A_INIT);
-    int index = (hval % table_size + table_size) % table_size;
+    Fnv32_t hval = fnv_hash(key, strlen(key));
+    int index = (int)(hval & (table_size - 1));
 #ifdef DEBUG
     printf("hash value from '%s': %d, init hval: %d\n", key, hval, FNV1_32A_INIT);
 #endif
@@ -72,7 +262,11 @@ int print_table(HashTable *table) {
 
     printf("\n[Index] --- (key, value)\n");
     for (unsigned int i = 0; i < table->table_size; i++) {
-        if (table->table[i] != NULL) {
+        if (table->probing == PROBE_ROBIN_HOOD && table->table[i] != NULL) {
+            printf("[%d] --- (%s, %p) dist %d\n |\n", i, table->table[i]->key, (void *)table->table[i]->value, table->probe_dist[i] - 1);
+        } else if (table->table[i] == HASH_TOMBSTONE) {
+            printf("[%d] --- <deleted>\n |\n", i);
+        } else if (table->table[i] != NULL) {
             printf("[%d] --- (%s, %p)\n |\n", i, table->table[i]->key, (void *)table->table[i]->value);
         } else {
             printf("[%d]\n |\n", i);
@@ -94,10 +288,10 @@ int resize_on_lf(HashTable *table, bool size_up) {
    
     if (size_up) {
         /*
-         * If load factor approaches ALPHA_MAX
+         * If load factor passes the table's maximum
          * call resize_table and size up
          */
-        if (fabs(ALPHA_MAX - table->load_factor) < 0.1f || (table->load_factor - ALPHA_MAX) >= 0.0f) {
+        if (table->load_factor > table->max_load_factor) {
             if (resize_table(table, RESIZE_UP) != SUCCESS) {
                 return FAILURE;
             }
@@ -105,10 +299,10 @@ int resize_on_lf(HashTable *table, bool size_up) {
         
     } else {
         /*
-         * If load factor approaches ALPHA_MIN
+         * If load factor drops below ALPHA_MIN
          * call resize_table and size down
          */
-        if (fabs(ALPHA_MIN - table->load_factor) < 0.1f || (ALPHA_MIN - table->load_factor) >= 0.0f) {
+        if (table->load_factor < ALPHA_MIN && table->table_size > MIN_TABLE_SIZE) {
             if (resize_table(table, size_up) != SUCCESS)
                 return FAILURE;
         }
@@ -128,66 +322,460 @@ int resize_table(HashTable *table, bool size_up) {
         return IS_NULL;
     }
 
-    if (size_up) {
-        size_t new_size = table->table_size * 2;
-        HashEntry **new_table = (HashEntry **)calloc(new_size, sizeof(HashEntry *));
-        if (new_table == NULL) {
-            printf("Could not allocate new table array!\n");
-            return IS_NULL; 
+    size_t new_size;
+    if (size_up)
+        new_size = table->table_size * 2;
+    else
+        new_size = table->table_size / 2 < MIN_TABLE_SIZE ? table->table_size : table->table_size / 2;
+
+    if (table->incremental_resize && table->count_entry > 0)
+        return start_rehash(table, new_size);
+
+    /*
+     * Probes stop at the first empty slot, so every entry
+     * has to be reinserted from its home slot in the new array.
+     * Home slots come from the stored hashes
+     */
+    return rebuild_table(table, new_size);
+}
+
+/*
+ * Probe from "index" for the first slot that is empty or a tombstone
+ */
+static int find_free_slot(HashTable *table, int index) {
+    for (size_t probes = 0; probes < table->table_size; probes += CTRL_GROUP_WIDTH) {
+        unsigned int mask = group_match_free(table->ctrl + index);
+        if (mask)
+            return (int)((index + __builtin_ctz(mask)) & (table->table_size - 1));
+        index = (index + CTRL_GROUP_WIDTH) & (table->table_size - 1);
+    }
+
+    fprintf(stderr, "Hash table is full!\n");
+    return FAILURE;
+}
+
+/*
+ * Store entry at a free slot found by find_free_slot
+ * Callers account for count_entry
+ */
+static void place_entry(HashTable *table, HashEntry *entry, int index) {
+    if (table->table[index] == HASH_TOMBSTONE)
+        table->count_tombstone--;
+
+    set_ctrl(table, index, hash_tag(entry->hash));
+    table->table[index] = entry;
+}
+
+/*
+ * ROBIN HOOD
+ * Home slot of "hval" in a table of any size: the hash scaled to the
+ * table (fastrange), so Robin Hood tables need not be powers of two
+ */
+static inline size_t robin_hood_home(Fnv32_t hval, size_t table_size) {
+    return (size_t)(((u_int64_t)hval * table_size) >> 32);
+}
+
+static inline size_t robin_hood_next(size_t index, size_t table_size) {
+    return index + 1 == table_size ? 0 : index + 1;
+}
+
+/*
+ * ROBIN HOOD
+ * Place entry at the first slot whose entry is closer to its home slot
+ * than the one being inserted, and carry the displaced entry forward.
+ * Returns index where "entry" itself ended up
+ */
+static int robin_hood_place(HashTable *table, HashEntry *entry) {
+    int index = (int)robin_hood_home(entry->hash, table->table_size);
+
+    int placed = -1;
+    HashEntry *current = entry;
+    unsigned short dist = 0;
+
+    for (size_t probes = 0; probes <= table->table_size; probes++) {
+        if (table->probe_dist[index] == 0) {
+            table->table[index] = current;
+            table->probe_dist[index] = dist + 1;
+            return placed < 0 ? index : placed;
         }
 
         /*
-         * Copy every element from old table array into new one
+         * Resident entry is richer (closer to home), take its slot
          */
-        for (size_t i = 0; i < table->table_size; i++) {
-            if (table->table[i])
-                new_table[i] = table->table[i];
+        if (table->probe_dist[index] - 1 < dist) {
+            HashEntry *displaced = table->table[index];
+            unsigned short displaced_dist = table->probe_dist[index] - 1;
+
+            table->table[index] = current;
+            table->probe_dist[index] = dist + 1;
+            if (placed < 0)
+                placed = index;
+
+            current = displaced;
+            dist = displaced_dist;
         }
 
-        /*
-         * Free old table array
-         */
-        free(table->table);
+        index = (int)robin_hood_next((size_t)index, table->table_size);
+        if (dist == (unsigned short)-2) {
+            fprintf(stderr, "Robin Hood probe distance overflow!\n");
+            return FAILURE;
+        }
+        dist++;
+    }
+
+    fprintf(stderr, "Hash table is full!\n");
+    return FAILURE;
+}
+
+/*
+ * ROBIN HOOD
+ * Search stops at an empty slot or at a slot whose entry
+ * is closer to home than the key would be
+ */
+static int robin_hood_search(const char *key, size_t key_len, Fnv32_t hval, HashTable *table) {
+    int index = (int)robin_hood_home(hval, table->table_size);
+
+    unsigned int dist;
+    for (dist = 0; dist < table->table_size; dist++) {
+        if (table->probe_dist[index] == 0 || table->probe_dist[index] - 1u < dist)
+            break;
+        HashEntry *entry = table->table[index];
+        if (entry_matches(entry, key, key_len, hval)) {
+            record_probes(table, dist + 1);
+            return index;
+        }
+        index = (int)robin_hood_next((size_t)index, table->table_size);
+    }
+
+    record_probes(table, dist + 1);
+    return FAILURE;
+}
+
+/*
+ * ROBIN HOOD
+ * Backward shift deletion: pull every following entry that is
+ * away from its home slot one step back
+ */
+static void robin_hood_remove(HashTable *table, int index) {
+    int next = (int)robin_hood_next((size_t)index, table->table_size);
+
+    while (table->probe_dist[next] > 1) {
+        table->table[index] = table->table[next];
+        table->probe_dist[index] = table->probe_dist[next] - 1;
+        index = next;
+        next = (int)robin_hood_next((size_t)next, table->table_size);
+    }
+
+    table->table[index] = NULL;
+    table->probe_dist[index] = 0;
+}
+
+/*
+ * ROBIN HOOD
+ * Reinsert every entry into new arrays of "new_size" slots
+ */
+static int robin_hood_rebuild(HashTable *table, size_t new_size) {
+    HashEntry **old_table = table->table;
+    unsigned short *old_dist = table->probe_dist;
+    size_t old_size = table->table_size;
+
+    HashEntry **new_table = (HashEntry **)calloc(new_size, sizeof(HashEntry *));
+    unsigned short *new_dist = (unsigned short *)calloc(new_size, sizeof(unsigned short));
+    if (new_table == NULL || new_dist == NULL) {
+        printf("Could not allocate new table array!\n");
+        free(new_table);
+        free(new_dist);
+        return IS_NULL;
+    }
+
+    table->table = new_table;
+    table->probe_dist = new_dist;
+    table->table_size = new_size;
+
+    for (size_t i = 0; i < old_size; i++) {
+        if (old_dist[i] == 0)
+            continue;
+
+        if (robin_hood_place(table, old_table[i]) < 0) {
+            table->table = old_table;
+            table->probe_dist = old_dist;
+            table->table_size = old_size;
+            free(new_table);
+            free(new_dist);
+            return FAILURE;
+        }
+    }
+
+    free(old_table);
+    free(old_dist);
+
+    return table->update_lf(table);
+}
+
+/*
+ * Reinsert every live entry into a new array of "new_size" slots.
+ * Tombstones are not carried over
+ */
+static int rebuild_table(HashTable *table, size_t new_size) {
+    /*
+     * Finish a resize in progress, so every entry is in "table"
+     */
+    if (table->old_table && rehash_step(table, table->old_size) != SUCCESS)
+        return FAILURE;
+
+    if (new_size < table->count_entry) {
+        fprintf(stderr, "New table size is smaller than number of entries!\n");
+        return FAILURE;
+    }
+
+    if (table->probing == PROBE_ROBIN_HOOD)
+        return robin_hood_rebuild(table, new_size);
+
+    HashEntry **old_table = table->table;
+    unsigned char *old_ctrl = table->ctrl;
+    size_t old_size = table->table_size;
+    unsigned int old_tombstones = table->count_tombstone;
+
+    HashEntry **new_table = (HashEntry **)calloc(new_size, sizeof(HashEntry *));
+    unsigned char *new_ctrl = alloc_ctrl(new_size);
+    if (new_table == NULL || new_ctrl == NULL) {
+        printf("Could not allocate new table array!\n");
+        free(new_table);
+        free(new_ctrl);
+        return IS_NULL;
+    }
+
+    table->table = new_table;
+    table->ctrl = new_ctrl;
+    table->table_size = new_size;
+    table->count_tombstone = 0;
+
+    for (size_t i = 0; i < old_size; i++) {
+        if (!IS_LIVE_ENTRY(old_table[i]))
+            continue;
 
         /*
-         * Assign a new table array
+         * Home slot comes from the stored hash, the key is never rehashed
          */
-        table->table_size = new_size;
-        table->table = new_table;
-    } else {
-        size_t new_size = table->table_size == 4 ? table->table_size : table->table_size / 2;
-        HashEntry **new_table = (HashEntry **)calloc(new_size, sizeof(HashEntry *));
-        if (new_table == NULL) {
-            printf("Could not allocate new table array!\n");
-            return IS_NULL; 
+        int index = (int)(old_table[i]->hash & (new_size - 1));
+        if ((index = find_free_slot(table, index)) < 0) {
+            table->table = old_table;
+            table->ctrl = old_ctrl;
+            table->table_size = old_size;
+            table->count_tombstone = old_tombstones;
+            free(new_table);
+            free(new_ctrl);
+            return FAILURE;
         }
+        place_entry(table, old_table[i], index);
+    }
 
-        for (size_t i = 0; i < table->table_size; i++) {
-            if (table->table[i]) {
-                if (i < new_size) {
-                    new_table[i] = table->table[i];
-                } else {
-                    int index = get_index(table->table[i]->key, new_size);
-                    if (index < 0)
-                        return FAILURE;
-                    new_table[index] = table->table[i];
-                } 
-            }
+    free(old_table);
+    free(old_ctrl);
+
+    return table->update_lf(table);
+}
+
+/*
+ * Rebuild the table array in place, dropping every tombstone
+ */
+int purge_tombstones(HashTable *table) {
+    if (table == NULL) {
+        fprintf(stderr, "Table is not valid!\n");
+        return IS_NULL;
+    }
+
+    return rebuild_table(table, table->table_size);
+}
+
+/*
+ * INCREMENTAL RESIZE
+ * Swap in empty arrays of "new_size" slots and keep the current ones
+ * as old arrays to be migrated by rehash_step
+ */
+static int start_rehash(HashTable *table, size_t new_size) {
+    if (table->old_table && rehash_step(table, table->old_size) != SUCCESS)
+        return FAILURE;
+
+    if (new_size < table->count_entry) {
+        fprintf(stderr, "New table size is smaller than number of entries!\n");
+        return FAILURE;
+    }
+
+    HashEntry **new_table = (HashEntry **)calloc(new_size, sizeof(HashEntry *));
+    unsigned char *new_ctrl = NULL;
+    unsigned short *new_dist = NULL;
+    if (table->probing == PROBE_ROBIN_HOOD)
+        new_dist = (unsigned short *)calloc(new_size, sizeof(unsigned short));
+    else
+        new_ctrl = alloc_ctrl(new_size);
+
+    if (new_table == NULL || (new_ctrl == NULL && new_dist == NULL)) {
+        printf("Could not allocate new table array!\n");
+        free(new_table);
+        free(new_ctrl);
+        free(new_dist);
+        return IS_NULL;
+    }
+
+    table->old_table = table->table;
+    table->old_ctrl = table->ctrl;
+    table->old_probe_dist = table->probe_dist;
+    table->old_size = table->table_size;
+    table->rehash_index = 0;
+
+    table->table = new_table;
+    table->ctrl = new_ctrl;
+    table->probe_dist = new_dist;
+    table->table_size = new_size;
+    table->count_tombstone = 0;
+
+    return table->update_lf(table);
+}
+
+/*
+ * INCREMENTAL RESIZE
+ * Insert entry already counted in count_entry into "table"
+ * Returns its index
+ */
+static int insert_counted_entry(HashTable *table, HashEntry *entry) {
+    if (table->probing == PROBE_ROBIN_HOOD)
+        return robin_hood_place(table, entry);
+
+    int index = find_free_slot(table, (int)(entry->hash & (table->table_size - 1)));
+    if (index >= 0)
+        place_entry(table, entry, index);
+
+    return index;
+}
+
+/*
+ * INCREMENTAL RESIZE
+ * Move entry at "old_index" of the old arrays into "table".
+ * The old slot becomes a tombstone. Robin Hood slots keep their
+ * distance, so probe chains of entries not migrated yet stay intact.
+ * Returns the new index, or FAILURE if the slot held no entry
+ */
+static int migrate_slot(HashTable *table, size_t old_index) {
+    HashEntry *entry = table->old_table[old_index];
+    if (!IS_LIVE_ENTRY(entry))
+        return FAILURE;
+
+    table->old_table[old_index] = HASH_TOMBSTONE;
+    if (table->old_ctrl)
+        set_ctrl_bytes(table->old_ctrl, table->old_size, old_index, CTRL_DELETED);
+
+    return insert_counted_entry(table, entry);
+}
+
+/*
+ * INCREMENTAL RESIZE
+ * Search the old arrays, skipping slots already migrated
+ * Returns index in the old arrays
+ */
+static int search_old_table(const char *key, size_t key_len, Fnv32_t hval, HashTable *table) {
+    size_t mask = table->old_size - 1;
+    size_t index;
+
+    if (table->probing == PROBE_ROBIN_HOOD) {
+        index = robin_hood_home(hval, table->old_size);
+        for (unsigned int dist = 0; dist < table->old_size; dist++) {
+            unsigned short slot_dist = table->old_probe_dist[index];
+            if (slot_dist == 0 || slot_dist - 1u < dist)
+                break;
+            HashEntry *entry = table->old_table[index];
+            if (entry != HASH_TOMBSTONE && entry_matches(entry, key, key_len, hval))
+                return (int)index;
+            index = robin_hood_next(index, table->old_size);
         }
+        return FAILURE;
+    }
+
+    index = hval & mask;
+    unsigned char tag = hash_tag(hval);
+    for (size_t probes = 0; probes < table->old_size; probes += CTRL_GROUP_WIDTH) {
+        const unsigned char *group = table->old_ctrl + index;
+        unsigned int match = group_match(group, tag);
 
-        free(table->table);
+        while (match) {
+            size_t slot = (index + __builtin_ctz(match)) & mask;
+            HashEntry *entry = table->old_table[slot];
+            if (entry_matches(entry, key, key_len, hval))
+                return (int)slot;
+            match &= match - 1;
+        }
 
-        table->table_size = new_size;
-        table->table = new_table;
+        if (group_match(group, CTRL_EMPTY))
+            break;
+        index = (index + CTRL_GROUP_WIDTH) & mask;
     }
-    
+
+    return FAILURE;
+}
+
+/*
+ * Migrate up to "slots" slots of an incremental resize in progress
+ */
+int rehash_step(HashTable *table, size_t slots) {
+    if (table == NULL) {
+        fprintf(stderr, "Table is not valid!\n");
+        return IS_NULL;
+    }
+
+    if (table->old_table == NULL)
+        return SUCCESS;
+
+    while (slots-- > 0 && table->rehash_index < table->old_size) {
+        if (IS_LIVE_ENTRY(table->old_table[table->rehash_index])
+                && migrate_slot(table, table->rehash_index) < 0)
+            return FAILURE;
+        table->rehash_index++;
+    }
+
+    if (table->rehash_index == table->old_size) {
+        free(table->old_table);
+        free(table->old_ctrl);
+        free(table->old_probe_dist);
+        table->old_table = NULL;
+        table->old_ctrl = NULL;
+        table->old_probe_dist = NULL;
+        table->old_size = 0;
+        table->rehash_index = 0;
+    }
+
     return SUCCESS;
 }
 
 /*
- * Initialize hash table
+ * Purge tombstones once live entries and tombstones together
+ * leave too few empty slots to terminate probes early
  */
-HashTable *init_hash_table(size_t table_size) {
+static int purge_on_lf(HashTable *table) {
+    if (table->count_tombstone == 0)
+        return SUCCESS;
+
+    float used = (float)(table->count_entry + table->count_tombstone) / (float)table->table_size;
+    if (used < table->max_load_factor)
+        return SUCCESS;
+
+    return purge_tombstones(table);
+}
+
+/*
+ * Smallest power of two >= size
+ */
+static size_t round_up_pow2(size_t size) {
+    size_t table_size = MIN_TABLE_SIZE;
+    while (table_size < size)
+        table_size <<= 1;
+
+    return table_size;
+}
+
+/*
+ * Linear probing table of exactly "table_size" slots
+ */
+static HashTable *alloc_table(size_t table_size) {
     HashTable *hash_table = (HashTable *)calloc(1, sizeof(HashTable));
     if (hash_table == NULL) {
         printf("Could not allocate memory for hash table!\n");
@@ -196,6 +784,7 @@ HashTable *init_hash_table(size_t table_size) {
 
     hash_table->table_size = table_size;
     hash_table->count_entry = 0;
+    hash_table->count_tombstone = 0;
     hash_table->load_factor = (float)hash_table->count_entry / (float)hash_table->table_size;
 
     hash_table->table = (HashEntry **)calloc(table_size, sizeof(HashEntry *));
@@ -204,11 +793,63 @@ HashTable *init_hash_table(size_t table_size) {
         return NULL;
     }
 
+    hash_table->ctrl = alloc_ctrl(table_size);
+    if (hash_table->ctrl == NULL) {
+        free(hash_table->table);
+        free(hash_table);
+        return NULL;
+    }
+
+    hash_table->owns_entries = true;
+    hash_table->max_load_factor = ALPHA_MAX;
+    hash_table->probing = PROBE_LINEAR;
+    hash_table->probe_dist = NULL;
+    hash_table->incremental_resize = false;
+    hash_table->old_table = NULL;
+    hash_table->old_ctrl = NULL;
+    hash_table->old_probe_dist = NULL;
+    hash_table->old_size = 0;
+    hash_table->rehash_index = 0;
     hash_table->update_lf = update_load_factor;
+    hash_table->hash_fn = fnv_hash;
     
     return hash_table;
 }
 
+/*
+ * Initialize hash table
+ */
+HashTable *init_hash_table(size_t table_size) {
+    return alloc_table(round_up_pow2(table_size));
+}
+
+/*
+ * Initialize hash table resolving collisions by Robin Hood probing
+ */
+HashTable *init_robin_hood_table(size_t table_size) {
+    HashTable *hash_table = alloc_table(table_size < MIN_TABLE_SIZE ? MIN_TABLE_SIZE : table_size);
+    if (hash_table == NULL)
+        return NULL;
+
+    hash_table->probe_dist = (unsigned short *)calloc(hash_table->table_size, sizeof(unsigned short));
+    if (hash_table->probe_dist == NULL) {
+        printf("Could not allocate probe distance array!\n");
+        free_table(hash_table);
+        return NULL;
+    }
+
+    /*
+     * Probe distances replace control bytes
+     */
+    free(hash_table->ctrl);
+    hash_table->ctrl = NULL;
+
+    hash_table->probing = PROBE_ROBIN_HOOD;
+    hash_table->max_load_factor = ROBIN_HOOD_ALPHA_MAX;
+
+    return hash_table;
+}
+
 int search_entry(const char *key, HashTable *table) {
     if (table == NULL) {
         fprintf(stderr, "Table is not valid!\n");
@@ -220,24 +861,233 @@ int search_entry(const char *key, HashTable *table) {
         return IS_NULL;
     }
 
-    int index = get_index(key, table->table_size);
-    if (index < 0)
+    size_t key_len = strlen(key);
+    return search_hashed_entry(key, key_len, hash_key(table, key, key_len), table);
+}
+
+/*
+ * Same as search_entry for a key of "key_len" bytes
+ * whose hash_key() is already known
+ */
+int search_hashed_entry(const char *key, size_t key_len, Fnv32_t hval, HashTable *table) {
+    if (table == NULL) {
+        fprintf(stderr, "Table is not valid!\n");
+        return IS_NULL;
+    }
+
+    if (table->old_table && rehash_step(table, HASH_REHASH_STEP) != SUCCESS)
         return FAILURE;
-    int original_index = index;
 
-    do {
-        index = (index + 1) % table->table_size;
-        if (!table->table[index]) 
-            continue;
-        if (strcmp(table->table[index]->key, key) == 0) {
+    int index;
+    if (table->probing == PROBE_ROBIN_HOOD)
+        index = robin_hood_search(key, key_len, hval, table);
+    else
+        index = linear_search(key, key_len, hval, table);
+
+    /*
+     * Entry not migrated yet is moved over on access,
+     * so the returned index always refers to "table"
+     */
+    if (index < 0 && table->old_table) {
+        int old_index = search_old_table(key, key_len, hval, table);
+        if (old_index >= 0)
+            index = migrate_slot(table, old_index);
+    }
+
 #ifdef DEBUG
-            printf("Computed index: %d\n", index);
+    if (index < 0)
+        printf("Key does not exist!\n");
 #endif
-            return index;
-        } 
-    } while (index != original_index);
-       
-    printf("Key does not exist!\n");
+    return index;
+}
+
+HashEntry *lookup_hashed_entry(const char *key, size_t key_len, Fnv32_t hval, HashTable *table) {
+    if (table == NULL) {
+        fprintf(stderr, "Table is not valid!\n");
+        return NULL;
+    }
+
+    int index;
+    if (table->probing == PROBE_ROBIN_HOOD)
+        index = robin_hood_search(key, key_len, hval, table);
+    else
+        index = linear_search(key, key_len, hval, table);
+    if (index >= 0)
+        return table->table[index];
+
+    if (table->old_table) {
+        index = search_old_table(key, key_len, hval, table);
+        if (index >= 0)
+            return table->old_table[index];
+    }
+
+    return NULL;
+}
+
+/*
+ * One in-flight lookup of lookup_hashed_batch
+ * "entry" is the candidate prefetched at "index", NULL while the
+ * probe waits for the slot itself
+ */
+typedef struct BatchProbe {
+    size_t item;
+    size_t index;
+    unsigned int dist;
+    HashEntry *entry;
+} BatchProbe;
+
+static void start_probe(BatchProbe *probe, size_t item, Fnv32_t hval, HashTable *table) {
+    probe->item = item;
+    probe->index = robin_hood_home(hval, table->table_size);
+    probe->dist = 0;
+    probe->entry = NULL;
+    __builtin_prefetch(&table->probe_dist[probe->index]);
+    __builtin_prefetch(&table->table[probe->index]);
+}
+
+/*
+ * Advance probe by one memory access, whose data was prefetched
+ * by the previous step. Returns true once results[item] is set
+ */
+static bool step_probe(BatchProbe *probe, const char *key, size_t key_len, Fnv32_t hval,
+                       HashTable *table, HashEntry **results) {
+    if (probe->entry) {
+        if (entry_matches(probe->entry, key, key_len, hval)) {
+            record_probes(table, probe->dist + 1);
+            results[probe->item] = probe->entry;
+            return true;
+        }
+
+        probe->entry = NULL;
+        probe->index = robin_hood_next(probe->index, table->table_size);
+        probe->dist++;
+        __builtin_prefetch(&table->probe_dist[probe->index]);
+        __builtin_prefetch(&table->table[probe->index]);
+        return false;
+    }
+
+    unsigned short dist = table->probe_dist[probe->index];
+    if (dist == 0 || dist - 1u < probe->dist || probe->dist >= table->table_size) {
+        record_probes(table, probe->dist + 1);
+        results[probe->item] = NULL;
+        if (table->old_table) {
+            int index = search_old_table(key, key_len, hval, table);
+            if (index >= 0)
+                results[probe->item] = table->old_table[index];
+        }
+        return true;
+    }
+
+    probe->entry = table->table[probe->index];
+    __builtin_prefetch(probe->entry);
+    return false;
+}
+
+void lookup_hashed_batch(const char *const *keys, const size_t *key_lens, const Fnv32_t *hvals,
+                         size_t count, HashTable *table, HashEntry **results) {
+    if (table == NULL || keys == NULL || key_lens == NULL || hvals == NULL || results == NULL) {
+        fprintf(stderr, "Table or batch is not valid!\n");
+        return;
+    }
+
+    /*
+     * Linear probes scan whole control groups and rarely take a second
+     * step: the home groups of a window of keys are prefetched together,
+     * then scanned one key at a time
+     */
+    if (table->probing != PROBE_ROBIN_HOOD) {
+        for (size_t start = 0; start < count; start += HASH_BATCH_WIDTH) {
+            size_t end = count - start < HASH_BATCH_WIDTH ? count : start + HASH_BATCH_WIDTH;
+            for (size_t i = start; i < end; i++)
+                prefetch_hashed_slot(hvals[i], table);
+            for (size_t i = start; i < end; i++)
+                results[i] = lookup_hashed_entry(keys[i], key_lens[i], hvals[i], table);
+        }
+        return;
+    }
+
+    /*
+     * Finished probes are replaced by the next key, the last
+     * ones are dropped from the round until none is left
+     */
+    BatchProbe probes[HASH_BATCH_WIDTH];
+    size_t active = 0, next = 0;
+    while (active < HASH_BATCH_WIDTH && next < count) {
+        start_probe(&probes[active++], next, hvals[next], table);
+        next++;
+    }
+
+    size_t slot = 0;
+    while (active > 0) {
+        BatchProbe *probe = &probes[slot];
+        size_t item = probe->item;
+        if (step_probe(probe, keys[item], key_lens[item], hvals[item], table, results)) {
+            if (next < count) {
+                start_probe(probe, next, hvals[next], table);
+                next++;
+            } else {
+                *probe = probes[--active];
+                if (slot >= active)
+                    slot = 0;
+                continue;
+            }
+        }
+
+        if (++slot >= active)
+            slot = 0;
+    }
+}
+
+void prefetch_hashed_slot(Fnv32_t hval, const HashTable *table) {
+    size_t index;
+    if (table->probing == PROBE_ROBIN_HOOD) {
+        index = robin_hood_home(hval, table->table_size);
+        __builtin_prefetch(&table->probe_dist[index]);
+    } else {
+        index = hval & (table->table_size - 1);
+        __builtin_prefetch(&table->ctrl[index]);
+    }
+    __builtin_prefetch(&table->table[index]);
+}
+
+/*
+ * Scan the linear probe chain of "table" using control bytes
+ */
+static int linear_search(const char *key, size_t key_len, Fnv32_t hval, HashTable *table) {
+    size_t mask = table->table_size - 1;
+    unsigned char tag = hash_tag(hval);
+    size_t index = hval & mask;
+
+    /*
+     * Scan the probe chain a group of control bytes at a time.
+     * Entries are only touched when their tag matches, and a group
+     * with an empty slot ends the chain
+     */
+    size_t groups = 0;
+    for (size_t probes = 0; probes < table->table_size; probes += CTRL_GROUP_WIDTH) {
+        const unsigned char *group = table->ctrl + index;
+        unsigned int match = group_match(group, tag);
+        groups++;
+
+        while (match) {
+            size_t slot = (index + __builtin_ctz(match)) & mask;
+            HashEntry *entry = table->table[slot];
+            if (entry_matches(entry, key, key_len, hval)) {
+#ifdef DEBUG
+                printf("Computed index: %zu\n", slot);
+#endif
+                record_probes(table, groups);
+                return (int)slot;
+            }
+            match &= match - 1;
+        }
+
+        if (group_match(group, CTRL_EMPTY))
+            break;
+        index = (index + CTRL_GROUP_WIDTH) & mask;
+    }
+
+    record_probes(table, groups);
     return FAILURE;
 }
 
@@ -260,14 +1110,14 @@ int handle_collision(const char *key, void *value, HashTable *table, int index,
         return IS_NULL;
     }
 
-    while (table->table[index] != NULL) {
-        index = (index + 1) % table->table_size;
-    }
+    index = find_free_slot(table, index);
+    if (index < 0)
+        return FAILURE;
 
     if (create_hash_entry(key, value, table, index, auto_resize) != SUCCESS) 
         return FAILURE;
     
-    return index;
+    return search_entry(key, table);
 }
 
 /*
@@ -289,6 +1139,11 @@ int create_hash_entry(const char *key, void *value, HashTable *table, int index,
         return IS_NULL;
     }
 
+    if (table->probing != PROBE_LINEAR) {
+        fprintf(stderr, "Entries can only be created at an index with linear probing!\n");
+        return FAILURE;
+    }
+
     HashEntry *entry = (HashEntry *)calloc(1, sizeof(HashEntry));
     if (!entry) {
         printf("Could not allocate hash entry!\n");
@@ -296,8 +1151,10 @@ int create_hash_entry(const char *key, void *value, HashTable *table, int index,
     }
 
     entry->key = key;
+    entry->key_len = strlen(key);
     entry->value = value; 
-    table->table[index] = entry;
+    entry->hash = hash_key(table, key, entry->key_len);
+    place_entry(table, entry, index);
     table->count_entry++;
 #ifdef HASH_DEBUG
     printf("Load factor: %.7f\n", table->load_factor);
@@ -306,6 +1163,9 @@ int create_hash_entry(const char *key, void *value, HashTable *table, int index,
     if (table->update_lf(table) != SUCCESS)
         return FAILURE;
 
+    if (purge_on_lf(table) != SUCCESS)
+        return FAILURE;
+
     /*
      * Handle resizing automatically, if specified
      */
@@ -337,18 +1197,44 @@ int add_hash_entry(const char *key, void *value, HashTable *table, bool auto_res
         return IS_NULL;
     }
 
-    int index = get_index(key, table->table_size);
-    if (index < 0) {
-        return FAILURE;
+    if (table->probing == PROBE_ROBIN_HOOD) {
+        int index = search_entry(key, table);
+        if (index >= 0) {
+            table->table[index]->value = value;
+            return index;
+        }
+
+        HashEntry *entry = (HashEntry *)calloc(1, sizeof(HashEntry));
+        if (!entry) {
+            printf("Could not allocate hash entry!\n");
+            return IS_NULL;
+        }
+
+        entry->key = key;
+        entry->key_len = strlen(key);
+        entry->value = value;
+        entry->hash = hash_key(table, key, entry->key_len);
+        index = link_hash_entry(entry, table, auto_resize);
+        if (index < 0)
+            free(entry);
+
+        return index;
     }
+
+    int index = (int)(hash_key(table, key, strlen(key)) & (table->table_size - 1));
     /*
      * If entry is empty we can fill it with
      * new (key, value) pair, otherwise look for next
-     * empty slot by linear probing
+     * empty slot by linear probing.
+     * While resizing the key may still sit in the old array
      */
-    if (table->table[index] == NULL) {
+    if (table->table[index] == NULL && table->old_table == NULL) {
         if (create_hash_entry(key, value, table, index, auto_resize) != SUCCESS)
             return FAILURE;
+        /*
+         * Purging or resizing may have moved the entry
+         */
+        index = search_entry(key, table);
     } else {
 #ifdef DEBUG
         printf("Load factor: %.7f\n", table->load_factor);
@@ -365,11 +1251,9 @@ int add_hash_entry(const char *key, void *value, HashTable *table, bool auto_res
 #ifdef DEBUG
             printf("KEYS ARE THE SAME. REPLACING\n");
 #endif
-            if (create_hash_entry(key, value, table, search_index, auto_resize) != SUCCESS) {
-                return FAILURE;
-            }
+            table->table[search_index]->value = value;
 
-            return index;
+            return search_index;
         } 
         /*
          * Handle collisions by linear probing
@@ -399,18 +1283,146 @@ int remove_hash_entry(const char *key, HashTable *table, bool auto_resize) {
     }
 
     int index = search_entry(key, table);
+    if (index < 0)
+        return FAILURE;
 
-    if (index < 0) {
+    HashEntry *entry = table->table[index];
+    if (unlink_hash_entry(table, index, auto_resize) != SUCCESS)
+        return FAILURE;
+
+    if (table->owns_entries)
+        free(entry);
+
+    return SUCCESS;
+}
+
+/*
+ * Links caller-owned entry into the table array by linear probing
+ * Returns index on success
+ */
+int link_hash_entry(HashEntry *entry, HashTable *table, bool auto_resize) {
+    if (table == NULL) {
+        fprintf(stderr, "Table is not valid!\n");
+        return IS_NULL;
+    }
+
+    if (entry == NULL || entry->key == NULL) {
+        fprintf(stderr, "The entry provided is invalid or NULL!\n");
+        return IS_NULL;
+    }
+
+    if (table->old_table && rehash_step(table, HASH_REHASH_STEP) != SUCCESS)
         return FAILURE;
-    } else {
-        free(table->table[index]);
-        table->table[index] = NULL;
-        table->count_entry--;
 
-        if (table->update_lf(table) != SUCCESS)
+    int index = insert_counted_entry(table, entry);
+    if (index < 0)
+        return FAILURE;
+    table->count_entry++;
+
+    if (table->update_lf(table) != SUCCESS)
+        return FAILURE;
+
+    HashEntry **array = table->table;
+    if (purge_on_lf(table) != SUCCESS)
+        return FAILURE;
+
+    if (auto_resize) {
+        if (resize_on_lf(table, RESIZE_UP) != SUCCESS)
             return FAILURE;
     }
-    
+
+    /*
+     * Purging or resizing may have moved the entry
+     */
+    if (table->table != array)
+        return search_hashed_entry(entry->key, entry->key_len, entry->hash, table);
+
+    return index;
+}
+
+int reserve_hash_table(HashTable *table, size_t count) {
+    if (table == NULL) {
+        fprintf(stderr, "Table is not valid!\n");
+        return IS_NULL;
+    }
+
+    if (table->probing != PROBE_ROBIN_HOOD || table->old_table || table->count_entry > 0)
+        return FAILURE;
+
+    if ((double)count <= table->max_load_factor * table->table_size)
+        return SUCCESS;
+
+    return robin_hood_rebuild(table, (size_t)(count / table->max_load_factor) + 1);
+}
+
+int place_hash_entry(HashEntry *entry, HashTable *table) {
+    if (table == NULL) {
+        fprintf(stderr, "Table is not valid!\n");
+        return IS_NULL;
+    }
+
+    if (entry == NULL || entry->key == NULL) {
+        fprintf(stderr, "The entry provided is invalid or NULL!\n");
+        return IS_NULL;
+    }
+
+    if (table->probing != PROBE_ROBIN_HOOD || table->old_table
+            || (double)(table->count_entry + 1) > table->max_load_factor * table->table_size)
+        return FAILURE;
+
+    int index = robin_hood_place(table, entry);
+    if (index < 0)
+        return FAILURE;
+    table->count_entry++;
+    table->update_lf(table);
+
+    return index;
+}
+
+/*
+ * Unlinks entry at index without freeing it
+ * and resizes the table (if specified) based on load factor
+ */
+int unlink_hash_entry(HashTable *table, int index, bool auto_resize) {
+    if (table == NULL) {
+        fprintf(stderr, "Table is not valid!\n");
+        return IS_NULL;
+    }
+
+    if (index < 0 || (size_t)index >= table->table_size || !IS_LIVE_ENTRY(table->table[index])) {
+        fprintf(stderr, "No entry at index %d!\n", index);
+        return FAILURE;
+    }
+
+    table->count_entry--;
+
+    if (table->probing == PROBE_ROBIN_HOOD) {
+        robin_hood_remove(table, index);
+    } else {
+        table->table[index] = HASH_TOMBSTONE;
+        set_ctrl(table, index, CTRL_DELETED);
+        table->count_tombstone++;
+    }
+
+    /*
+     * A tombstone followed by an empty slot ends no probe chain,
+     * so turn it and the tombstones right before it back into empty slots
+     */
+    if (table->count_tombstone > 0 && table->table[(index + 1) & (table->table_size - 1)] == NULL) {
+        while (table->table[index] == HASH_TOMBSTONE) {
+            table->table[index] = NULL;
+            set_ctrl(table, index, CTRL_EMPTY);
+            table->count_tombstone--;
+            index = (index == 0 ? (int)table->table_size : index) - 1;
+        }
+    }
+
+    if (table->update_lf(table) != SUCCESS)
+        return FAILURE;
+
+    if (table->old_table && rehash_step(table, HASH_REHASH_STEP) != SUCCESS)
+        return FAILURE;
+
     /*
      * Handle resizing automatically, if specified
      */
@@ -431,12 +1443,24 @@ void free_table(HashTable *table) {
         return;
     }
 
-    for (unsigned int i = 0; i < table->table_size; i++) {
-        free(table->table[i]);
-        table->table[i] = NULL;
+    if (table->owns_entries) {
+        for (unsigned int i = 0; i < table->table_size; i++) {
+            if (IS_LIVE_ENTRY(table->table[i]))
+                free(table->table[i]);
+            table->table[i] = NULL;
+        }
+        for (size_t i = 0; table->old_table && i < table->old_size; i++) {
+            if (IS_LIVE_ENTRY(table->old_table[i]))
+                free(table->old_table[i]);
+        }
     }
 
     free(table->table);
+    free(table->ctrl);
+    free(table->probe_dist);
+    free(table->old_table);
+    free(table->old_ctrl);
+    free(table->old_probe_dist);
     free(table);
 
     table = NULL;
@@ -37,24 +37,157 @@ typedef u_int32_t Fnv32_t;
 #define ALPHA_MAX 0.72
 #define ALPHA_MIN 0.18
 
+/*
+ * Robin Hood probing keeps probe lengths short and even,
+ * so the table can run at a much higher load
+ */
+#define ROBIN_HOOD_ALPHA_MAX 0.9
+
+/*
+ * Number of old slots migrated by every operation
+ * while an incremental resize is in progress
+ */
+#define HASH_REHASH_STEP 64
+
+/*
+ * Lookups in flight at once in lookup_hashed_batch
+ */
+#ifndef HASH_BATCH_WIDTH
+#define HASH_BATCH_WIDTH 16
+#endif
+
+/*
+ * Buckets of the optional probe length histogram
+ */
+#define HASH_PROBE_BUCKETS 16
+
+/*
+ * PROBE_LINEAR control bytes, one per slot
+ * A full slot holds the top 7 bits of its key's hash (high bit clear),
+ * empty and deleted slots have the high bit set
+ */
+#define CTRL_EMPTY ((unsigned char)0x80)
+#define CTRL_DELETED ((unsigned char)0xFE)
+
+/*
+ * Number of control bytes compared at once
+ */
+#if defined(__AVX2__)
+#define CTRL_GROUP_WIDTH 32
+#else
+#define CTRL_GROUP_WIDTH 16
+#endif
+
+/*
+ * Collision resolution strategy of the table
+ */
+typedef enum HashProbing {
+    PROBE_LINEAR,
+    PROBE_ROBIN_HOOD
+} HashProbing;
+
 /*
  * Type of element in the array
  */
 typedef struct HashEntry {
     const char *key;
+    size_t key_len;
     void *value;
+
+    /*
+     * Full hash of the key, computed once on insert.
+     * Compared before the key itself and reused on every rehash
+     */
+    Fnv32_t hash;
 } HashEntry;
 
+/*
+ * Marker left in a slot whose entry was removed.
+ * Probes continue past a tombstone and stop at the first NULL slot,
+ * inserts may reuse it
+ */
+extern HashEntry hash_tombstone;
+#define HASH_TOMBSTONE (&hash_tombstone)
+#define IS_LIVE_ENTRY(entry) ((entry) != NULL && (entry) != HASH_TOMBSTONE)
+
+/*
+ * Linear probing tables are always a power of two, so the home slot
+ * of a hash is hash & (table_size - 1). Robin Hood tables keep the size
+ * they are given and scale the hash instead: (hash * table_size) >> 32
+ */
+#define MIN_TABLE_SIZE 4
+
+/*
+ * Hash function over "len" bytes of "key".
+ * The result is the 32 bit hash stored in HashEntry
+ */
+typedef Fnv32_t (*HashFunction)(const void *key, size_t len);
+
 typedef struct HashTable {
     size_t table_size;
     unsigned int count_entry;
+    unsigned int count_tombstone;
     float load_factor;
+    float max_load_factor;
     HashEntry **table;
 
+    /*
+     * PROBE_LINEAR only
+     * table_size control bytes followed by CTRL_GROUP_WIDTH bytes
+     * mirroring the start of the array, so a group can be loaded
+     * from any slot without wrapping
+     */
+    unsigned char *ctrl;
+
+    /*
+     * PROBE_ROBIN_HOOD only
+     * Distance of each slot's entry from its home slot plus one,
+     * 0 marks an empty slot
+     */
+    HashProbing probing;
+    unsigned short *probe_dist;
+
+    /*
+     * Incremental resizing
+     * When enabled, resize_table only allocates the new arrays and
+     * every following operation migrates HASH_REHASH_STEP slots of the
+     * old arrays. While old_table is not NULL lookups check both arrays.
+     * Indexes returned by the API always refer to "table"
+     */
+    bool incremental_resize;
+    HashEntry **old_table;
+    unsigned char *old_ctrl;
+    unsigned short *old_probe_dist;
+    size_t old_size;
+    size_t rehash_index;
+
+    /*
+     * Entries allocated by create_hash_entry are owned by the table.
+     * Intrusive users (see link_hash_entry) embed HashEntry in their
+     * own storage and clear this flag
+     */
+    bool owns_entries;
+
     /*
      * Function pointer to update load factor
      */
     int (*update_lf)(struct HashTable *);
+
+    /*
+     * Function pointer to hash keys, fnv_hash by default.
+     * Must be set before the first entry is added
+     */
+    HashFunction hash_fn;
+
+    /*
+     * Optional probe length histogram of HASH_PROBE_BUCKETS counters,
+     * NULL by default. probe_hist[n] counts searches that took n + 1
+     * steps (slots for Robin Hood, control groups for linear probing),
+     * the last bucket every longer one. Searches of the old arrays during
+     * a resize are not counted. Updated with relaxed atomics, so
+     * concurrent read-only lookups may share it
+     */
+    u_int64_t *probe_hist;
 } HashTable;
 
 /*
@@ -62,9 +195,33 @@ typedef struct HashTable {
  */
 Fnv32_t fnv_32a_str(const char *str, Fnv32_t hval);
 
+/*
+ * FNV-1a over a buffer of known length
+ */
+Fnv32_t fnv_32a_buf(const void *buf, size_t len, Fnv32_t hval);
+
+/*
+ * MurmurHash64A, 64 bit hash reading the key a word at a time
+ */
+u_int64_t murmur_hash64a(const void *key, size_t len, u_int64_t seed);
+
+/*
+ * HashFunction implementations
+ * fnv_hash: FNV-1a, byte at a time, default of every table
+ * murmur_hash: MurmurHash64A folded to 32 bits, much faster on long keys
+ */
+Fnv32_t fnv_hash(const void *key, size_t len);
+Fnv32_t murmur_hash(const void *key, size_t len);
+
+/*
+ * Hash of a key with the table's hash function, as stored in HashEntry
+ */
+Fnv32_t hash_key(const HashTable *table, const char *key, size_t key_len);
+
 /*
  * UTILITY
- * Get index using key and hash function
+ * Get index using key and hash function.
+ * "table_size" must be a power of two
  */
 int get_index(const char *key, size_t table_size);
 
@@ -93,24 +250,76 @@ int resize_on_lf(HashTable *table, bool size_up);
  */
 int resize_table(HashTable *table, bool size_up);
 
+/*
+ * Rebuild the table array in place, dropping every tombstone
+ */
+int purge_tombstones(HashTable *table);
+
+/*
+ * Migrate up to "slots" slots of an incremental resize in progress.
+ * Frees the old arrays once every slot has been moved
+ */
+int rehash_step(HashTable *table, size_t slots);
+
 /*
  * Initialize hash table
+ * "table_size" is rounded up to a power of two
  */
 HashTable *init_hash_table(size_t table_size);
 
+/*
+ * Initialize hash table resolving collisions by Robin Hood probing.
+ * Lookups stop as soon as they pass an entry closer to its home slot,
+ * removals shift the following entries back instead of leaving tombstones.
+ * "table_size" is used as is (at least MIN_TABLE_SIZE), not rounded up
+ */
+HashTable *init_robin_hood_table(size_t table_size);
+
 /*
  * Search entry by the key.
+ * Probing stops at the first empty slot.
  * Returns index in the hash table on success
  */
 int search_entry(const char *key, HashTable *table);
 
+/*
+ * Same as search_entry for a key of "key_len" bytes
+ * whose hash_key() is already known
+ */
+int search_hashed_entry(const char *key, size_t key_len, Fnv32_t hval, HashTable *table);
+
+/*
+ * Read-only lookup: never migrates entries or steps a pending resize,
+ * so any number of readers may call it while no writer runs.
+ * Returns the entry, which may still sit in the old arrays, or NULL
+ */
+HashEntry *lookup_hashed_entry(const char *key, size_t key_len, Fnv32_t hval, HashTable *table);
+
+/*
+ * lookup_hashed_entry for "count" keys, results[i] for keys[i].
+ * On Robin Hood tables up to HASH_BATCH_WIDTH probes are interleaved:
+ * each probe prefetches the slot or entry it needs next and yields to
+ * the following one, so their cache misses overlap instead of adding up.
+ * Linear tables prefetch the home control groups of HASH_BATCH_WIDTH
+ * keys at a time, then scan them key by key
+ */
+void lookup_hashed_batch(const char *const *keys, const size_t *key_lens, const Fnv32_t *hvals,
+                         size_t count, HashTable *table, HashEntry **results);
+
+/*
+ * Start loading the home slot of "hval" into cache ahead of a lookup or insert
+ */
+void prefetch_hashed_slot(Fnv32_t hval, const HashTable *table);
+
 /*
  * Handle collision by linear probing
+ * PROBE_LINEAR only
  */
 int handle_collision(const char *key, void *value, HashTable *table, int index, bool auto_resize);
 
 /*
  * Creates entry (key, value) pair to the table array at computed index
+ * PROBE_LINEAR only
  */
 int create_hash_entry(const char *key, void *value, HashTable *table, int index, bool auto_resize);
 
@@ -126,6 +335,34 @@ int add_hash_entry(const char *key, void *value, HashTable *table, bool auto_res
  */
 int remove_hash_entry(const char *key, HashTable *table, bool auto_resize);
 
+/*
+ * Links caller-owned entry into the table array.
+ * entry->key_len and entry->hash must already be set,
+ * the latter to hash_key() of the key.
+ * Entry must stay valid until it is unlinked.
+ * Returns index on success
+ */
+int link_hash_entry(HashEntry *entry, HashTable *table, bool auto_resize);
+
+/*
+ * Bulk loading, ROBIN HOOD only
+ * reserve_hash_table grows an empty table to hold "count" entries
+ * under its max load factor. place_hash_entry then puts an entry of
+ * a key not in the table straight into its slot: no rehash step,
+ * purge or resize, and no search first. It returns FAILURE without a
+ * message when the table is not Robin Hood, is resizing or is full,
+ * in which case link_hash_entry still works.
+ * Returns index on success
+ */
+int reserve_hash_table(HashTable *table, size_t count);
+int place_hash_entry(HashEntry *entry, HashTable *table);
+
+/*
+ * Unlinks entry at index without freeing it.
+ * The slot becomes a tombstone unless it ends a probe chain
+ */
+int unlink_hash_entry(HashTable *table, int index, bool auto_resize);
+
 /*
  * Free the hash table at the end
  */
@@ -1,5 +1,47 @@
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
 #include "lru_cache.h"
 
+static int remove_entry(LRUCache *lru, LRUEntry *entry, RemovalReason reason);
+
+/*
+ * Calls seen by this thread, picks the ones latency sampling times
+ */
+static _Thread_local unsigned int sample_tick;
+
+static bool sample_latency(const LRUCache *lru) {
+    return lru->latency_sample && ++sample_tick % lru->latency_sample == 0;
+}
+
+/*
+ * Count lookups in the calling thread's stripe
+ */
+static void count_lookups(LRUCache *lru, u_int64_t hits, u_int64_t misses) {
+    StatsStripe *stripe = lookup_stripe(lru->lookups);
+    if (hits)
+        STATS_ADD(stripe->hits, hits);
+    if (misses)
+        STATS_ADD(stripe->misses, misses);
+}
+
+static u_int64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u_int64_t)ts.tv_sec * 1000000000u + (u_int64_t)ts.tv_nsec;
+}
+
+/*
+ * Default clock for TTLs
+ */
+static u_int64_t monotonic_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (u_int64_t)now.tv_sec * 1000 + (u_int64_t)now.tv_nsec / 1000000;
+}
+
 void print_list_pair(DLL *dll) {
     if (!dll) {
         fprintf(stderr, "Doubly linked list is not valid or is null!\n");
@@ -11,11 +53,11 @@ void print_list_pair(DLL *dll) {
     printf("HEAD ");
     while (current) {
         if (current == dll->tail) {
-            printf("(%s) ", (char *)((Pair *)current->data)->key);
+            printf("(%s) ", ((LRUEntry *)current->data)->hash_entry.key);
             current = current->next;
             continue;
         }
-        printf("(%s) <--> ",  (char *)((Pair *)current->data)->key);
+        printf("(%s) <--> ", ((LRUEntry *)current->data)->hash_entry.key);
         current = current->next;
     }
 
@@ -23,93 +65,630 @@ void print_list_pair(DLL *dll) {
 }
 
 LRUCache *init_lru_cache(size_t capacity) {
-    LRUCache *lru = (LRUCache *)calloc(1, sizeof(LRUCache));
-    if (!lru) {
-        fprintf(stderr, "Could not allocate memory for LRUCache struct!\n");
+    return init_policy_cache(capacity, &lru_policy);
+}
+
+LRUCache *init_policy_cache(size_t capacity, const EvictionPolicy *policy) {
+    if (!policy) {
+        fprintf(stderr, "Eviction policy is not valid or is null!\n");
         return NULL;
     }
-  
+
     if (capacity <= 0) {
         fprintf(stderr, "Capacity cannot be less than 1!\n");
         return NULL;
     }
+
+    LRUCache *lru = (LRUCache *)calloc(1, sizeof(LRUCache));
+    if (!lru) {
+        fprintf(stderr, "Could not allocate memory for LRUCache struct!\n");
+        return NULL;
+    }
+  
     lru->capacity = capacity;
-    lru->hash_table = init_hash_table(capacity * 2);
+    lru->clock = monotonic_ms;
+    /*
+     * Robin Hood probing stays fast close to full load, so the table
+     * only needs to keep capacity under ROBIN_HOOD_ALPHA_MAX: about
+     * 1.11x capacity slots, used as is since Robin Hood tables
+     * need not be a power of two
+     */
+    lru->hash_table = init_robin_hood_table(capacity + capacity / 9 + 1);
     lru->dll = init_linked_list();
-    if (!lru->dll || !lru->hash_table)
+    /*
+     * Every entry the cache will ever hold is preallocated here,
+     * put/evict only recycle slab objects
+     */
+    lru->entries = init_slab_pool(sizeof(LRUEntry), capacity);
+    lru->keys = init_key_arena(64);
+    lru->lookups = init_lookup_stats();
+    if (!lru->dll || !lru->hash_table || !lru->entries || !lru->keys || !lru->lookups) {
+        free_lru(lru);
+        return NULL;
+    }
+
+    /*
+     * Entries are embedded in LRUEntry, the table must not free them.
+     * If the table ever has to resize, spread the work over operations
+     */
+    lru->hash_table->owns_entries = false;
+    lru->hash_table->incremental_resize = true;
+
+    lru->policy = policy;
+    if (policy->init && policy->init(lru) != SUCCESS) {
+        fprintf(stderr, "Could not initialize %s eviction policy!\n", policy->name);
+        free_lru(lru);
         return NULL;
+    }
     
     return lru;
 
 }
 
+LRUCache *init_weighted_cache(size_t capacity, size_t max_weight, const EvictionPolicy *policy, Weigher weigher) {
+    if (max_weight == 0) {
+        fprintf(stderr, "Weight budget cannot be less than 1!\n");
+        return NULL;
+    }
+
+    LRUCache *lru = init_policy_cache(capacity, policy);
+    if (!lru)
+        return NULL;
+
+    lru->max_weight = max_weight;
+    lru->weigher = weigher;
+
+    return lru;
+}
+
+LRUCache *init_clock_cache(size_t capacity) {
+    return init_policy_cache(capacity, &clock_policy);
+}
+
+LRUCache *init_buffered_cache(size_t capacity) {
+    LRUCache *lru = init_lru_cache(capacity);
+    if (!lru)
+        return NULL;
+
+    lru->reads = init_read_buffer();
+    if (!lru->reads) {
+        free_lru(lru);
+        return NULL;
+    }
+
+    return lru;
+}
+
+static void promote_read(void *item, void *arg) {
+    LRUCache *lru = (LRUCache *)arg;
+    lru->policy->on_hit(lru, (LRUEntry *)item);
+}
+
+size_t drain_reads(LRUCache *lru) {
+    if (!lru || !lru->reads)
+        return 0;
+
+    return drain_read_buffer(lru->reads, promote_read, lru);
+}
+
+/*
+ * Record a hit with the policy, or leave it to the next drain
+ * when hits are buffered. A full stripe is drained on the spot unless
+ * lookups share a lock, then the hit is dropped and the lock holder drains
+ */
+static int touch_entry(LRUCache *lru, LRUEntry *entry) {
+    if (entry->value_ref.segment)
+        touch_value(lru->values, entry->value_ref);
+
+    if (lru->reads) {
+        if (record_read(lru->reads, entry) != SUCCESS && !lru->shared_reads
+                && read_buffer_full(lru->reads)) {
+            drain_reads(lru);
+            record_read(lru->reads, entry);
+        }
+        return SUCCESS;
+    }
+
+    return lru->policy->on_hit(lru, entry);
+}
+
+/*
+ * Lookups of buffered and CLOCK caches may run under a shared lock,
+ * they must not remove entries
+ */
+static bool exclusive_lookups(const LRUCache *lru) {
+    return !lru->reads && !lru->policy->concurrent_hits;
+}
+
+static bool entry_expired(LRUCache *lru, const LRUEntry *entry) {
+    return entry->timer && entry->timer->expires <= lru->clock();
+}
+
+/*
+ * Expired entries miss. Where lookups are exclusive they are removed
+ * on the spot, otherwise they wait for the timer wheel
+ */
+static bool expire_on_lookup(LRUCache *lru, LRUEntry *entry) {
+    if (!entry_expired(lru, entry))
+        return false;
+
+    if (exclusive_lookups(lru) && remove_entry(lru, entry, REMOVAL_EXPIRED) == SUCCESS)
+        STATS_ADD(lru->stats.expirations, 1);
+
+    return true;
+}
+
+static void expire_timer(Timer *timer, void *arg) {
+    LRUCache *lru = (LRUCache *)arg;
+    if (remove_entry(lru, (LRUEntry *)timer->node.data, REMOVAL_EXPIRED) == SUCCESS)
+        STATS_ADD(lru->stats.expirations, 1);
+}
+
+size_t expire_entries(LRUCache *lru, size_t max_steps) {
+    if (!lru) {
+        fprintf(stderr, "LRU is not valid or is null!\n");
+        return 0;
+    }
+
+    if (!lru->timers)
+        return 0;
+
+    /*
+     * Buffered hits must not outlive the entries they point to
+     */
+    if (lru->reads)
+        drain_reads(lru);
+
+    return advance_timer_wheel(lru->timers, lru->clock(), max_steps, expire_timer, lru);
+}
+
 int get(LRUCache *lru, const char *key) {
+    if (!key) {
+        fprintf(stderr, "The key provided is invalid or NULL!\n");
+        return IS_NULL;
+    }
+
+    return get_bytes(lru, key, strlen(key));
+}
+
+int get_bytes(LRUCache *lru, const void *key, size_t key_len) {
     if (!lru) {
         fprintf(stderr, "LRU is not valid or is null!\n");
         return IS_NULL;
     }
 
-    if (!key) {
+    if (!key && key_len > 0) {
         fprintf(stderr, "The key provided is invalid or NULL!\n");
         return IS_NULL;
     }
 
-    int index = search_entry(key, lru->hash_table);
+    if (lru->timers && exclusive_lookups(lru))
+        expire_entries(lru, LRU_EXPIRE_STEPS);
+
+    Fnv32_t hval = hash_key(lru->hash_table, key, key_len);
+    if (lru->mrc)
+        mrc_access(lru->mrc, hval);
+
+    int index = search_hashed_entry(key, key_len, hval, lru->hash_table);
     if (index < 0) {
+#ifdef DEBUG
         fprintf(stderr, "LRU: Could not find entry in the hash table!\n");
+#endif
+        count_lookups(lru, 0, 1);
         return FAILURE;
     }
 
     /*
-     * Hash table contains key and value which is a node in linked list
-     * that contains our value
+     * Hash table entry is embedded in the cache entry
+     * that also holds the list node
      */
-    Node *accessed_node = (Node *)lru->hash_table->table[index]->value;
+    LRUEntry *entry = (LRUEntry *)lru->hash_table->table[index];
+    if (expire_on_lookup(lru, entry)) {
+        count_lookups(lru, 0, 1);
+        return FAILURE;
+    }
+    count_lookups(lru, 1, 0);
 
 #ifdef DEBUG
-    printf("Found value: %s, using key: %s\n", (char *)((Pair *)accessed_node->data)->value, key);
+    printf("Found value: %p (%zu bytes), using key: %s\n", entry->hash_entry.value, entry->value_len, entry->hash_entry.key);
 #endif
 
     /*
      * Place accessed item at the top of the list
      * as most recently used
      */
-    Node *prev_node = accessed_node->prev;
-    Node *next_node = accessed_node->next;
+    if (touch_entry(lru, entry) != SUCCESS)
+        return FAILURE;
+
+    return index;
+}
+
+/*
+ * Find entry by key, NULL if it is not cached.
+ * Lookups (not peeks) are shown to the miss ratio sampler
+ */
+static LRUEntry *find_entry(LRUCache *lru, const void *key, size_t key_len, bool lookup) {
+    if (!key && key_len > 0) {
+        fprintf(stderr, "The key provided is invalid or NULL!\n");
+        return NULL;
+    }
 
     /*
-     * Already at the top of the list
-     */
-    if (!prev_node)
-        return SUCCESS;
-    /*
-     * Connect previous and next nodes
-     * of accessed node
+     * Hash table entry is embedded in the cache entry.
+     * The lookup is read-only, a pending resize is left to writers
      */
-    prev_node->next = next_node;
-    if (next_node)
-        next_node->prev = prev_node;
-    else
-        lru->dll->tail = prev_node;
+    HashTable *table = lru->hash_table;
+    Fnv32_t hval = hash_key(table, key, key_len);
+    if (lookup && lru->mrc)
+        mrc_access(lru->mrc, hval);
+
+    return (LRUEntry *)lookup_hashed_entry(key, key_len, hval, table);
+}
+
+static int lookup_value(LRUCache *lru, const void *key, size_t key_len, void **value, size_t *value_len) {
+    if (lru->timers && exclusive_lookups(lru))
+        expire_entries(lru, LRU_EXPIRE_STEPS);
+
+    LRUEntry *entry = find_entry(lru, key, key_len, true);
+    if (!entry || expire_on_lookup(lru, entry)) {
+        count_lookups(lru, 0, 1);
+        return FAILURE;
+    }
+    count_lookups(lru, 1, 0);
+
+    if (touch_entry(lru, entry) != SUCCESS)
+        return FAILURE;
+
+    if (value)
+        *value = entry->hash_entry.value;
+    if (value_len)
+        *value_len = entry->value_len;
+
+    return SUCCESS;
+}
+
+int get_value(LRUCache *lru, const void *key, size_t key_len, void **value, size_t *value_len) {
+    if (!lru) {
+        fprintf(stderr, "LRU is not valid or is null!\n");
+        return IS_NULL;
+    }
+
+    if (!sample_latency(lru))
+        return lookup_value(lru, key, key_len, value, value_len);
+
+    u_int64_t start = monotonic_ns();
+    int result = lookup_value(lru, key, key_len, value, value_len);
+    stats_record_latency(lru->stats.get_latency, monotonic_ns() - start);
+
+    return result;
+}
+
+int peek_value(LRUCache *lru, const void *key, size_t key_len, void **value, size_t *value_len) {
+    if (!lru) {
+        fprintf(stderr, "LRU is not valid or is null!\n");
+        return IS_NULL;
+    }
+
+    LRUEntry *entry = find_entry(lru, key, key_len, false);
+    if (!entry || entry_expired(lru, entry))
+        return FAILURE;
+
+    if (value)
+        *value = entry->hash_entry.value;
+    if (value_len)
+        *value_len = entry->value_len;
+
+    return SUCCESS;
+}
+
+size_t mget(LRUCache *lru, const void *const *keys, const size_t *key_lens, size_t count,
+            void **values, size_t *value_lens) {
+    if (!lru || !keys || !key_lens) {
+        fprintf(stderr, "LRU or keys are not valid or are null!\n");
+        return 0;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (!keys[i] && key_lens[i] > 0) {
+            fprintf(stderr, "The key provided is invalid or NULL!\n");
+            return 0;
+        }
+    }
+
+    if (lru->timers && exclusive_lookups(lru))
+        expire_entries(lru, LRU_EXPIRE_STEPS);
+    u_int64_t now = lru->timers ? lru->clock() : 0;
+
+    Fnv32_t hvals[LRU_BATCH_SIZE];
+    HashEntry *found[LRU_BATCH_SIZE];
+    LRUEntry *promoted[LRU_BATCH_SIZE];
+    size_t hits = 0;
+    for (size_t start = 0; start < count; start += LRU_BATCH_SIZE) {
+        size_t batch = count - start < LRU_BATCH_SIZE ? count - start : LRU_BATCH_SIZE;
+        for (size_t i = 0; i < batch; i++) {
+            hvals[i] = hash_key(lru->hash_table, keys[start + i], key_lens[start + i]);
+            if (lru->mrc)
+                mrc_access(lru->mrc, hvals[i]);
+        }
+
+        lookup_hashed_batch((const char *const *)&keys[start], &key_lens[start], hvals, batch,
+                            lru->hash_table, found);
+
+        size_t batch_hits = 0;
+        for (size_t i = 0; i < batch; i++) {
+            LRUEntry *entry = (LRUEntry *)found[i];
+            if (entry && entry->timer && entry->timer->expires <= now)
+                entry = NULL;
+
+            if (values)
+                values[start + i] = entry ? entry->hash_entry.value : NULL;
+            if (value_lens)
+                value_lens[start + i] = entry ? entry->value_len : 0;
+            if (entry)
+                promoted[batch_hits++] = entry;
+        }
+
+        /*
+         * Every value is read before the policy relinks anything,
+         * then the chunk's hits are promoted together in lookup order
+         */
+        for (size_t i = 0; i < batch_hits; i++)
+            touch_entry(lru, promoted[i]);
+        hits += batch_hits;
+    }
+
+    count_lookups(lru, hits, count - hits);
+
+    return hits;
+}
+
+/*
+ * Copy key into cache-owned storage of the entry
+ */
+static int store_key(LRUCache *lru, LRUEntry *entry, const void *key, size_t key_len) {
+    char *storage = entry->inline_key;
+    if (key_len > LRU_INLINE_KEY_SIZE) {
+        storage = (char *)arena_alloc(lru->keys, key_len + 1);
+        if (!storage) {
+            fprintf(stderr, "Could not allocate key storage!\n");
+            return IS_NULL;
+        }
+    }
+
+    if (key_len > 0)
+        memcpy(storage, key, key_len);
+    storage[key_len] = '\0';
+
+    entry->hash_entry.key = storage;
+    entry->hash_entry.key_len = key_len;
+
+    return SUCCESS;
+}
+
+/*
+ * Give entry, its key storage, its timer and its stored value back to the pools
+ */
+static void release_entry(LRUCache *lru, LRUEntry *entry) {
+    if (entry->timer) {
+        cancel_timer(lru->timers, entry->timer);
+        slab_free(lru->timer_pool, entry->timer);
+    }
+
+    if (entry->hash_entry.key_len > LRU_INLINE_KEY_SIZE)
+        arena_free(lru->keys, (void *)entry->hash_entry.key, entry->hash_entry.key_len + 1);
+
+    if (entry->value_ref.segment)
+        release_value(lru->values, entry->value_ref);
+
+    slab_free(lru->entries, entry);
+}
+
+/*
+ * Queue a removal with a copy of its key, and of its value if "copy_value",
+ * NULL if the queue can not grow
+ */
+static Removal *queue_removal(RemovalQueue *queue, const void *key, size_t key_len, void *value, size_t value_len,
+                              bool copy_value) {
+    if (queue->count == queue->size) {
+        size_t size = queue->size ? 2 * queue->size : LRU_REMOVAL_BATCH;
+        Removal *items = (Removal *)realloc(queue->items, size * sizeof(Removal));
+        if (!items)
+            return NULL;
+        queue->items = items;
+        queue->size = size;
+    }
+
+    Removal *removal = &queue->items[queue->count];
+    removal->long_key = NULL;
+    removal->stored_value = NULL;
+    if (key_len > LRU_INLINE_KEY_SIZE) {
+        removal->long_key = (char *)malloc(key_len);
+        if (!removal->long_key)
+            return NULL;
+        memcpy(removal->long_key, key, key_len);
+    } else if (key_len > 0) {
+        memcpy(removal->inline_key, key, key_len);
+    }
+    removal->key_len = key_len;
+
+    if (copy_value) {
+        removal->stored_value = malloc(value_len ? value_len : 1);
+        if (!removal->stored_value) {
+            free(removal->long_key);
+            return NULL;
+        }
+        memcpy(removal->stored_value, value, value_len);
+        value = removal->stored_value;
+    }
+    removal->value = value;
+    removal->value_len = value_len;
+    queue->count++;
+
+    return removal;
+}
+
+/*
+ * Tell the removal listener that "value" stored under "key" left the cache.
+ * Deferred removals that can not be queued are reported right away
+ * rather than lost
+ */
+static void notify_removal(LRUCache *lru, const void *key, size_t key_len, void *value, size_t value_len,
+                           RemovalReason reason) {
+    if (!lru->removal_listener)
+        return;
 
     /*
-     * Place accessed node at the top
+     * A stored value is released right after this returns
      */
-    lru->dll->head->prev = accessed_node;
-    accessed_node->prev = NULL;
-    accessed_node->next = lru->dll->head;
-    lru->dll->head = accessed_node;
+    bool stored = lru->values && value_store_owns(lru->values, value);
+    Removal *removal = lru->defer_removals
+        ? queue_removal(&lru->removals, key, key_len, value, value_len, stored) : NULL;
+    if (removal) {
+        removal->reason = reason;
+        return;
+    }
 
-    return index;
+    Removal now = { key, key_len, value, value_len, reason, NULL, NULL, { 0 } };
+    lru->removal_listener(&now, 1, lru->removal_arg);
+}
+
+/*
+ * Remove entry from the hash table and its policy segment
+ * and drop its weight
+ */
+static int unlink_entry(LRUCache *lru, LRUEntry *entry) {
+    int index = search_hashed_entry(entry->hash_entry.key, entry->hash_entry.key_len,
+                                    entry->hash_entry.hash, lru->hash_table);
+    if (index < 0) {
+        fprintf(stderr, "LRU: Could not find entry in the hash table!\n");
+        return FAILURE;
+    }
+
+    if (unlink_hash_entry(lru->hash_table, index, false) != SUCCESS)
+        return FAILURE;
+
+    if (lru->policy->on_remove(lru, entry) != SUCCESS)
+        return FAILURE;
+
+    lru->total_weight -= entry->weight;
+
+    return SUCCESS;
+}
+
+/*
+ * Unlink entry, tell the removal listener and give it back to the pools
+ */
+static int remove_entry(LRUCache *lru, LRUEntry *entry, RemovalReason reason) {
+    if (unlink_entry(lru, entry) != SUCCESS)
+        return FAILURE;
+
+    notify_removal(lru, entry->hash_entry.key, entry->hash_entry.key_len, entry->hash_entry.value,
+                   entry->value_len, reason);
+    release_entry(lru, entry);
+
+    return SUCCESS;
+}
+
+/*
+ * Remove the entry chosen by the policy to make room for a key
+ * hashing to "hval" and give it back to the slab pool
+ */
+static int evict_entry(LRUCache *lru, Fnv32_t hval) {
+    LRUEntry *victim = lru->policy->choose_victim(lru, hval);
+    if (!victim) {
+        fprintf(stderr, "LRU: %s policy found no entry to evict!\n", lru->policy->name);
+        return FAILURE;
+    }
+
+#ifdef DEBUG
+    printf("VICTIM_KEY: %s\n", victim->hash_entry.key);
+#endif
+
+    if (remove_entry(lru, victim, REMOVAL_EVICTED) != SUCCESS)
+        return FAILURE;
+    STATS_ADD(lru->stats.evictions, 1);
+
+    return SUCCESS;
 }
 
 int put(LRUCache *lru, const char *key, char *value) {
+    if (!key) {
+        fprintf(stderr, "The key provided is invalid or NULL!\n");
+        return IS_NULL;
+    }
+
+    if (!value) {
+        fprintf(stderr, "The value provided is invalid or NULL!\n");
+        return IS_NULL;
+    }
+
+    return put_bytes(lru, key, strlen(key), value, strlen(value));
+}
+
+static size_t weigh_entry(LRUCache *lru, const void *key, size_t key_len, const void *value, size_t value_len) {
+    if (lru->weigher)
+        return lru->weigher(key, key_len, value, value_len);
+
+    return key_len + value_len;
+}
+
+/*
+ * Timers are only allocated once the cache sees its first TTL,
+ * then one per entry up front like the entries themselves
+ */
+static int enable_expiry(LRUCache *lru) {
+    if (lru->timers)
+        return SUCCESS;
+
+    lru->timer_pool = init_slab_pool(sizeof(Timer), lru->capacity);
+    if (!lru->timer_pool)
+        return IS_NULL;
+
+    lru->timers = init_timer_wheel(lru->clock());
+    if (!lru->timers) {
+        free_slab_pool(lru->timer_pool);
+        lru->timer_pool = NULL;
+        return IS_NULL;
+    }
+
+    return SUCCESS;
+}
+
+/*
+ * Expire entry "ttl_ms" from now, or never if it is 0
+ */
+static int set_entry_ttl(LRUCache *lru, LRUEntry *entry, u_int64_t ttl_ms) {
+    if (ttl_ms == 0) {
+        if (entry->timer) {
+            cancel_timer(lru->timers, entry->timer);
+            slab_free(lru->timer_pool, entry->timer);
+            entry->timer = NULL;
+        }
+        return SUCCESS;
+    }
+
+    if (!entry->timer) {
+        entry->timer = (Timer *)slab_alloc(lru->timer_pool);
+        if (!entry->timer) {
+            fprintf(stderr, "Could not allocate entry timer!\n");
+            return IS_NULL;
+        }
+        init_timer(entry->timer, entry);
+    }
+
+    return schedule_timer(lru->timers, entry->timer, lru->clock() + ttl_ms);
+}
+
+static int put_entry(LRUCache *lru, const void *key, size_t key_len, void *value, size_t value_len,
+                     size_t weight, u_int64_t ttl_ms, Fnv32_t hval);
+
+static int check_put_args(const LRUCache *lru, const void *key, size_t key_len, const void *value) {
     if (!lru) {
         fprintf(stderr, "LRU is not valid or is null!\n");
         return IS_NULL;
     }
 
-    if (!key) {
+    if (!key && key_len > 0) {
         fprintf(stderr, "The key provided is invalid or NULL!\n");
         return IS_NULL;
     }
@@ -119,57 +698,619 @@ int put(LRUCache *lru, const char *key, char *value) {
         return IS_NULL;
     }
 
-    if (lru->hash_table->count_entry == lru->capacity) {
-        const char *tail_key = (char *)((Pair *)lru->dll->tail->data)->key;
+    return SUCCESS;
+}
+
+int put_bytes(LRUCache *lru, const void *key, size_t key_len, void *value, size_t value_len) {
+    int result = check_put_args(lru, key, key_len, value);
+    if (result != SUCCESS)
+        return result;
+
+    return put_entry(lru, key, key_len, value, value_len, weigh_entry(lru, key, key_len, value, value_len), 0,
+                     hash_key(lru->hash_table, key, key_len));
+}
+
+int put_weighted(LRUCache *lru, const void *key, size_t key_len, void *value, size_t value_len, size_t weight) {
+    int result = check_put_args(lru, key, key_len, value);
+    if (result != SUCCESS)
+        return result;
+
+    return put_entry(lru, key, key_len, value, value_len, weight, 0, hash_key(lru->hash_table, key, key_len));
+}
+
+int put_ttl(LRUCache *lru, const void *key, size_t key_len, void *value, size_t value_len, u_int64_t ttl_ms) {
+    int result = check_put_args(lru, key, key_len, value);
+    if (result != SUCCESS)
+        return result;
+
+    if (ttl_ms == 0) {
+        fprintf(stderr, "TTL cannot be less than 1 ms!\n");
+        return FAILURE;
+    }
+
+    if (enable_expiry(lru) != SUCCESS)
+        return IS_NULL;
+
+    return put_entry(lru, key, key_len, value, value_len, weigh_entry(lru, key, key_len, value, value_len), ttl_ms,
+                     hash_key(lru->hash_table, key, key_len));
+}
+
+int mput(LRUCache *lru, const void *const *keys, const size_t *key_lens,
+         void *const *values, const size_t *value_lens, size_t count) {
+    if (!lru || !keys || !key_lens || !values || !value_lens) {
+        fprintf(stderr, "LRU or pairs are not valid or are null!\n");
+        return IS_NULL;
+    }
+
+    Fnv32_t hvals[LRU_BATCH_SIZE];
+    int result = SUCCESS;
+    for (size_t start = 0; start < count; start += LRU_BATCH_SIZE) {
+        size_t batch = count - start < LRU_BATCH_SIZE ? count - start : LRU_BATCH_SIZE;
+        for (size_t i = 0; i < batch; i++) {
+            size_t pair = start + i;
+            hvals[i] = 0;
+            if (keys[pair] || key_lens[pair] == 0) {
+                hvals[i] = hash_key(lru->hash_table, keys[pair], key_lens[pair]);
+                prefetch_hashed_slot(hvals[i], lru->hash_table);
+            }
+        }
+
+        for (size_t i = 0; i < batch; i++) {
+            size_t pair = start + i;
+            int stored = check_put_args(lru, keys[pair], key_lens[pair], values[pair]);
+            if (stored == SUCCESS)
+                stored = put_entry(lru, keys[pair], key_lens[pair], values[pair], value_lens[pair],
+                                   weigh_entry(lru, keys[pair], key_lens[pair], values[pair], value_lens[pair]),
+                                   0, hvals[i]);
+            if (stored != SUCCESS)
+                result = stored;
+        }
+    }
+
+    return result;
+}
+
+/*
+ * Entry takes ownership of the stored value "ref", if there is one,
+ * and "ref" is cleared
+ */
+static void attach_value(LRUCache *lru, LRUEntry *entry, ValueRef *ref) {
+    entry->value_ref = *ref;
+    if (ref->segment)
+        set_value_owner(lru->values, *ref, entry);
+    ref->segment = 0;
+}
+
+static int place_entry(LRUCache *lru, const void *key, size_t key_len, void *value, size_t value_len,
+                       size_t weight, u_int64_t ttl_ms, Fnv32_t hval, ValueRef *ref);
 
-        printf("TAIL_KEY: %s\n", tail_key);
-        // Find Least Recently Used entry 
-        int index = search_entry(tail_key, lru->hash_table);
-        if (index < 0) {
-            fprintf(stderr, "LRU: Could not find entry in the hash table!\n");
+/*
+ * Insert or update entry whose key hashes to "hval",
+ * "ttl_ms" 0 means it never expires. Arguments are checked by callers
+ */
+static int insert_entry(LRUCache *lru, const void *key, size_t key_len, void *value, size_t value_len,
+                        size_t weight, u_int64_t ttl_ms, Fnv32_t hval) {
+    /*
+     * Buffered hits must not outlive the entries they point to,
+     * apply them before anything can be evicted
+     */
+    if (lru->reads)
+        drain_reads(lru);
+
+    if (lru->timers)
+        advance_timer_wheel(lru->timers, lru->clock(), LRU_EXPIRE_STEPS, expire_timer, lru);
+
+    if (weight > UINT32_MAX || (lru->max_weight && weight > lru->max_weight)) {
+        fprintf(stderr, "LRU: Entry weight %zu exceeds the cache's budget!\n", weight);
+        return FAILURE;
+    }
+
+    /*
+     * Values are copied into the store first: reclaiming a segment
+     * evicts entries, possibly the one about to be updated
+     */
+    ValueRef ref = { 0, 0 };
+    if (lru->values) {
+        if (store_value(lru->values, value, value_len, NULL, &ref) != SUCCESS)
             return FAILURE;
+        value = value_at(lru->values, ref);
+    }
+
+    int result = place_entry(lru, key, key_len, value, value_len, weight, ttl_ms, hval, &ref);
+    if (ref.segment)
+        release_value(lru->values, ref);
+
+    return result;
+}
+
+/*
+ * Update or add the entry of insert_entry. A stored value "ref"
+ * left set was not taken by any entry
+ */
+static int place_entry(LRUCache *lru, const void *key, size_t key_len, void *value, size_t value_len,
+                       size_t weight, u_int64_t ttl_ms, Fnv32_t hval, ValueRef *ref) {
+    /*
+     * Existing key only changes the value and becomes most recently used.
+     * If the new weight no longer fits, the entry is replaced
+     * and has to compete for room like a new one.
+     * The old value is reported replaced unless it is put again
+     */
+    int index = search_hashed_entry(key, key_len, hval, lru->hash_table);
+    bool replaced = index >= 0;
+    if (replaced) {
+        STATS_ADD(lru->stats.replacements, 1);
+        LRUEntry *entry = (LRUEntry *)lru->hash_table->table[index];
+        size_t total_weight = lru->total_weight - entry->weight + weight;
+        if (!lru->max_weight || total_weight <= lru->max_weight) {
+            if (set_entry_ttl(lru, entry, ttl_ms) != SUCCESS)
+                return FAILURE;
+            if (entry->hash_entry.value != value)
+                notify_removal(lru, entry->hash_entry.key, key_len, entry->hash_entry.value, entry->value_len,
+                               REMOVAL_REPLACED);
+            if (entry->value_ref.segment)
+                release_value(lru->values, entry->value_ref);
+            attach_value(lru, entry, ref);
+            entry->hash_entry.value = value;
+            entry->value_len = value_len;
+            entry->weight = (u_int32_t)weight;
+            lru->total_weight = total_weight;
+            return touch_entry(lru, entry);
         }
 
-        /* Free the hash table from the LRU entry and remove tail node 
-         * from the end of the linked list
-         */
-        free(lru->hash_table->table[index]);
-        lru->hash_table->table[index] = NULL;
+        if (entry->hash_entry.value != value) {
+            if (remove_entry(lru, entry, REMOVAL_REPLACED) != SUCCESS)
+                return FAILURE;
+        } else {
+            if (unlink_entry(lru, entry) != SUCCESS)
+                return FAILURE;
+            release_entry(lru, entry);
+        }
+    }
 
-        free(lru->dll->tail->data);
-        lru->dll->tail->data = NULL;
-        if (delete_at_end(lru->dll) != SUCCESS)
+    /*
+     * Evict until both the entry count and the weight budget have room
+     */
+    while (lru->hash_table->count_entry >= lru->capacity
+            || (lru->max_weight && lru->total_weight + weight > lru->max_weight)) {
+        if (evict_entry(lru, hval) != SUCCESS)
             return FAILURE;
     }
     
-    Pair *pair = calloc(1, sizeof(Pair));
-    if (!pair) {
-        fprintf(stderr, "Could not allocate Pair struct!\n");
+    LRUEntry *entry = (LRUEntry *)slab_alloc(lru->entries);
+    if (!entry) {
+        fprintf(stderr, "Could not allocate cache entry!\n");
+        return IS_NULL;
+    }
+
+    if (store_key(lru, entry, key, key_len) != SUCCESS) {
+        slab_free(lru->entries, entry);
         return IS_NULL;
     }
 
-    pair->key = (void *)key;
-    pair->value = (void *)value;
+    entry->hash_entry.value = value;
+    entry->hash_entry.hash = hval;
+    entry->value_len = value_len;
+    entry->weight = (u_int32_t)weight;
+    entry->node.data = (void *)entry;
+    if (set_entry_ttl(lru, entry, ttl_ms) != SUCCESS) {
+        release_entry(lru, entry);
+        return IS_NULL;
+    }
 
-    if (insert_at_front(lru->dll, (void *)pair) != SUCCESS) {
+    if (lru->policy->on_insert(lru, entry) != SUCCESS) {
         fprintf(stderr, "LRU: Could not insert entry to the linked list!\n");
+        release_entry(lru, entry);
         return FAILURE;
     }
 
 #ifdef DEBUG
-    printf("DEBUG: DLL HEAD DATA FIELD CONTAINS: %s\n", (char *)((Pair *)lru->dll->head->data)->key);
+    printf("DEBUG: Inserted key %s into segment %d\n", entry->hash_entry.key, entry->segment);
 #endif
 
-    bool auto_resize = false; // Do not auto resize the hash table
-    int index = add_hash_entry(key, (void *)lru->dll->head, lru->hash_table, auto_resize);
+    bool auto_resize = true; // Grow if the table ever passes its load factor
+    index = link_hash_entry(&entry->hash_entry, lru->hash_table, auto_resize);
     if (index < 0) {
         fprintf(stderr, "LRU: Could not add entry to the hash table!\n");
+        lru->policy->on_remove(lru, entry);
+        release_entry(lru, entry);
         return FAILURE;
     }
+    lru->total_weight += weight;
+    attach_value(lru, entry, ref);
+    if (!replaced)
+        STATS_ADD(lru->stats.inserts, 1);
+
+    return SUCCESS;
+}
+
+static int put_entry(LRUCache *lru, const void *key, size_t key_len, void *value, size_t value_len,
+                     size_t weight, u_int64_t ttl_ms, Fnv32_t hval) {
+    if (!sample_latency(lru))
+        return insert_entry(lru, key, key_len, value, value_len, weight, ttl_ms, hval);
+
+    u_int64_t start = monotonic_ns();
+    int result = insert_entry(lru, key, key_len, value, value_len, weight, ttl_ms, hval);
+    stats_record_latency(lru->stats.put_latency, monotonic_ns() - start);
+
+    return result;
+}
+
+int remove_key(LRUCache *lru, const void *key, size_t key_len) {
+    if (!lru) {
+        fprintf(stderr, "LRU is not valid or is null!\n");
+        return IS_NULL;
+    }
+
+    /*
+     * Buffered hits must not outlive the entry
+     */
+    if (lru->reads)
+        drain_reads(lru);
+
+    LRUEntry *entry = find_entry(lru, key, key_len, false);
+    if (!entry)
+        return FAILURE;
+
+    return remove_entry(lru, entry, REMOVAL_EXPLICIT);
+}
+
+int set_removal_listener(LRUCache *lru, RemovalListener listener, void *arg, bool deferred) {
+    if (!lru) {
+        fprintf(stderr, "LRU is not valid or is null!\n");
+        return IS_NULL;
+    }
+
+    /*
+     * Removals queued for the previous listener go to it first
+     */
+    reclaim_removals(lru);
+
+    lru->removal_listener = listener;
+    lru->removal_arg = arg;
+    lru->defer_removals = deferred;
 
     return SUCCESS;
 }
 
+size_t take_removals(LRUCache *lru, RemovalQueue *out) {
+    if (!lru || !out) {
+        fprintf(stderr, "LRU or removal queue are not valid or are null!\n");
+        return 0;
+    }
+
+    *out = lru->removals;
+    memset(&lru->removals, 0, sizeof(lru->removals));
+
+    return out->count;
+}
+
+size_t deliver_removals(RemovalQueue *queue, RemovalListener listener, void *arg) {
+    if (!queue) {
+        fprintf(stderr, "Removal queue is not valid or is null!\n");
+        return 0;
+    }
+
+    /*
+     * Keys point into the records only now, the queue may have moved
+     * while it grew
+     */
+    for (size_t i = 0; i < queue->count; i++) {
+        Removal *removal = &queue->items[i];
+        removal->key = removal->long_key ? removal->long_key : removal->inline_key;
+    }
+
+    size_t delivered = queue->count;
+    for (size_t i = 0; listener && i < queue->count; i += LRU_REMOVAL_BATCH) {
+        size_t batch = queue->count - i < LRU_REMOVAL_BATCH ? queue->count - i : LRU_REMOVAL_BATCH;
+        listener(&queue->items[i], batch, arg);
+    }
+
+    for (size_t i = 0; i < queue->count; i++) {
+        free(queue->items[i].long_key);
+        free(queue->items[i].stored_value);
+    }
+    free(queue->items);
+    memset(queue, 0, sizeof(*queue));
+
+    return delivered;
+}
+
+size_t reclaim_removals(LRUCache *lru) {
+    if (!lru) {
+        fprintf(stderr, "LRU is not valid or is null!\n");
+        return 0;
+    }
+
+    if (lru->removals.count == 0)
+        return 0;
+
+    RemovalQueue queue;
+    take_removals(lru, &queue);
+
+    return deliver_removals(&queue, lru->removal_listener, lru->removal_arg);
+}
+
+/*
+ * Report every cached value as explicitly removed, for free_lru.
+ * Slots of an unfinished resize still in the old array are visited too
+ */
+static void notify_remaining(LRUCache *lru) {
+    HashTable *table = lru->hash_table;
+    bool deferred = lru->defer_removals;
+    lru->defer_removals = false;
+
+    for (size_t i = 0; i < table->table_size; i++) {
+        if (!IS_LIVE_ENTRY(table->table[i]))
+            continue;
+        LRUEntry *entry = (LRUEntry *)table->table[i];
+        notify_removal(lru, entry->hash_entry.key, entry->hash_entry.key_len, entry->hash_entry.value,
+                       entry->value_len, REMOVAL_EXPLICIT);
+    }
+
+    for (size_t i = table->rehash_index; table->old_table && i < table->old_size; i++) {
+        if (!IS_LIVE_ENTRY(table->old_table[i]))
+            continue;
+        LRUEntry *entry = (LRUEntry *)table->old_table[i];
+        notify_removal(lru, entry->hash_entry.key, entry->hash_entry.key_len, entry->hash_entry.value,
+                       entry->value_len, REMOVAL_EXPLICIT);
+    }
+
+    lru->defer_removals = deferred;
+}
+
+/*
+ * Lists of the policy hottest first, just the dll for policies
+ * that do not rank theirs
+ */
+static DLL *ranked_list(LRUCache *lru, size_t rank) {
+    if (lru->policy->ranked_list)
+        return lru->policy->ranked_list(lru, rank);
+
+    return rank == 0 ? lru->dll : NULL;
+}
+
+int save_snapshot(LRUCache *lru, const char *path) {
+    if (!lru) {
+        fprintf(stderr, "LRU is not valid or is null!\n");
+        return IS_NULL;
+    }
+
+    /*
+     * Pending hits still count towards recency
+     */
+    if (lru->reads)
+        drain_reads(lru);
+
+    SnapshotWriter *writer = open_snapshot(path);
+    if (!writer)
+        return FAILURE;
+
+    u_int64_t now = lru->timers ? lru->clock() : 0;
+    DLL *list;
+    for (size_t rank = 0; (list = ranked_list(lru, rank)) != NULL; rank++) {
+        for (Node *node = list->head; node; node = node->next) {
+            LRUEntry *entry = (LRUEntry *)node->data;
+            u_int64_t ttl_ms = 0;
+            if (entry->timer) {
+                if (entry->timer->expires <= now)
+                    continue;
+                ttl_ms = entry->timer->expires - now;
+            }
+
+            if (write_snapshot_record(writer, entry->hash_entry.key, entry->hash_entry.key_len,
+                                      entry->hash_entry.value, entry->value_len, entry->weight, ttl_ms) != SUCCESS) {
+                abort_snapshot(writer);
+                return FAILURE;
+            }
+        }
+    }
+
+    return commit_snapshot(writer);
+}
+
+/*
+ * Link the entry of snapshot record "record", values stay in the mapping.
+ * In order loads go through the policy's on_load in file order,
+ * otherwise through on_insert from the coldest record
+ */
+static int load_record(LRUCache *lru, const SnapshotRecord *record, Fnv32_t hval, bool in_order) {
+    LRUEntry *entry = (LRUEntry *)slab_alloc(lru->entries);
+    if (!entry) {
+        fprintf(stderr, "Could not allocate cache entry!\n");
+        return IS_NULL;
+    }
+
+    const char *key = snapshot_key(record);
+    if (store_key(lru, entry, key, record->key_len) != SUCCESS) {
+        slab_free(lru->entries, entry);
+        return IS_NULL;
+    }
+
+    entry->hash_entry.value = snapshot_value(record);
+    entry->hash_entry.hash = hval;
+    entry->value_len = record->value_len;
+    entry->weight = record->weight;
+    entry->node.data = (void *)entry;
+    if (set_entry_ttl(lru, entry, record->ttl_ms) != SUCCESS) {
+        release_entry(lru, entry);
+        return IS_NULL;
+    }
+
+    int linked = in_order ? lru->policy->on_load(lru, entry) : lru->policy->on_insert(lru, entry);
+    if (linked != SUCCESS) {
+        release_entry(lru, entry);
+        return FAILURE;
+    }
+
+    /*
+     * Slots were reserved for the whole snapshot,
+     * link_hash_entry only covers a table that could not be
+     */
+    if (place_hash_entry(&entry->hash_entry, lru->hash_table) < 0
+            && link_hash_entry(&entry->hash_entry, lru->hash_table, true) < 0) {
+        lru->policy->on_remove(lru, entry);
+        release_entry(lru, entry);
+        return FAILURE;
+    }
+    lru->total_weight += entry->weight;
+    STATS_ADD(lru->stats.inserts, 1);
+
+    return SUCCESS;
+}
+
+int load_snapshot(LRUCache *lru, const char *path) {
+    if (!lru) {
+        fprintf(stderr, "LRU is not valid or is null!\n");
+        return IS_NULL;
+    }
+
+    if (lru->hash_table->count_entry > 0 || lru->snapshot) {
+        fprintf(stderr, "LRU: Snapshots only load into an empty cache!\n");
+        return FAILURE;
+    }
+
+    SnapshotView *view = map_snapshot(path, lru->capacity);
+    if (!view)
+        return FAILURE;
+
+    /*
+     * Keep the hottest entries that fit the weight budget
+     */
+    size_t count = view->loaded;
+    bool expiring = false;
+    size_t total_weight = 0;
+    for (size_t i = 0; i < count; i++) {
+        const SnapshotRecord *record = snapshot_record(view, i);
+        if (lru->max_weight && total_weight + record->weight > lru->max_weight) {
+            count = i;
+            break;
+        }
+        total_weight += record->weight;
+        expiring |= record->ttl_ms != 0;
+    }
+
+    if (count == 0 || (expiring && enable_expiry(lru) != SUCCESS)) {
+        unmap_snapshot(view);
+        return count == 0 ? SUCCESS : IS_NULL;
+    }
+
+    /*
+     * The table is sized for every record up front, so each entry is
+     * placed straight into its slot. Policies with on_load take the
+     * records in file order, hottest first, appending to their list;
+     * on_insert links at the front, so those go in from the coldest.
+     * Keys are hashed a batch ahead and their slots prefetched,
+     * as in mget, so the table's cache misses overlap
+     */
+    lru->snapshot = view;
+    reserve_hash_table(lru->hash_table, count);
+    bool in_order = lru->policy->on_load != NULL;
+    int result = SUCCESS;
+    Fnv32_t hvals[LRU_BATCH_SIZE];
+    for (size_t done = 0; done < count && result == SUCCESS;) {
+        size_t batch = count - done < LRU_BATCH_SIZE ? count - done : LRU_BATCH_SIZE;
+        for (size_t i = 0; i < batch; i++) {
+            size_t index = in_order ? done + i : count - 1 - done - i;
+            const SnapshotRecord *record = snapshot_record(view, index);
+            hvals[i] = hash_key(lru->hash_table, snapshot_key(record), record->key_len);
+            prefetch_hashed_slot(hvals[i], lru->hash_table);
+        }
+
+        for (size_t i = 0; i < batch && result == SUCCESS; i++) {
+            size_t index = in_order ? done + i : count - 1 - done - i;
+            result = load_record(lru, snapshot_record(view, index), hvals[i], in_order);
+        }
+        done += batch;
+    }
+    release_snapshot_offsets(view);
+
+    if (result != SUCCESS)
+        fprintf(stderr, "LRU: Snapshot %s was only partly loaded!\n", path);
+
+    return result;
+}
+
+bool cache_owns_value(const LRUCache *lru, const void *value) {
+    if (!lru)
+        return false;
+
+    return (lru->snapshot && snapshot_owns(lru->snapshot, value))
+        || (lru->values && value_store_owns(lru->values, value));
+}
+
+/*
+ * Reclaimed segment takes the entry whose value lives there with it
+ */
+static void evict_stored(void *owner, void *arg) {
+    LRUCache *lru = (LRUCache *)arg;
+    if (remove_entry(lru, (LRUEntry *)owner, REMOVAL_EVICTED) == SUCCESS)
+        STATS_ADD(lru->stats.evictions, 1);
+}
+
+int enable_value_store(LRUCache *lru, size_t segment_size, size_t segment_count, const char *path) {
+    if (!lru) {
+        fprintf(stderr, "LRU is not valid or is null!\n");
+        return IS_NULL;
+    }
+
+    if (lru->values)
+        return SUCCESS;
+
+    lru->values = init_value_store(segment_size, segment_count, path, evict_stored, lru);
+    if (!lru->values)
+        return IS_NULL;
+
+    return SUCCESS;
+}
+
+int enable_mrc_sampler(LRUCache *lru, size_t max_keys) {
+    if (!lru) {
+        fprintf(stderr, "LRU is not valid or is null!\n");
+        return IS_NULL;
+    }
+
+    if (lru->mrc)
+        return SUCCESS;
+
+    lru->mrc = init_mrc_sampler(max_keys ? max_keys : MRC_SAMPLE_KEYS);
+    if (!lru->mrc)
+        return IS_NULL;
+
+    return SUCCESS;
+}
+
+int enable_probe_stats(LRUCache *lru) {
+    if (!lru) {
+        fprintf(stderr, "LRU is not valid or is null!\n");
+        return IS_NULL;
+    }
+
+    _Static_assert(STATS_PROBE_BUCKETS == HASH_PROBE_BUCKETS, "probe histograms differ in size");
+    lru->hash_table->probe_hist = lru->stats.probe_lengths;
+
+    return SUCCESS;
+}
+
+double cache_miss_ratio(LRUCache *lru, size_t capacity) {
+    if (!lru || !lru->mrc) {
+        fprintf(stderr, "LRU or its sampler are not valid or are null!\n");
+        return 1.0;
+    }
+
+    return mrc_miss_ratio(lru->mrc, capacity);
+}
+
+void cache_stats_snapshot(const LRUCache *lru, CacheStats *out) {
+    if (!lru || !out) {
+        fprintf(stderr, "LRU or stats are not valid or are null!\n");
+        return;
+    }
+
+    memset(out, 0, sizeof(*out));
+    stats_merge(out, &lru->stats);
+    stats_merge_lookups(out, lru->lookups);
+}
+
 void free_lru(LRUCache *lru) {
     if (!lru) {
         fprintf(stderr, "LRUCache is not valid or is null!\n");
@@ -177,8 +1318,44 @@ void free_lru(LRUCache *lru) {
         return;
     }
     
-    free_table(lru->hash_table);
-    free_dll(lru->dll);
+    /*
+     * Values still owned by the cache go back to their owner
+     */
+    reclaim_removals(lru);
+    if (lru->removal_listener && lru->hash_table)
+        notify_remaining(lru);
+
+    if (lru->policy && lru->policy->free)
+        lru->policy->free(lru);
+    if (lru->hash_table)
+        free_table(lru->hash_table);
+    /*
+     * List nodes are embedded in slab entries,
+     * so only the list header is freed here
+     */
+    free(lru->dll);
+    if (lru->entries)
+        free_slab_pool(lru->entries);
+    if (lru->keys)
+        free_key_arena(lru->keys);
+    if (lru->reads)
+        free_read_buffer(lru->reads);
+    if (lru->lookups)
+        free_lookup_stats(lru->lookups);
+    /*
+     * Timers are embedded in the timer pool,
+     * the wheel only links them
+     */
+    if (lru->timers)
+        free_timer_wheel(lru->timers);
+    if (lru->timer_pool)
+        free_slab_pool(lru->timer_pool);
+    if (lru->mrc)
+        free_mrc_sampler(lru->mrc);
+    if (lru->snapshot)
+        unmap_snapshot(lru->snapshot);
+    if (lru->values)
+        free_value_store(lru->values);
     free(lru);
     lru = NULL;
 
@@ -1,25 +1,435 @@
 #include "hash.h"
 #include "dll.h"
+#include "slab.h"
+#include "arena.h"
+#include "read_buffer.h"
+#include "timer_wheel.h"
+#include "stats.h"
+#include "mrc.h"
+#include "snapshot.h"
+#include "value_store.h"
 
 #define SUCCESS 0
 #define FAILURE -1
 #define IS_NULL -2
 
+/*
+ * Keys up to this many bytes are copied into the entry itself,
+ * longer keys into the cache's key arena
+ */
+#ifndef LRU_INLINE_KEY_SIZE
+#define LRU_INLINE_KEY_SIZE 23
+#endif
+
+/*
+ * Most steps of the timer wheel a put or get may take,
+ * one step expires an entry or skips to the next deadline
+ */
+#ifndef LRU_EXPIRE_STEPS
+#define LRU_EXPIRE_STEPS 16
+#endif
+
+/*
+ * Keys hashed and resolved together by mget and mput
+ */
+#ifndef LRU_BATCH_SIZE
+#define LRU_BATCH_SIZE 64
+#endif
+
+/*
+ * Most removals a deferred listener is handed at once
+ */
+#ifndef LRU_REMOVAL_BATCH
+#define LRU_REMOVAL_BATCH 64
+#endif
+
+/*
+ * Intrusive cache entry
+ * Key, value, hash table entry and LRU links live in one
+ * allocation taken from the slab pool.
+ * hash_entry must stay the first member: the hash table hands
+ * out HashEntry pointers which are cast back to LRUEntry.
+ * The cache owns a copy of the key: hash_entry.key points at
+ * inline_key, or at an arena block for long keys.
+ * Keys are binary, the extra byte only NUL terminates them for printing.
+ * timer is NULL unless the entry was put with a TTL.
+ * value_ref locates the value in the cache's value store,
+ * its segment is 0 while the caller owns the value
+ */
+typedef struct LRUEntry {
+    HashEntry hash_entry;
+    Node node;
+    size_t value_len;
+    unsigned char referenced;
+    unsigned char segment;
+    u_int32_t weight;
+    ValueRef value_ref;
+    Timer *timer;
+    char inline_key[LRU_INLINE_KEY_SIZE + 1];
+} LRUEntry;
+
+struct LRUCache;
+
+/*
+ * Weight of an entry for byte-budget caches,
+ * e.g. value bytes plus per-entry overhead
+ */
+typedef size_t (*Weigher)(const void *key, size_t key_len, const void *value, size_t value_len);
+
+/*
+ * Current time in milliseconds for TTLs, monotonic by default
+ */
+typedef u_int64_t (*CacheClock)(void);
+
+/*
+ * Why a value left the cache
+ * REMOVAL_EVICTED:  made room for another entry
+ * REMOVAL_REPLACED: a put of the same key brought a new value
+ * REMOVAL_EXPIRED:  its TTL ran out
+ * REMOVAL_EXPLICIT: remove_key, or the cache was freed
+ */
+typedef enum RemovalReason {
+    REMOVAL_EVICTED,
+    REMOVAL_REPLACED,
+    REMOVAL_EXPIRED,
+    REMOVAL_EXPLICIT
+} RemovalReason;
+
+/*
+ * A value that left the cache and the key it was stored under.
+ * Deferred removals carry a copy of the key: inline_key, or long_key
+ * for keys longer than LRU_INLINE_KEY_SIZE. Values of the value store
+ * are copied too (stored_value): their segment may be reclaimed
+ * before the listener runs
+ */
+typedef struct Removal {
+    const void *key;
+    size_t key_len;
+    void *value;
+    size_t value_len;
+    RemovalReason reason;
+    char *long_key;
+    void *stored_value;
+    char inline_key[LRU_INLINE_KEY_SIZE + 1];
+} Removal;
+
+/*
+ * Removals waiting for their listener
+ */
+typedef struct RemovalQueue {
+    Removal *items;
+    size_t count;
+    size_t size;
+} RemovalQueue;
+
+/*
+ * Told about "count" removals. Called with the cache in the middle
+ * of an operation unless removals are deferred, so it must not call
+ * back into the cache
+ */
+typedef void (*RemovalListener)(const Removal *removals, size_t count, void *arg);
+
+/*
+ * Eviction policy
+ * The cache owns the hash index and the entries, a policy only orders
+ * them through the entry's list node and segment. Segment 0 is kept in
+ * the cache's dll, policies with more segments keep further lists in
+ * their state. No hook allocates per entry.
+ *
+ * on_hit:        entry was looked up
+ * on_insert:     entry was just added, link it into a segment
+ * choose_victim: cache is full and a key hashing to "hval" is about
+ *                to be added, pick the entry to evict
+ * on_remove:     entry leaves the cache, unlink it
+ * ranked_list:   lists holding the entries, hottest first from rank 0,
+ *                NULL past the last. Snapshots walk each from its head,
+ *                without the hook they only walk the cache's dll
+ * on_load:       entry of a snapshot being loaded into an empty cache,
+ *                which hands them over hottest first: link it behind
+ *                the ones before it. Without the hook snapshots load
+ *                through on_insert, coldest first
+ *
+ * "concurrent_hits" policies only touch the entry's reference bit
+ * on a hit, so lookups may run under a shared lock
+ */
+typedef struct EvictionPolicy {
+    const char *name;
+    bool concurrent_hits;
+    int (*init)(struct LRUCache *lru);
+    int (*on_hit)(struct LRUCache *lru, LRUEntry *entry);
+    int (*on_insert)(struct LRUCache *lru, LRUEntry *entry);
+    LRUEntry *(*choose_victim)(struct LRUCache *lru, Fnv32_t hval);
+    int (*on_remove)(struct LRUCache *lru, LRUEntry *entry);
+    DLL *(*ranked_list)(struct LRUCache *lru, size_t rank);
+    int (*on_load)(struct LRUCache *lru, LRUEntry *entry);
+    void (*free)(struct LRUCache *lru);
+} EvictionPolicy;
+
+/*
+ * lru_policy:       move to front on hit, evict the tail
+ * clock_policy:     reference bit on hit, second chance sweep from the tail
+ * slru_policy:      probation and protected (80%) segments
+ * two_queue_policy: FIFO A1in (25%), ghost A1out (50%) and LRU Am
+ * arc_policy:       adaptive replacement cache, T1/T2 with ghosts B1/B2
+ * tinylfu_policy:   W-TinyLFU, 1% window LRU in front of a segmented LRU,
+ *                   admission to main decided by a count-min sketch
+ */
+extern const EvictionPolicy lru_policy;
+extern const EvictionPolicy clock_policy;
+extern const EvictionPolicy slru_policy;
+extern const EvictionPolicy two_queue_policy;
+extern const EvictionPolicy arc_policy;
+extern const EvictionPolicy tinylfu_policy;
+
 typedef struct LRUCache {
     size_t capacity;
     HashTable *hash_table;
     DLL *dll;
+    SlabPool *entries;
+    KeyArena *keys;
+    const EvictionPolicy *policy;
+    void *policy_state;
+    ReadBuffer *reads;
+    /*
+     * Set when buffered lookups run concurrently under a shared lock:
+     * a full stripe is then left for the lock holder to drain
+     * (see read_buffer_full) instead of being drained by the lookup
+     */
+    bool shared_reads;
+    size_t max_weight;
+    size_t total_weight;
+    Weigher weigher;
+    CacheClock clock;
+    TimerWheel *timers;
+    SlabPool *timer_pool;
+    /*
+     * Always on counters, see CacheStats. Hits and misses go to the
+     * calling thread's stripe of "lookups" instead, so concurrent readers
+     * do not bounce one line; cache_stats_snapshot sums them into hits
+     * and misses. stats.probe_lengths stays 0 until enable_probe_stats.
+     * latency_sample 0 turns latency sampling off, "n" times one in
+     * every n get_value and put calls of each thread
+     */
+    CacheStats stats;
+    LookupStats *lookups;
+    unsigned int latency_sample;
+    MissRatioSampler *mrc;
+    RemovalListener removal_listener;
+    void *removal_arg;
+    bool defer_removals;
+    RemovalQueue removals;
+    /*
+     * File the cache was loaded from, values of loaded entries
+     * point into its mapping until free_lru
+     */
+    SnapshotView *snapshot;
+    /*
+     * Copies of the values put since enable_value_store, NULL before
+     */
+    ValueStore *values;
 } LRUCache;
 
-typedef struct Pair {
-    void *key;
-    void *value;
-} Pair;
-
 // Temp
 void print_list_pair(DLL *dll);
 
 LRUCache *init_lru_cache(size_t capacity);
+
+/*
+ * Initialize cache evicting by "policy"
+ */
+LRUCache *init_policy_cache(size_t capacity, const EvictionPolicy *policy);
+
+/*
+ * Cache bounded by total weight as well as by entry count:
+ * put evicts until the new entry fits into "max_weight".
+ * "capacity" still limits the number of entries and sizes the
+ * table, slab and policy state up front.
+ * Entries weigh key_len + value_len unless "weigher" is given,
+ * or their weight is passed to put_weighted.
+ * total_weight is kept exact for every cache
+ */
+LRUCache *init_weighted_cache(size_t capacity, size_t max_weight, const EvictionPolicy *policy, Weigher weigher);
+
+/*
+ * Same as init_policy_cache with clock_policy.
+ * get_value and peek_value write nothing but the reference bit,
+ * so concurrent readers only need a shared lock
+ */
+LRUCache *init_clock_cache(size_t capacity);
+
+/*
+ * Same as init_lru_cache with hits buffered in a read buffer.
+ * get_value and peek_value only record the hit and drain the buffer
+ * once the thread's stripe is full, so recency keeps up under reads alone.
+ * With shared_reads set they never drain and concurrent readers only
+ * need a shared lock; whoever finds the stripe full then drains under
+ * the exclusive lock, as the sharded cache does. put drains the buffer
+ * before it changes anything, buffered entries are therefore never stale
+ */
+LRUCache *init_buffered_cache(size_t capacity);
+
+/*
+ * Apply buffered hits of a cache made by init_buffered_cache.
+ * Caller needs exclusive access. Returns number of entries moved
+ */
+size_t drain_reads(LRUCache *lru);
 int get(LRUCache *lru, const char *key);
 int put(LRUCache *lru, const char *key, char *value);
+
+/*
+ * Binary-safe variants taking explicit key length.
+ * The key is copied, the caller's buffer can be reused right away
+ */
+int get_bytes(LRUCache *lru, const void *key, size_t key_len);
+int put_bytes(LRUCache *lru, const void *key, size_t key_len, void *value, size_t value_len);
+
+/*
+ * Same as put_bytes with explicit weight of the entry.
+ * Fails if the weight alone exceeds the cache's budget (or 4 GiB)
+ */
+int put_weighted(LRUCache *lru, const void *key, size_t key_len, void *value, size_t value_len, size_t weight);
+
+/*
+ * Same as put_bytes, the entry expires "ttl_ms" milliseconds from now.
+ * A plain put of the same key later clears the TTL.
+ * Expired entries miss on lookup and are removed like evictions:
+ * lazily by get_value on caches with exclusive lookups, and by the
+ * timer wheel that every put advances a few steps.
+ * The wheel and timers are only allocated on the first put_ttl
+ */
+int put_ttl(LRUCache *lru, const void *key, size_t key_len, void *value, size_t value_len, u_int64_t ttl_ms);
+
+/*
+ * Advance the timer wheel to the current time, at most "max_steps" steps.
+ * Caller needs exclusive access. Returns number of entries expired
+ */
+size_t expire_entries(LRUCache *lru, size_t max_steps);
+
+/*
+ * Look up value by key without exposing table internals.
+ * On success stores value and its length (either may be NULL)
+ * and returns SUCCESS, FAILURE if the key is not cached.
+ * get_value marks the entry most recently used, peek_value does not
+ */
+int get_value(LRUCache *lru, const void *key, size_t key_len, void **value, size_t *value_len);
+int peek_value(LRUCache *lru, const void *key, size_t key_len, void **value, size_t *value_len);
+
+/*
+ * get_value for "count" keys. values[i] and value_lens[i] receive the
+ * value of keys[i], NULL and 0 on a miss (either array may be NULL).
+ * Keys are hashed LRU_BATCH_SIZE at a time and their probes interleaved
+ * (see lookup_hashed_batch), then the hits of the chunk are promoted in
+ * one pass. Expired entries miss and are left to the timer wheel.
+ * Returns number of hits
+ */
+size_t mget(LRUCache *lru, const void *const *keys, const size_t *key_lens, size_t count,
+            void **values, size_t *value_lens);
+
+/*
+ * put_bytes for "count" pairs, hashing each chunk first and prefetching
+ * the home slots before the inserts run in order.
+ * Returns SUCCESS, or the error of the last pair that failed
+ */
+int mput(LRUCache *lru, const void *const *keys, const size_t *key_lens,
+         void *const *values, const size_t *value_lens, size_t count);
+
+/*
+ * Remove "key" from the cache. Returns SUCCESS,
+ * or FAILURE if the key is not cached
+ */
+int remove_key(LRUCache *lru, const void *key, size_t key_len);
+
+/*
+ * Tell "listener" about every value that leaves the cache, see RemovalReason.
+ * Right away from inside the operation that removed it, or, "deferred",
+ * queued with a copy of its key until take_removals or reclaim_removals.
+ * The queue grows as needed, no removal is ever dropped.
+ * free_lru reports the queued removals, then the remaining entries
+ */
+int set_removal_listener(LRUCache *lru, RemovalListener listener, void *arg, bool deferred);
+
+/*
+ * Move the queued removals into "out", leaving the cache's queue empty.
+ * Needs the same access as a put but is O(1), so a caller holding a lock
+ * can take the queue and deliver it after unlocking.
+ * Returns number of removals taken
+ */
+size_t take_removals(LRUCache *lru, RemovalQueue *out);
+
+/*
+ * Hand "queue" to "listener" LRU_REMOVAL_BATCH removals at a time
+ * and free it. Touches no cache. Returns number of removals delivered
+ */
+size_t deliver_removals(RemovalQueue *queue, RemovalListener listener, void *arg);
+
+/*
+ * take_removals and deliver_removals to the cache's own listener,
+ * for callers with exclusive access
+ */
+size_t reclaim_removals(LRUCache *lru);
+
+/*
+ * Write the cached entries to "path", most recently used first
+ * (see SnapshotHeader): keys, value bytes, weights and what is left of
+ * their TTLs, expired entries skipped. The file replaces "path" only
+ * once complete. Needs the same access as a put
+ */
+int save_snapshot(LRUCache *lru, const char *path);
+
+/*
+ * Fill an empty cache from a snapshot of another one. The file is mapped
+ * and checked, then the most recently used entries that fit are linked
+ * in bulk with their values left in the mapping: nothing is copied or
+ * allocated per value, and nothing is evicted.
+ * Loaded entries start in each policy's entry segment, ordered by recency
+ */
+int load_snapshot(LRUCache *lru, const char *path);
+
+/*
+ * True if "value" was loaded from a snapshot or copied into the value
+ * store and so belongs to the cache: a removal listener must not free it.
+ * Stored bytes stay readable until the next put
+ */
+bool cache_owns_value(const LRUCache *lru, const void *value);
+
+/*
+ * Copy the values of every later put into a value store (see ValueStore)
+ * of "segment_count" segments of "segment_size" bytes (0 for
+ * VALUE_SEGMENT_SIZE), in memory or, given "path", in a file unlinked
+ * once mapped. Callers may free their values as soon as put returns.
+ * When the store runs out of room it reclaims its least recently used
+ * segment, evicting every entry whose value lives there.
+ * Values of entries already cached stay the caller's
+ */
+int enable_value_store(LRUCache *lru, size_t segment_size, size_t segment_count, const char *path);
+
+/*
+ * Count the probe lengths of the cache's hash searches into
+ * stats.probe_lengths. Off by default: every search then updates
+ * one histogram shared by all threads, meant for diagnosing the table
+ */
+int enable_probe_stats(LRUCache *lru);
+
+/*
+ * Start estimating the miss ratio curve of the cache's lookups:
+ * a SHARDS sampler tracking at most "max_keys" keys
+ * (0 for MRC_SAMPLE_KEYS, about 200 KB) sees every get and mget key.
+ * Lookups that miss the sample only pay a hash comparison
+ */
+int enable_mrc_sampler(LRUCache *lru, size_t max_keys);
+
+/*
+ * Estimated miss ratio an LRU cache of "capacity" entries would have
+ * had on the lookups seen since enable_mrc_sampler, e.g. at 2 * capacity
+ * to ask what doubling the cache would buy. Safe while other threads
+ * use the cache
+ */
+double cache_miss_ratio(LRUCache *lru, size_t capacity);
+
+/*
+ * Copy the cache's counters into "out". Safe while other threads
+ * use the cache: each counter is read atomically, but the set is not
+ * one consistent cut, e.g. a hit may be counted before its probe
+ */
+void cache_stats_snapshot(const LRUCache *lru, CacheStats *out);
 void free_lru(LRUCache *lru);
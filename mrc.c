@@ -0,0 +1,215 @@
+/*
+ * mrc.c
+ * Miss ratio curves from spatially sampled reuse distances
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "mrc.h"
+
+#define FULL_THRESHOLD ((u_int64_t)1 << 32)
+
+/*
+ * Bijective scramble, sampling must not follow the table's hash bits.
+ * The result also identifies the key in the stack distance tracker
+ */
+static inline u_int32_t sample_hash(u_int32_t hval) {
+    hval ^= hval >> 16;
+    hval *= 0x85EBCA6Bu;
+    hval ^= hval >> 13;
+    return hval;
+}
+
+static void lock_sampler(MissRatioSampler *sampler) {
+    while (__atomic_test_and_set(&sampler->lock, __ATOMIC_ACQUIRE))
+        ;
+}
+
+static void unlock_sampler(MissRatioSampler *sampler) {
+    __atomic_clear(&sampler->lock, __ATOMIC_RELEASE);
+}
+
+static size_t distance_bucket(double distance) {
+    u_int64_t value = distance < (double)UINT64_MAX ? (u_int64_t)distance : UINT64_MAX;
+    if (value < (1u << MRC_SUB_BITS))
+        return (size_t)value;
+
+    unsigned int exponent = 63 - (unsigned int)__builtin_clzll(value) - MRC_SUB_BITS;
+    return ((size_t)(exponent + 1) << MRC_SUB_BITS) + (size_t)((value >> exponent) & ((1u << MRC_SUB_BITS) - 1));
+}
+
+/*
+ * First distance of "bucket" and the one after its last
+ */
+static void bucket_bounds(size_t bucket, double *low, double *high) {
+    if (bucket < (1u << MRC_SUB_BITS)) {
+        *low = (double)bucket;
+        *high = (double)bucket + 1;
+        return;
+    }
+
+    unsigned int exponent = (unsigned int)(bucket >> MRC_SUB_BITS) - 1;
+    double sub = (double)((bucket & ((1u << MRC_SUB_BITS) - 1)) + (1u << MRC_SUB_BITS));
+    *low = sub * (double)((u_int64_t)1 << exponent);
+    *high = (sub + 1) * (double)((u_int64_t)1 << exponent);
+}
+
+static void heap_push(MissRatioSampler *sampler, u_int32_t hash) {
+    size_t child = sampler->heap_count++;
+    while (child > 0) {
+        size_t parent = (child - 1) / 2;
+        if (sampler->heap[parent] >= hash)
+            break;
+        sampler->heap[child] = sampler->heap[parent];
+        child = parent;
+    }
+    sampler->heap[child] = hash;
+}
+
+static u_int32_t heap_pop(MissRatioSampler *sampler) {
+    u_int32_t top = sampler->heap[0];
+    u_int32_t last = sampler->heap[--sampler->heap_count];
+
+    size_t parent = 0;
+    for (;;) {
+        size_t child = 2 * parent + 1;
+        if (child >= sampler->heap_count)
+            break;
+        if (child + 1 < sampler->heap_count && sampler->heap[child + 1] > sampler->heap[child])
+            child++;
+        if (last >= sampler->heap[child])
+            break;
+        sampler->heap[parent] = sampler->heap[child];
+        parent = child;
+    }
+    if (sampler->heap_count > 0)
+        sampler->heap[parent] = last;
+
+    return top;
+}
+
+/*
+ * Too many keys: sample only below the largest tracked hash
+ * and rescale what was counted at the old rate
+ */
+static void lower_threshold(MissRatioSampler *sampler) {
+    u_int64_t old_threshold = sampler->threshold;
+    u_int32_t top = sampler->heap[0];
+    while (sampler->heap_count > 0 && sampler->heap[0] == top)
+        heap_pop(sampler);
+    sampler->threshold = top;
+
+    stack_distance_remove(sampler->stack, top);
+
+    double scale = (double)sampler->threshold / (double)old_threshold;
+    for (size_t i = 0; i < MRC_BUCKETS; i++)
+        sampler->histogram[i] *= scale;
+    sampler->total *= scale;
+}
+
+MissRatioSampler *init_mrc_sampler(size_t max_keys) {
+    if (max_keys == 0) {
+        fprintf(stderr, "Sampler key limit cannot be less than 1!\n");
+        return NULL;
+    }
+
+    MissRatioSampler *sampler = (MissRatioSampler *)calloc(1, sizeof(MissRatioSampler));
+    if (!sampler) {
+        fprintf(stderr, "Could not allocate memory for miss ratio sampler!\n");
+        return NULL;
+    }
+
+    /*
+     * One spare key: the newest sampled key is tracked
+     * before the threshold drops
+     */
+    sampler->threshold = FULL_THRESHOLD;
+    sampler->max_keys = max_keys;
+    sampler->stack = init_stack_distance(max_keys + 1);
+    sampler->heap = (u_int32_t *)malloc((max_keys + 1) * sizeof(u_int32_t));
+    if (!sampler->stack || !sampler->heap) {
+        fprintf(stderr, "Could not allocate memory for sampled keys!\n");
+        free_mrc_sampler(sampler);
+        return NULL;
+    }
+
+    return sampler;
+}
+
+void mrc_access(MissRatioSampler *sampler, u_int32_t hval) {
+    u_int32_t hash = sample_hash(hval);
+    if (hash >= __atomic_load_n(&sampler->threshold, __ATOMIC_RELAXED))
+        return;
+
+    lock_sampler(sampler);
+    /*
+     * The threshold may have dropped while waiting
+     */
+    if (hash >= sampler->threshold) {
+        unlock_sampler(sampler);
+        return;
+    }
+
+    size_t distance = stack_distance_access(sampler->stack, hash);
+    sampler->total += 1;
+    if (distance != STACK_DISTANCE_COLD) {
+        /*
+         * Each of the distance - 1 sampled keys accessed since
+         * stands for 1 / rate keys of the whole stream
+         */
+        double rate = (double)sampler->threshold / (double)FULL_THRESHOLD;
+        sampler->histogram[distance_bucket(1 + (double)(distance - 1) / rate)] += 1;
+    } else {
+        heap_push(sampler, hash);
+        if (sampler->stack->count > sampler->max_keys)
+            lower_threshold(sampler);
+    }
+    unlock_sampler(sampler);
+}
+
+double mrc_miss_ratio(MissRatioSampler *sampler, size_t capacity) {
+    if (!sampler) {
+        fprintf(stderr, "Sampler is not valid or is null!\n");
+        return 1.0;
+    }
+
+    lock_sampler(sampler);
+    double hits = 0;
+    for (size_t i = 0; i < MRC_BUCKETS; i++) {
+        double low, high;
+        bucket_bounds(i, &low, &high);
+        if (high <= (double)capacity + 1) {
+            hits += sampler->histogram[i];
+            continue;
+        }
+
+        /*
+         * Distances spread evenly over the bucket holding "capacity"
+         */
+        if (low <= (double)capacity)
+            hits += sampler->histogram[i] * ((double)capacity + 1 - low) / (high - low);
+        break;
+    }
+    double total = sampler->total;
+    unlock_sampler(sampler);
+
+    return total > 0 ? 1.0 - hits / total : 1.0;
+}
+
+double mrc_sample_rate(const MissRatioSampler *sampler) {
+    return (double)__atomic_load_n(&sampler->threshold, __ATOMIC_RELAXED) / (double)FULL_THRESHOLD;
+}
+
+void free_mrc_sampler(MissRatioSampler *sampler) {
+    if (!sampler) {
+        fprintf(stderr, "Sampler is not valid or is null!\n");
+        return;
+    }
+
+    if (sampler->stack)
+        free_stack_distance(sampler->stack);
+    free(sampler->heap);
+    free(sampler);
+}
@@ -0,0 +1,85 @@
+#ifndef _MRC_H_
+#define _MRC_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+#include "stack_distance.h"
+
+#define SUCCESS 0
+#define FAILURE -1
+#define IS_NULL -2
+
+/*
+ * Keys a sampler tracks by default: about 200 KB in all
+ */
+#ifndef MRC_SAMPLE_KEYS
+#define MRC_SAMPLE_KEYS 4000
+#endif
+
+/*
+ * Reuse distance buckets: 16 linear sub-buckets per power of two
+ */
+#define MRC_SUB_BITS 4
+#define MRC_BUCKETS (64 << MRC_SUB_BITS)
+
+/*
+ * Online miss ratio curve estimator, fixed-size SHARDS
+ * (Waldspurger et al., "Efficient MRC Construction with SHARDS").
+ * A key is sampled when its scrambled hash falls under "threshold",
+ * so the sample rate is threshold / 2^32 and a sampled key is sampled
+ * on every access. Sampled accesses go through a stack distance tracker,
+ * distances scaled by 1 / rate land in a histogram.
+ * At most "max_keys" keys are tracked: once more are sampled, the
+ * threshold drops to the largest tracked hash, whose keys leave, and
+ * the histogram is scaled down to the new rate. Memory is fixed by
+ * "max_keys" (about 50 bytes each) whatever the size of the cache.
+ *
+ * Unsampled accesses only compare the hash with the threshold.
+ * Sampled ones take a spin lock, so lookups running under a shared
+ * lock may feed the same sampler
+ */
+typedef struct MissRatioSampler {
+    u_int64_t threshold;
+    size_t max_keys;
+    StackDistance *stack;
+
+    /*
+     * Max-heap of the tracked hashes
+     */
+    u_int32_t *heap;
+    size_t heap_count;
+
+    /*
+     * Sampled accesses, in units of the current rate
+     */
+    double histogram[MRC_BUCKETS];
+    double total;
+    bool lock;
+} MissRatioSampler;
+
+/*
+ * Initialize sampler tracking at most "max_keys" keys
+ */
+MissRatioSampler *init_mrc_sampler(size_t max_keys);
+
+/*
+ * Record an access of the key hashing to "hval"
+ */
+void mrc_access(MissRatioSampler *sampler, u_int32_t hval);
+
+/*
+ * Estimated miss ratio of an LRU cache of "capacity" entries
+ * over the accesses recorded so far, 1 before the first one
+ */
+double mrc_miss_ratio(MissRatioSampler *sampler, size_t capacity);
+
+/*
+ * Current sample rate, 1 until "max_keys" keys were seen
+ */
+double mrc_sample_rate(const MissRatioSampler *sampler);
+
+void free_mrc_sampler(MissRatioSampler *sampler);
+
+#endif // _MRC_H_
@@ -0,0 +1,660 @@
+/*
+ * policy.c
+ * Eviction policies of the cache
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lru_cache.h"
+#include "sketch.h"
+
+/*
+ * Segments of multi-list policies
+ * Cold entries live in the cache's dll: SLRU probation, 2Q A1in, ARC T1.
+ * Hot entries live in the policy's own list: SLRU protected, 2Q Am, ARC T2.
+ * W-TinyLFU keeps its window in the dll and splits main into
+ * probation and protected lists
+ */
+#define SEGMENT_COLD 0
+#define SEGMENT_HOT 1
+#define SEGMENT_WINDOW 0
+#define SEGMENT_PROBATION 1
+#define SEGMENT_PROTECTED 2
+#define SEGMENT_COUNT 3
+
+/*
+ * Key of an evicted entry remembered by 2Q and ARC
+ * Only the key's hash is kept, a collision merely counts
+ * as a ghost hit for a key that was never cached
+ */
+typedef struct GhostEntry {
+    HashEntry hash_entry;
+    Node node;
+    Fnv32_t key_hash;
+    unsigned char segment;
+} GhostEntry;
+
+/*
+ * State shared by the segmented policies
+ * lists[0] is the cache's dll, further lists belong to the policy.
+ * Ghost entries come from a pool preallocated at init,
+ * so eviction never allocates
+ */
+typedef struct SegmentState {
+    DLL *lists[SEGMENT_COUNT];
+    size_t hot_max;
+    size_t cold_max;
+    size_t ghost_max;
+    size_t target;
+    bool adapted;
+    size_t window_max;
+    FrequencySketch *sketch;
+    HashTable *ghost_index;
+    SlabPool *ghost_pool;
+    DLL *ghosts[2];
+} SegmentState;
+
+static inline SegmentState *segment_state(LRUCache *lru) {
+    return (SegmentState *)lru->policy_state;
+}
+
+static inline DLL *segment_list(LRUCache *lru, LRUEntry *entry) {
+    return segment_state(lru)->lists[entry->segment];
+}
+
+static inline LRUEntry *list_tail(DLL *dll) {
+    return dll->tail ? (LRUEntry *)dll->tail->data : NULL;
+}
+
+/*
+ * Move entry to the front of another segment
+ */
+static int move_to_segment(LRUCache *lru, LRUEntry *entry, unsigned char segment) {
+    if (unlink_node(segment_list(lru, entry), &entry->node) != SUCCESS)
+        return FAILURE;
+
+    entry->segment = segment;
+    return link_at_front(segment_list(lru, entry), &entry->node);
+}
+
+/*
+ * GHOSTS
+ * Hashes are already mixed, the ghost index uses them as they are
+ */
+static Fnv32_t ghost_hash(const void *key, size_t len) {
+    Fnv32_t hval;
+    (void)len;
+    memcpy(&hval, key, sizeof(hval));
+
+    return hval;
+}
+
+static GhostEntry *ghost_find(SegmentState *state, Fnv32_t hval) {
+    return (GhostEntry *)lookup_hashed_entry((const char *)&hval, sizeof(hval), hval, state->ghost_index);
+}
+
+static int ghost_remove(SegmentState *state, GhostEntry *ghost) {
+    int index = search_hashed_entry(ghost->hash_entry.key, sizeof(Fnv32_t), ghost->key_hash, state->ghost_index);
+    if (index < 0 || unlink_hash_entry(state->ghost_index, index, false) != SUCCESS)
+        return FAILURE;
+
+    unlink_node(state->ghosts[ghost->segment], &ghost->node);
+    slab_free(state->ghost_pool, ghost);
+
+    return SUCCESS;
+}
+
+static int ghost_drop_oldest(SegmentState *state, unsigned char segment) {
+    Node *tail = state->ghosts[segment]->tail;
+    if (!tail)
+        return FAILURE;
+
+    return ghost_remove(state, (GhostEntry *)tail->data);
+}
+
+/*
+ * Ghosts never outgrow the pool sized at init: weighted caches can evict
+ * several entries per insert, so when the pool is used up the oldest ghost
+ * of the same list (or of the other one) is forgotten first
+ */
+static int ghost_add(SegmentState *state, unsigned char segment, Fnv32_t hval) {
+    GhostEntry *ghost = ghost_find(state, hval);
+    if (ghost && ghost_remove(state, ghost) != SUCCESS)
+        return FAILURE;
+
+    if (state->ghost_pool->count_used == state->ghost_pool->count_total
+            && ghost_drop_oldest(state, segment) != SUCCESS
+            && ghost_drop_oldest(state, !segment) != SUCCESS)
+        return FAILURE;
+
+    ghost = (GhostEntry *)slab_alloc(state->ghost_pool);
+    if (!ghost) {
+        fprintf(stderr, "Could not allocate ghost entry!\n");
+        return IS_NULL;
+    }
+
+    ghost->key_hash = hval;
+    ghost->segment = segment;
+    ghost->hash_entry.key = (const char *)&ghost->key_hash;
+    ghost->hash_entry.key_len = sizeof(ghost->key_hash);
+    ghost->hash_entry.hash = hval;
+    ghost->node.data = (void *)ghost;
+
+    link_at_front(state->ghosts[segment], &ghost->node);
+    if (link_hash_entry(&ghost->hash_entry, state->ghost_index, false) < 0) {
+        unlink_node(state->ghosts[segment], &ghost->node);
+        slab_free(state->ghost_pool, ghost);
+        return FAILURE;
+    }
+
+    return SUCCESS;
+}
+
+/*
+ * Allocate state with "list_count" segments,
+ * and room for "ghost_capacity" ghosts
+ */
+static int init_segments(LRUCache *lru, int list_count, size_t ghost_capacity) {
+    SegmentState *state = (SegmentState *)calloc(1, sizeof(SegmentState));
+    if (!state) {
+        fprintf(stderr, "Could not allocate memory for policy state!\n");
+        return IS_NULL;
+    }
+    lru->policy_state = state;
+
+    state->lists[0] = lru->dll;
+    for (int i = 1; i < list_count; i++) {
+        state->lists[i] = init_linked_list();
+        if (!state->lists[i])
+            return IS_NULL;
+    }
+
+    if (ghost_capacity == 0)
+        return SUCCESS;
+
+    state->ghost_index = init_robin_hood_table(ghost_capacity + ghost_capacity / 9 + 1);
+    state->ghost_pool = init_slab_pool(sizeof(GhostEntry), ghost_capacity);
+    state->ghosts[0] = init_linked_list();
+    state->ghosts[1] = init_linked_list();
+    if (!state->ghost_index || !state->ghost_pool || !state->ghosts[0] || !state->ghosts[1])
+        return IS_NULL;
+
+    state->ghost_index->owns_entries = false;
+    state->ghost_index->hash_fn = ghost_hash;
+
+    return SUCCESS;
+}
+
+/*
+ * List nodes are embedded in entries, only list headers are freed
+ */
+static void free_segments(LRUCache *lru) {
+    SegmentState *state = segment_state(lru);
+    if (!state)
+        return;
+
+    for (int i = 1; i < SEGMENT_COUNT; i++)
+        free(state->lists[i]);
+    if (state->sketch)
+        free_frequency_sketch(state->sketch);
+    if (state->ghost_index)
+        free_table(state->ghost_index);
+    if (state->ghost_pool)
+        free_slab_pool(state->ghost_pool);
+    free(state->ghosts[0]);
+    free(state->ghosts[1]);
+    free(state);
+    lru->policy_state = NULL;
+}
+
+static int segment_insert_cold(LRUCache *lru, LRUEntry *entry) {
+    entry->segment = SEGMENT_COLD;
+    return link_at_front(lru->dll, &entry->node);
+}
+
+/*
+ * Snapshot entries of an empty cache: nothing to promote them
+ * or to remember, they all start cold
+ */
+static int segment_load_cold(LRUCache *lru, LRUEntry *entry) {
+    entry->segment = SEGMENT_COLD;
+    return link_at_end(lru->dll, &entry->node);
+}
+
+static int segment_remove(LRUCache *lru, LRUEntry *entry) {
+    return unlink_node(segment_list(lru, entry), &entry->node);
+}
+
+/*
+ * LRU
+ */
+static int lru_on_hit(LRUCache *lru, LRUEntry *entry) {
+    return move_to_front(lru->dll, &entry->node);
+}
+
+static int lru_on_insert(LRUCache *lru, LRUEntry *entry) {
+    return link_at_front(lru->dll, &entry->node);
+}
+
+static int lru_on_load(LRUCache *lru, LRUEntry *entry) {
+    return link_at_end(lru->dll, &entry->node);
+}
+
+static LRUEntry *lru_choose_victim(LRUCache *lru, Fnv32_t hval) {
+    (void)hval;
+    return list_tail(lru->dll);
+}
+
+static int lru_on_remove(LRUCache *lru, LRUEntry *entry) {
+    return unlink_node(lru->dll, &entry->node);
+}
+
+/*
+ * Only the cache's dll holds entries
+ */
+static DLL *single_list(LRUCache *lru, size_t rank) {
+    return rank == 0 ? lru->dll : NULL;
+}
+
+const EvictionPolicy lru_policy = {
+    .name = "lru",
+    .concurrent_hits = false,
+    .init = NULL,
+    .on_hit = lru_on_hit,
+    .on_insert = lru_on_insert,
+    .choose_victim = lru_choose_victim,
+    .on_remove = lru_on_remove,
+    .ranked_list = single_list,
+    .on_load = lru_on_load,
+    .free = NULL,
+};
+
+/*
+ * CLOCK
+ * Sets the reference bit unless it is already set,
+ * so repeated hits leave the entry's cache line clean
+ */
+static int clock_on_hit(LRUCache *lru, LRUEntry *entry) {
+    (void)lru;
+    if (!__atomic_load_n(&entry->referenced, __ATOMIC_RELAXED))
+        __atomic_store_n(&entry->referenced, 1, __ATOMIC_RELAXED);
+
+    return SUCCESS;
+}
+
+/*
+ * The tail is the clock hand. Referenced entries lose their bit
+ * and go around again, after one full turn every bit is clear
+ * so the sweep ends within capacity steps
+ */
+static LRUEntry *clock_choose_victim(LRUCache *lru, Fnv32_t hval) {
+    (void)hval;
+    LRUEntry *victim = list_tail(lru->dll);
+    while (victim && victim->referenced) {
+        victim->referenced = 0;
+        if (move_to_front(lru->dll, &victim->node) != SUCCESS)
+            return NULL;
+        victim = list_tail(lru->dll);
+    }
+
+    return victim;
+}
+
+const EvictionPolicy clock_policy = {
+    .name = "clock",
+    .concurrent_hits = true,
+    .init = NULL,
+    .on_hit = clock_on_hit,
+    .on_insert = lru_on_insert,
+    .choose_victim = clock_choose_victim,
+    .on_remove = lru_on_remove,
+    .ranked_list = single_list,
+    .on_load = lru_on_load,
+    .free = NULL,
+};
+
+/*
+ * SEGMENTED LRU
+ * New entries start in probation, a hit promotes them to protected.
+ * Protected overflow is demoted back to the front of probation
+ */
+static int slru_init(LRUCache *lru) {
+    if (init_segments(lru, 2, 0) != SUCCESS)
+        return FAILURE;
+
+    segment_state(lru)->hot_max = lru->capacity - lru->capacity / 5;
+
+    return SUCCESS;
+}
+
+static int slru_on_hit(LRUCache *lru, LRUEntry *entry) {
+    SegmentState *state = segment_state(lru);
+    if (entry->segment == SEGMENT_HOT)
+        return move_to_front(state->lists[SEGMENT_HOT], &entry->node);
+
+    if (move_to_segment(lru, entry, SEGMENT_HOT) != SUCCESS)
+        return FAILURE;
+
+    if (state->lists[SEGMENT_HOT]->list_size > state->hot_max)
+        return move_to_segment(lru, list_tail(state->lists[SEGMENT_HOT]), SEGMENT_COLD);
+
+    return SUCCESS;
+}
+
+static LRUEntry *slru_choose_victim(LRUCache *lru, Fnv32_t hval) {
+    (void)hval;
+    LRUEntry *victim = list_tail(lru->dll);
+
+    return victim ? victim : list_tail(segment_state(lru)->lists[SEGMENT_HOT]);
+}
+
+/*
+ * Hot segment ahead of the cold one
+ */
+static DLL *hot_cold_lists(LRUCache *lru, size_t rank) {
+    SegmentState *state = segment_state(lru);
+    if (rank == 0)
+        return state->lists[SEGMENT_HOT];
+    return rank == 1 ? state->lists[SEGMENT_COLD] : NULL;
+}
+
+const EvictionPolicy slru_policy = {
+    .name = "slru",
+    .concurrent_hits = false,
+    .init = slru_init,
+    .on_hit = slru_on_hit,
+    .on_insert = segment_insert_cold,
+    .choose_victim = slru_choose_victim,
+    .on_remove = segment_remove,
+    .ranked_list = hot_cold_lists,
+    .on_load = segment_load_cold,
+    .free = free_segments,
+};
+
+/*
+ * 2Q
+ * First access goes to the A1in FIFO, hits there are ignored as
+ * correlated references. Keys evicted from A1in are remembered in
+ * the A1out ghost list, seeing them again admits them to the Am LRU
+ */
+static int two_queue_init(LRUCache *lru) {
+    size_t ghost_max = lru->capacity / 2 ? lru->capacity / 2 : 1;
+    if (init_segments(lru, 2, ghost_max + 1) != SUCCESS)
+        return FAILURE;
+
+    SegmentState *state = segment_state(lru);
+    state->cold_max = lru->capacity / 4 ? lru->capacity / 4 : 1;
+    state->ghost_max = ghost_max;
+
+    return SUCCESS;
+}
+
+static int two_queue_on_hit(LRUCache *lru, LRUEntry *entry) {
+    if (entry->segment == SEGMENT_HOT)
+        return move_to_front(segment_state(lru)->lists[SEGMENT_HOT], &entry->node);
+
+    return SUCCESS;
+}
+
+static int two_queue_on_insert(LRUCache *lru, LRUEntry *entry) {
+    SegmentState *state = segment_state(lru);
+    GhostEntry *ghost = ghost_find(state, entry->hash_entry.hash);
+    if (!ghost)
+        return segment_insert_cold(lru, entry);
+
+    if (ghost_remove(state, ghost) != SUCCESS)
+        return FAILURE;
+
+    entry->segment = SEGMENT_HOT;
+    return link_at_front(state->lists[SEGMENT_HOT], &entry->node);
+}
+
+static LRUEntry *two_queue_choose_victim(LRUCache *lru, Fnv32_t hval) {
+    (void)hval;
+    SegmentState *state = segment_state(lru);
+    if (lru->dll->list_size <= state->cold_max && state->lists[SEGMENT_HOT]->list_size > 0)
+        return list_tail(state->lists[SEGMENT_HOT]);
+
+    LRUEntry *victim = list_tail(lru->dll);
+    if (!victim)
+        return NULL;
+
+    if (ghost_add(state, 0, victim->hash_entry.hash) != SUCCESS)
+        return NULL;
+    if (state->ghosts[0]->list_size > state->ghost_max)
+        ghost_drop_oldest(state, 0);
+
+    return victim;
+}
+
+const EvictionPolicy two_queue_policy = {
+    .name = "2q",
+    .concurrent_hits = false,
+    .init = two_queue_init,
+    .on_hit = two_queue_on_hit,
+    .on_insert = two_queue_on_insert,
+    .choose_victim = two_queue_choose_victim,
+    .on_remove = segment_remove,
+    .ranked_list = hot_cold_lists,
+    .on_load = segment_load_cold,
+    .free = free_segments,
+};
+
+/*
+ * ARC
+ * T1 holds keys seen once recently, T2 keys seen at least twice.
+ * Ghost lists B1 and B2 remember keys evicted from each, a ghost hit
+ * moves the target size of T1 towards the list that would have hit
+ */
+static int arc_init(LRUCache *lru) {
+    return init_segments(lru, 2, lru->capacity + 2);
+}
+
+/*
+ * Adapt target size of T1 to a hit in ghost list of "segment"
+ */
+static void arc_adapt(LRUCache *lru, unsigned char segment) {
+    SegmentState *state = segment_state(lru);
+    size_t b1 = state->ghosts[0]->list_size;
+    size_t b2 = state->ghosts[1]->list_size;
+
+    if (segment == 0) {
+        size_t delta = b2 > b1 ? b2 / b1 : 1;
+        state->target = state->target + delta < lru->capacity ? state->target + delta : lru->capacity;
+    } else {
+        size_t delta = b1 > b2 ? b1 / b2 : 1;
+        state->target = state->target > delta ? state->target - delta : 0;
+    }
+}
+
+static int arc_on_hit(LRUCache *lru, LRUEntry *entry) {
+    if (entry->segment == SEGMENT_HOT)
+        return move_to_front(segment_state(lru)->lists[SEGMENT_HOT], &entry->node);
+
+    return move_to_segment(lru, entry, SEGMENT_HOT);
+}
+
+static LRUEntry *arc_choose_victim(LRUCache *lru, Fnv32_t hval) {
+    SegmentState *state = segment_state(lru);
+    size_t t1 = lru->dll->list_size;
+
+    GhostEntry *ghost = ghost_find(state, hval);
+    bool in_b2 = false;
+    if (ghost) {
+        if (!state->adapted)
+            arc_adapt(lru, ghost->segment);
+        state->adapted = true;
+        in_b2 = ghost->segment == 1;
+    } else if (t1 == lru->capacity) {
+        /*
+         * T1 fills the whole cache, B1 is empty: drop T1's LRU outright
+         */
+        return list_tail(lru->dll);
+    }
+
+    /*
+     * REPLACE: take from T1 while it is above its target
+     */
+    LRUEntry *victim;
+    unsigned char segment;
+    if (t1 > 0 && (t1 > state->target || (in_b2 && t1 == state->target) || state->lists[SEGMENT_HOT]->list_size == 0)) {
+        victim = list_tail(lru->dll);
+        segment = 0;
+    } else {
+        victim = list_tail(state->lists[SEGMENT_HOT]);
+        segment = 1;
+    }
+
+    if (victim && ghost_add(state, segment, victim->hash_entry.hash) != SUCCESS)
+        return NULL;
+
+    return victim;
+}
+
+static int arc_on_insert(LRUCache *lru, LRUEntry *entry) {
+    SegmentState *state = segment_state(lru);
+    GhostEntry *ghost = ghost_find(state, entry->hash_entry.hash);
+    int result;
+
+    if (ghost) {
+        if (!state->adapted)
+            arc_adapt(lru, ghost->segment);
+        if (ghost_remove(state, ghost) != SUCCESS)
+            return FAILURE;
+        entry->segment = SEGMENT_HOT;
+        result = link_at_front(state->lists[SEGMENT_HOT], &entry->node);
+    } else {
+        result = segment_insert_cold(lru, entry);
+    }
+    state->adapted = false;
+
+    /*
+     * Keep |T1| + |B1| <= c and |T1| + |T2| + |B1| + |B2| <= 2c
+     */
+    size_t c = lru->capacity;
+    while (lru->dll->list_size + state->ghosts[0]->list_size > c && state->ghosts[0]->list_size > 0)
+        ghost_drop_oldest(state, 0);
+    while (lru->dll->list_size + state->lists[SEGMENT_HOT]->list_size + state->ghosts[0]->list_size
+            + state->ghosts[1]->list_size > 2 * c && state->ghosts[1]->list_size > 0)
+        ghost_drop_oldest(state, 1);
+
+    return result;
+}
+
+const EvictionPolicy arc_policy = {
+    .name = "arc",
+    .concurrent_hits = false,
+    .init = arc_init,
+    .on_hit = arc_on_hit,
+    .on_insert = arc_on_insert,
+    .choose_victim = arc_choose_victim,
+    .on_remove = segment_remove,
+    .ranked_list = hot_cold_lists,
+    .on_load = segment_load_cold,
+    .free = free_segments,
+};
+
+/*
+ * W-TINYLFU
+ * New entries enter a small window LRU. When the cache is full the
+ * window's LRU entry competes with main's victim, the key the sketch
+ * has seen less often is evicted. Main is a segmented LRU
+ */
+static int tinylfu_init(LRUCache *lru) {
+    if (init_segments(lru, SEGMENT_COUNT, 0) != SUCCESS)
+        return FAILURE;
+
+    SegmentState *state = segment_state(lru);
+    state->window_max = lru->capacity / 100 ? lru->capacity / 100 : 1;
+    size_t main_max = lru->capacity - state->window_max;
+    state->hot_max = main_max - main_max / 5;
+    state->sketch = init_frequency_sketch(lru->capacity);
+    if (!state->sketch)
+        return IS_NULL;
+
+    return SUCCESS;
+}
+
+static int tinylfu_on_hit(LRUCache *lru, LRUEntry *entry) {
+    SegmentState *state = segment_state(lru);
+    sketch_increment(state->sketch, entry->hash_entry.hash);
+
+    switch (entry->segment) {
+    case SEGMENT_PROBATION:
+        if (move_to_segment(lru, entry, SEGMENT_PROTECTED) != SUCCESS)
+            return FAILURE;
+        if (state->lists[SEGMENT_PROTECTED]->list_size > state->hot_max)
+            return move_to_segment(lru, list_tail(state->lists[SEGMENT_PROTECTED]), SEGMENT_PROBATION);
+        return SUCCESS;
+    default:
+        return move_to_front(segment_list(lru, entry), &entry->node);
+    }
+}
+
+/*
+ * While the cache is not full, window overflow goes straight to probation
+ */
+static int tinylfu_on_insert(LRUCache *lru, LRUEntry *entry) {
+    SegmentState *state = segment_state(lru);
+    sketch_increment(state->sketch, entry->hash_entry.hash);
+
+    entry->segment = SEGMENT_WINDOW;
+    if (link_at_front(lru->dll, &entry->node) != SUCCESS)
+        return FAILURE;
+
+    while (lru->dll->list_size > state->window_max) {
+        if (move_to_segment(lru, list_tail(lru->dll), SEGMENT_PROBATION) != SUCCESS)
+            return FAILURE;
+    }
+
+    return SUCCESS;
+}
+
+static LRUEntry *tinylfu_choose_victim(LRUCache *lru, Fnv32_t hval) {
+    (void)hval;
+    SegmentState *state = segment_state(lru);
+    LRUEntry *candidate = list_tail(lru->dll);
+    LRUEntry *victim = list_tail(state->lists[SEGMENT_PROBATION]);
+    if (!victim)
+        victim = list_tail(state->lists[SEGMENT_PROTECTED]);
+
+    if (!candidate || !victim)
+        return candidate ? candidate : victim;
+
+    /*
+     * Admission: the candidate replaces main's victim only if it is
+     * more popular, ties keep the entry already in main
+     */
+    if (sketch_frequency(state->sketch, candidate->hash_entry.hash)
+            <= sketch_frequency(state->sketch, victim->hash_entry.hash))
+        return candidate;
+
+    if (move_to_segment(lru, candidate, SEGMENT_PROBATION) != SUCCESS)
+        return NULL;
+
+    return victim;
+}
+
+/*
+ * Protected, then the window of recent entries, then probation
+ */
+static DLL *tinylfu_ranked_list(LRUCache *lru, size_t rank) {
+    static const int ranks[] = { SEGMENT_PROTECTED, SEGMENT_WINDOW, SEGMENT_PROBATION };
+
+    return rank < sizeof(ranks) / sizeof(ranks[0]) ? segment_state(lru)->lists[ranks[rank]] : NULL;
+}
+
+const EvictionPolicy tinylfu_policy = {
+    .name = "tinylfu",
+    .concurrent_hits = false,
+    .init = tinylfu_init,
+    .on_hit = tinylfu_on_hit,
+    .on_insert = tinylfu_on_insert,
+    .choose_victim = tinylfu_choose_victim,
+    .on_remove = segment_remove,
+    .ranked_list = tinylfu_ranked_list,
+    .on_load = NULL,
+    .free = free_segments,
+};
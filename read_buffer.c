@@ -0,0 +1,113 @@
+/*
+ * read_buffer.c
+ * Striped lossy ring buffers for batching cache hits
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "read_buffer.h"
+
+/*
+ * Threads get stripes round robin on first use,
+ * 0 means the thread has no stripe yet
+ */
+static unsigned int next_stripe;
+static _Thread_local unsigned int thread_stripe;
+
+static ReadStripe *current_stripe(ReadBuffer *buffer) {
+    if (thread_stripe == 0)
+        thread_stripe = __atomic_add_fetch(&next_stripe, 1, __ATOMIC_RELAXED);
+
+    return &buffer->stripes[thread_stripe & (READ_BUFFER_STRIPES - 1)];
+}
+
+ReadBuffer *init_read_buffer(void) {
+    ReadBuffer *buffer = (ReadBuffer *)aligned_alloc(64, sizeof(ReadBuffer));
+    if (!buffer) {
+        fprintf(stderr, "Could not allocate memory for read buffer!\n");
+        return NULL;
+    }
+
+    for (size_t i = 0; i < READ_BUFFER_STRIPES; i++) {
+        ReadStripe *stripe = &buffer->stripes[i];
+        stripe->reads = 0;
+        stripe->writes = 0;
+        for (size_t j = 0; j < READ_BUFFER_SIZE; j++)
+            stripe->items[j] = NULL;
+    }
+
+    return buffer;
+}
+
+int record_read(ReadBuffer *buffer, void *item) {
+    if (!buffer || !item) {
+        fprintf(stderr, "Read buffer or item is not valid or is null!\n");
+        return IS_NULL;
+    }
+
+    ReadStripe *stripe = current_stripe(buffer);
+    size_t reads = __atomic_load_n(&stripe->reads, __ATOMIC_RELAXED);
+    size_t writes = __atomic_load_n(&stripe->writes, __ATOMIC_RELAXED);
+    if (writes - reads >= READ_BUFFER_SIZE)
+        return FAILURE;
+
+    /*
+     * Losing the race to another thread sharing the stripe
+     * drops the record, a hit is only a hint
+     */
+    if (!__atomic_compare_exchange_n(&stripe->writes, &writes, writes + 1, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+        return FAILURE;
+
+    __atomic_store_n(&stripe->items[writes & (READ_BUFFER_SIZE - 1)], item, __ATOMIC_RELEASE);
+
+    return SUCCESS;
+}
+
+bool read_buffer_full(ReadBuffer *buffer) {
+    if (!buffer)
+        return false;
+
+    ReadStripe *stripe = current_stripe(buffer);
+    size_t reads = __atomic_load_n(&stripe->reads, __ATOMIC_RELAXED);
+    size_t writes = __atomic_load_n(&stripe->writes, __ATOMIC_RELAXED);
+
+    return writes - reads >= READ_BUFFER_SIZE;
+}
+
+size_t drain_read_buffer(ReadBuffer *buffer, void (*apply)(void *item, void *arg), void *arg) {
+    if (!buffer || !apply) {
+        fprintf(stderr, "Read buffer or drain function is not valid or is null!\n");
+        return 0;
+    }
+
+    size_t applied = 0;
+    for (size_t i = 0; i < READ_BUFFER_STRIPES; i++) {
+        ReadStripe *stripe = &buffer->stripes[i];
+        size_t writes = __atomic_load_n(&stripe->writes, __ATOMIC_ACQUIRE);
+
+        for (size_t slot = stripe->reads; slot != writes; slot++) {
+            void **item = &stripe->items[slot & (READ_BUFFER_SIZE - 1)];
+            void *recorded = __atomic_load_n(item, __ATOMIC_ACQUIRE);
+            if (recorded) {
+                apply(recorded, arg);
+                applied++;
+            }
+            *item = NULL;
+        }
+
+        __atomic_store_n(&stripe->reads, writes, __ATOMIC_RELEASE);
+    }
+
+    return applied;
+}
+
+void free_read_buffer(ReadBuffer *buffer) {
+    if (!buffer) {
+        fprintf(stderr, "Read buffer is not valid or is null!\n");
+        return;
+    }
+
+    free(buffer);
+}
@@ -0,0 +1,65 @@
+#ifndef _READ_BUFFER_H_
+#define _READ_BUFFER_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#define SUCCESS 0
+#define FAILURE -1
+#define IS_NULL -2
+
+/*
+ * Stripes and slots per stripe, both powers of two
+ */
+#ifndef READ_BUFFER_STRIPES
+#define READ_BUFFER_STRIPES 16
+#endif
+#ifndef READ_BUFFER_SIZE
+#define READ_BUFFER_SIZE 32
+#endif
+
+/*
+ * Ring of recorded items
+ * "writes" is advanced by any number of recording threads,
+ * "reads" only by the single thread draining the buffer.
+ * Padded to a cache line so stripes do not share lines
+ */
+typedef struct ReadStripe {
+    size_t reads;
+    size_t writes;
+    void *items[READ_BUFFER_SIZE];
+} __attribute__((aligned(64))) ReadStripe;
+
+/*
+ * Lossy buffer of cache hits waiting to be applied in batches
+ * Every thread records into its own stripe, a full stripe
+ * drops new records instead of waiting for the drain
+ */
+typedef struct ReadBuffer {
+    ReadStripe stripes[READ_BUFFER_STRIPES];
+} ReadBuffer;
+
+ReadBuffer *init_read_buffer(void);
+
+/*
+ * Record "item" in the calling thread's stripe.
+ * Safe to call concurrently with other recorders, not with a drain.
+ * Returns SUCCESS, or FAILURE if the record was dropped
+ */
+int record_read(ReadBuffer *buffer, void *item);
+
+/*
+ * True once the calling thread's stripe has no free slot left
+ */
+bool read_buffer_full(ReadBuffer *buffer);
+
+/*
+ * Call "apply" on every recorded item, stripe by stripe in record order,
+ * and empty the buffer. Caller must exclude recorders and other drains.
+ * Returns the number of items applied
+ */
+size_t drain_read_buffer(ReadBuffer *buffer, void (*apply)(void *item, void *arg), void *arg);
+
+void free_read_buffer(ReadBuffer *buffer);
+
+#endif // _READ_BUFFER_H_
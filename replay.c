@@ -0,0 +1,298 @@
+/*
+ * replay.c
+ * Hit ratio of recorded key traces against a range of cache sizes.
+ *
+ * usage: replay -c capacities [-p policy] [-b] [-x] [-o out.bin] [trace]
+ *
+ * capacities: comma separated sizes, "lo:hi" expands to lo, 2lo, 4lo... <= hi
+ * policy:     lru (default), clock, buffered, slru, 2q, arc, tinylfu
+ * trace:      file to read, standard input if omitted or "-"
+ *
+ * Text traces hold one key per line. Binary traces (-b) start with the
+ * 8 bytes "LRUTRC01" followed by little-endian 64 bit key ids; -o writes
+ * one, text keys becoming the MurmurHash64A of their bytes.
+ *
+ * Every request is a read-through lookup: a miss puts the key.
+ * LRU hit ratios of all sizes come from one stack distance pass that
+ * only tracks as many keys as the largest size (-x replays LRUCache
+ * at every size instead, as other policies always do).
+ * The trace is streamed, memory depends on the sizes, not on its length
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "lru_cache.h"
+#include "stack_distance.h"
+
+#define MAX_CAPACITIES 64
+#define RECORD_CHUNK 4096
+
+static const char trace_magic[8] = { 'L', 'R', 'U', 'T', 'R', 'C', '0', '1' };
+
+typedef struct ReplayCache {
+    const char *name;
+    const EvictionPolicy *policy;
+    bool buffered;
+} ReplayCache;
+
+static const ReplayCache caches[] = {
+    { "lru", &lru_policy, false },
+    { "clock", &clock_policy, false },
+    { "buffered", &lru_policy, true },
+    { "slru", &slru_policy, false },
+    { "2q", &two_queue_policy, false },
+    { "arc", &arc_policy, false },
+    { "tinylfu", &tinylfu_policy, false },
+};
+
+typedef struct Replay {
+    size_t capacities[MAX_CAPACITIES];
+    size_t capacity_count;
+    u_int64_t requests;
+
+    /*
+     * Stack distance pass: hits[d - 1] accesses at distance d
+     */
+    StackDistance *stack;
+    u_int64_t *distances;
+
+    /*
+     * Simulation pass: one cache per capacity
+     */
+    LRUCache *lrus[MAX_CAPACITIES];
+    u_int64_t hits[MAX_CAPACITIES];
+
+    FILE *out;
+} Replay;
+
+static char value[] = "value";
+
+static int compare_sizes(const void *a, const void *b) {
+    size_t x = *(const size_t *)a, y = *(const size_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/*
+ * Parse "1000,5000,100:6400" into sorted capacities
+ */
+static int parse_capacities(Replay *replay, char *list) {
+    for (char *item = strtok(list, ","); item; item = strtok(NULL, ",")) {
+        char *end;
+        size_t low = strtoul(item, &end, 10);
+        size_t high = low;
+        if (*end == ':')
+            high = strtoul(end + 1, &end, 10);
+        if (*end != '\0' || low == 0 || high < low)
+            return FAILURE;
+
+        for (size_t capacity = low; capacity <= high; capacity *= 2) {
+            if (replay->capacity_count == MAX_CAPACITIES)
+                return FAILURE;
+            replay->capacities[replay->capacity_count++] = capacity;
+        }
+    }
+    if (replay->capacity_count == 0)
+        return FAILURE;
+
+    qsort(replay->capacities, replay->capacity_count, sizeof(size_t), compare_sizes);
+
+    return SUCCESS;
+}
+
+static void write_record(Replay *replay, u_int64_t id) {
+    unsigned char bytes[8];
+    for (int i = 0; i < 8; i++)
+        bytes[i] = (unsigned char)(id >> (8 * i));
+
+    if (fwrite(bytes, 1, sizeof(bytes), replay->out) != sizeof(bytes)) {
+        fprintf(stderr, "Could not write binary trace!\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/*
+ * One request: "id" identifies the key for stack distances,
+ * "key" is what the simulated caches store
+ */
+static void replay_request(Replay *replay, u_int64_t id, const void *key, size_t key_len) {
+    replay->requests++;
+    if (replay->out)
+        write_record(replay, id);
+
+    if (replay->stack) {
+        size_t distance = stack_distance_access(replay->stack, id);
+        if (distance != STACK_DISTANCE_COLD)
+            replay->distances[distance - 1]++;
+        return;
+    }
+
+    for (size_t i = 0; i < replay->capacity_count; i++) {
+        LRUCache *lru = replay->lrus[i];
+        if (get_value(lru, key, key_len, NULL, NULL) == SUCCESS)
+            replay->hits[i]++;
+        else
+            put_bytes(lru, key, key_len, value, sizeof(value) - 1);
+    }
+}
+
+static int replay_text(Replay *replay, FILE *trace) {
+    char *line = NULL;
+    size_t line_size = 0;
+    ssize_t len;
+    while ((len = getline(&line, &line_size, trace)) >= 0) {
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+            len--;
+        if (len == 0)
+            continue;
+
+        replay_request(replay, murmur_hash64a(line, (size_t)len, 0), line, (size_t)len);
+    }
+    free(line);
+
+    return ferror(trace) ? FAILURE : SUCCESS;
+}
+
+static int replay_binary(Replay *replay, FILE *trace) {
+    char magic[sizeof(trace_magic)];
+    if (fread(magic, 1, sizeof(magic), trace) != sizeof(magic) || memcmp(magic, trace_magic, sizeof(magic)) != 0) {
+        fprintf(stderr, "Trace is not a binary key trace!\n");
+        return FAILURE;
+    }
+
+    static unsigned char records[RECORD_CHUNK * 8];
+    size_t count;
+    while ((count = fread(records, 8, RECORD_CHUNK, trace)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            u_int64_t id = 0;
+            for (int b = 7; b >= 0; b--)
+                id = (id << 8) | records[i * 8 + b];
+            replay_request(replay, id, &id, sizeof(id));
+        }
+    }
+
+    return ferror(trace) ? FAILURE : SUCCESS;
+}
+
+static void print_results(const Replay *replay, const char *policy) {
+    printf("policy,capacity,requests,hits,hit_ratio\n");
+
+    u_int64_t hits = 0;
+    size_t depth = 0;
+    for (size_t i = 0; i < replay->capacity_count; i++) {
+        if (replay->stack) {
+            for (; depth < replay->capacities[i]; depth++)
+                hits += replay->distances[depth];
+        } else {
+            hits = replay->hits[i];
+        }
+
+        printf("%s,%zu,%llu,%llu,%.4f\n", policy, replay->capacities[i], (unsigned long long)replay->requests,
+               (unsigned long long)hits, replay->requests ? (double)hits / (double)replay->requests : 0.0);
+    }
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "usage: %s -c capacities [-p lru|clock|buffered|slru|2q|arc|tinylfu] [-b] [-x] [-o out.bin] [trace]\n",
+            name);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+    static Replay replay;
+    const ReplayCache *cache = &caches[0];
+    bool binary = false, simulate = false;
+    const char *out_path = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "c:p:bxo:")) != -1) {
+        switch (opt) {
+        case 'c':
+            if (parse_capacities(&replay, optarg) != SUCCESS)
+                usage(argv[0]);
+            break;
+        case 'p':
+            cache = NULL;
+            for (size_t p = 0; p < sizeof(caches) / sizeof(caches[0]); p++) {
+                if (strcmp(optarg, caches[p].name) == 0)
+                    cache = &caches[p];
+            }
+            if (!cache)
+                usage(argv[0]);
+            break;
+        case 'b':
+            binary = true;
+            break;
+        case 'x':
+            simulate = true;
+            break;
+        case 'o':
+            out_path = optarg;
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (replay.capacity_count == 0 || argc - optind > 1)
+        usage(argv[0]);
+
+    FILE *trace = stdin;
+    if (optind < argc && strcmp(argv[optind], "-") != 0) {
+        trace = fopen(argv[optind], "rb");
+        if (!trace) {
+            fprintf(stderr, "Could not open trace %s!\n", argv[optind]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (out_path) {
+        replay.out = fopen(out_path, "wb");
+        if (!replay.out || fwrite(trace_magic, 1, sizeof(trace_magic), replay.out) != sizeof(trace_magic)) {
+            fprintf(stderr, "Could not create binary trace %s!\n", out_path);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    size_t max_capacity = replay.capacities[replay.capacity_count - 1];
+    if (cache->policy == &lru_policy && !cache->buffered && !simulate) {
+        replay.stack = init_stack_distance(max_capacity);
+        replay.distances = (u_int64_t *)calloc(max_capacity, sizeof(u_int64_t));
+        if (!replay.stack || !replay.distances)
+            exit(EXIT_FAILURE);
+    } else {
+        for (size_t i = 0; i < replay.capacity_count; i++) {
+            if (cache->buffered)
+                replay.lrus[i] = init_buffered_cache(replay.capacities[i]);
+            else
+                replay.lrus[i] = init_policy_cache(replay.capacities[i], cache->policy);
+            if (!replay.lrus[i])
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    int result = binary ? replay_binary(&replay, trace) : replay_text(&replay, trace);
+    if (result != SUCCESS) {
+        fprintf(stderr, "Could not read trace!\n");
+        exit(EXIT_FAILURE);
+    }
+    print_results(&replay, cache->name);
+
+    if (replay.out && fclose(replay.out) != 0) {
+        fprintf(stderr, "Could not write binary trace %s!\n", out_path);
+        exit(EXIT_FAILURE);
+    }
+    if (trace != stdin)
+        fclose(trace);
+    if (replay.stack) {
+        free_stack_distance(replay.stack);
+        free(replay.distances);
+    }
+    for (size_t i = 0; i < replay.capacity_count; i++) {
+        if (replay.lrus[i])
+            free_lru(replay.lrus[i]);
+    }
+
+    return 0;
+}
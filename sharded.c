@@ -0,0 +1,329 @@
+#include <string.h>
+
+#include "sharded.h"
+
+/*
+ * Pick shard from the top bits of the mixed hash.
+ * Shard tables index by the low bits of the same hash,
+ * routing on them would leave most of every table unused
+ */
+static CacheShard *route_key(ShardedLRUCache *cache, const void *key, size_t key_len) {
+    if (cache->shard_count == 1)
+        return cache->shards;
+
+    Fnv32_t hval = fnv_hash(key, key_len) * 0x9E3779B1u;
+    return &cache->shards[hval >> cache->shard_shift];
+}
+
+static ShardedLRUCache *init_shards(size_t capacity, size_t shard_count, const EvictionPolicy *policy, bool buffered) {
+    if (capacity <= 0) {
+        fprintf(stderr, "Capacity cannot be less than 1!\n");
+        return NULL;
+    }
+
+    if (shard_count <= 0) {
+        fprintf(stderr, "Shard count cannot be less than 1!\n");
+        return NULL;
+    }
+
+    /*
+     * Routing takes the top 32 - shard_shift bits of a 32-bit hash
+     */
+    size_t count = 1;
+    unsigned shard_shift = 32;
+    while (count < shard_count && shard_shift > 0) {
+        count <<= 1;
+        shard_shift--;
+    }
+
+    ShardedLRUCache *cache = (ShardedLRUCache *)calloc(1, sizeof(ShardedLRUCache));
+    if (!cache) {
+        fprintf(stderr, "Could not allocate memory for ShardedLRUCache struct!\n");
+        return NULL;
+    }
+
+    cache->capacity = capacity;
+    cache->shard_count = count;
+    cache->shard_shift = shard_shift;
+    cache->shards = (CacheShard *)aligned_alloc(SHARD_CACHE_LINE, count * sizeof(CacheShard));
+    if (!cache->shards) {
+        fprintf(stderr, "Could not allocate memory for cache shards!\n");
+        free(cache);
+        return NULL;
+    }
+
+    size_t shard_capacity = capacity / count;
+    if (shard_capacity == 0)
+        shard_capacity = 1;
+
+    for (size_t i = 0; i < count; i++) {
+        CacheShard *shard = &cache->shards[i];
+        shard->cache = buffered ? init_buffered_cache(shard_capacity) : init_policy_cache(shard_capacity, policy);
+        if (!shard->cache || pthread_rwlock_init(&shard->lock, NULL) != 0) {
+            fprintf(stderr, "Could not initialize cache shard %zu!\n", i);
+            if (shard->cache)
+                free_lru(shard->cache);
+            while (i-- > 0) {
+                pthread_rwlock_destroy(&cache->shards[i].lock);
+                free_lru(cache->shards[i].cache);
+            }
+            free(cache->shards);
+            free(cache);
+            return NULL;
+        }
+
+        /*
+         * Readers share the shard lock, full stripes are drained
+         * by sharded_get with the lock exclusive
+         */
+        if (buffered)
+            shard->cache->shared_reads = true;
+    }
+
+    return cache;
+}
+
+ShardedLRUCache *init_sharded_cache(size_t capacity, size_t shard_count) {
+    return init_shards(capacity, shard_count, &lru_policy, false);
+}
+
+ShardedLRUCache *init_sharded_policy_cache(size_t capacity, size_t shard_count, const EvictionPolicy *policy) {
+    if (!policy) {
+        fprintf(stderr, "Eviction policy is not valid or is null!\n");
+        return NULL;
+    }
+
+    return init_shards(capacity, shard_count, policy, false);
+}
+
+ShardedLRUCache *init_sharded_clock_cache(size_t capacity, size_t shard_count) {
+    return init_shards(capacity, shard_count, &clock_policy, false);
+}
+
+ShardedLRUCache *init_sharded_buffered_cache(size_t capacity, size_t shard_count) {
+    return init_shards(capacity, shard_count, &lru_policy, true);
+}
+
+/*
+ * Release the exclusive lock of a shard. A full batch of deferred
+ * removals is taken along and handed to the listener after unlocking
+ */
+static void unlock_writer(CacheShard *shard) {
+    LRUCache *lru = shard->cache;
+    if (lru->removals.count < LRU_REMOVAL_BATCH) {
+        pthread_rwlock_unlock(&shard->lock);
+        return;
+    }
+
+    RemovalQueue queue;
+    take_removals(lru, &queue);
+    RemovalListener listener = lru->removal_listener;
+    void *arg = lru->removal_arg;
+    pthread_rwlock_unlock(&shard->lock);
+
+    deliver_removals(&queue, listener, arg);
+}
+
+int sharded_get(ShardedLRUCache *cache, const char *key) {
+    if (!key) {
+        fprintf(stderr, "The key provided is invalid or NULL!\n");
+        return IS_NULL;
+    }
+
+    return sharded_get_value(cache, key, strlen(key), NULL, NULL);
+}
+
+int sharded_get_value(ShardedLRUCache *cache, const void *key, size_t key_len, void **value, size_t *value_len) {
+    if (!cache) {
+        fprintf(stderr, "Sharded cache is not valid or is null!\n");
+        return IS_NULL;
+    }
+
+    if (!key && key_len > 0) {
+        fprintf(stderr, "The key provided is invalid or NULL!\n");
+        return IS_NULL;
+    }
+
+    /*
+     * Most policies relink lists on a hit and need the lock exclusive,
+     * CLOCK hits only set an atomic reference bit
+     * and buffered hits only take a read buffer slot
+     */
+    CacheShard *shard = route_key(cache, key, key_len);
+    bool shared = shard->cache->reads || shard->cache->policy->concurrent_hits;
+    if (shared)
+        pthread_rwlock_rdlock(&shard->lock);
+    else
+        pthread_rwlock_wrlock(&shard->lock);
+    int result = get_value(shard->cache, key, key_len, value, value_len);
+    bool drain = read_buffer_full(shard->cache->reads);
+    if (shared)
+        pthread_rwlock_unlock(&shard->lock);
+    else
+        unlock_writer(shard);
+
+    /*
+     * Another thread holding the lock will drain soon enough
+     * or is a writer that drains first, never wait for it
+     */
+    if (drain && pthread_rwlock_trywrlock(&shard->lock) == 0) {
+        drain_reads(shard->cache);
+        pthread_rwlock_unlock(&shard->lock);
+    }
+
+    return result;
+}
+
+int sharded_put(ShardedLRUCache *cache, const char *key, char *value) {
+    if (!key || !value) {
+        fprintf(stderr, "The key or value provided is invalid or NULL!\n");
+        return IS_NULL;
+    }
+
+    return sharded_put_bytes(cache, key, strlen(key), value, strlen(value));
+}
+
+int sharded_put_bytes(ShardedLRUCache *cache, const void *key, size_t key_len, void *value, size_t value_len) {
+    if (!cache) {
+        fprintf(stderr, "Sharded cache is not valid or is null!\n");
+        return IS_NULL;
+    }
+
+    if (!key && key_len > 0) {
+        fprintf(stderr, "The key provided is invalid or NULL!\n");
+        return IS_NULL;
+    }
+
+    CacheShard *shard = route_key(cache, key, key_len);
+    pthread_rwlock_wrlock(&shard->lock);
+    int result = put_bytes(shard->cache, key, key_len, value, value_len);
+    unlock_writer(shard);
+
+    return result;
+}
+
+int sharded_put_ttl(ShardedLRUCache *cache, const void *key, size_t key_len, void *value, size_t value_len, u_int64_t ttl_ms) {
+    if (!cache) {
+        fprintf(stderr, "Sharded cache is not valid or is null!\n");
+        return IS_NULL;
+    }
+
+    if (!key && key_len > 0) {
+        fprintf(stderr, "The key provided is invalid or NULL!\n");
+        return IS_NULL;
+    }
+
+    CacheShard *shard = route_key(cache, key, key_len);
+    pthread_rwlock_wrlock(&shard->lock);
+    int result = put_ttl(shard->cache, key, key_len, value, value_len, ttl_ms);
+    unlock_writer(shard);
+
+    return result;
+}
+
+int sharded_remove(ShardedLRUCache *cache, const void *key, size_t key_len) {
+    if (!cache) {
+        fprintf(stderr, "Sharded cache is not valid or is null!\n");
+        return IS_NULL;
+    }
+
+    if (!key && key_len > 0) {
+        fprintf(stderr, "The key provided is invalid or NULL!\n");
+        return IS_NULL;
+    }
+
+    CacheShard *shard = route_key(cache, key, key_len);
+    pthread_rwlock_wrlock(&shard->lock);
+    int result = remove_key(shard->cache, key, key_len);
+    unlock_writer(shard);
+
+    return result;
+}
+
+int sharded_set_removal_listener(ShardedLRUCache *cache, RemovalListener listener, void *arg, bool deferred) {
+    if (!cache) {
+        fprintf(stderr, "Sharded cache is not valid or is null!\n");
+        return IS_NULL;
+    }
+
+    int result = SUCCESS;
+    for (size_t i = 0; i < cache->shard_count; i++) {
+        CacheShard *shard = &cache->shards[i];
+        pthread_rwlock_wrlock(&shard->lock);
+        if (set_removal_listener(shard->cache, listener, arg, deferred) != SUCCESS)
+            result = FAILURE;
+        pthread_rwlock_unlock(&shard->lock);
+    }
+
+    return result;
+}
+
+size_t sharded_reclaim_removals(ShardedLRUCache *cache) {
+    if (!cache) {
+        fprintf(stderr, "Sharded cache is not valid or is null!\n");
+        return 0;
+    }
+
+    size_t delivered = 0;
+    for (size_t i = 0; i < cache->shard_count; i++) {
+        CacheShard *shard = &cache->shards[i];
+        pthread_rwlock_wrlock(&shard->lock);
+        RemovalQueue queue;
+        take_removals(shard->cache, &queue);
+        RemovalListener listener = shard->cache->removal_listener;
+        void *arg = shard->cache->removal_arg;
+        pthread_rwlock_unlock(&shard->lock);
+
+        delivered += deliver_removals(&queue, listener, arg);
+    }
+
+    return delivered;
+}
+
+size_t sharded_count(ShardedLRUCache *cache) {
+    if (!cache) {
+        fprintf(stderr, "Sharded cache is not valid or is null!\n");
+        return 0;
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < cache->shard_count; i++) {
+        CacheShard *shard = &cache->shards[i];
+        pthread_rwlock_rdlock(&shard->lock);
+        count += shard->cache->hash_table->count_entry;
+        pthread_rwlock_unlock(&shard->lock);
+    }
+
+    return count;
+}
+
+void sharded_stats_snapshot(ShardedLRUCache *cache, CacheStats *out) {
+    if (!cache || !out) {
+        fprintf(stderr, "Sharded cache or stats are not valid or are null!\n");
+        return;
+    }
+
+    memset(out, 0, sizeof(*out));
+    for (size_t i = 0; i < cache->shard_count; i++) {
+        CacheStats shard;
+        cache_stats_snapshot(cache->shards[i].cache, &shard);
+        stats_merge(out, &shard);
+    }
+}
+
+void free_sharded_cache(ShardedLRUCache *cache) {
+    if (!cache) {
+        fprintf(stderr, "Sharded cache is not valid or is null!\n");
+        fprintf(stderr, "Could not free sharded cache!\n");
+        return;
+    }
+
+    for (size_t i = 0; i < cache->shard_count; i++) {
+        pthread_rwlock_destroy(&cache->shards[i].lock);
+        free_lru(cache->shards[i].cache);
+    }
+    free(cache->shards);
+    free(cache);
+
+    return;
+}
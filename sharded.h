@@ -0,0 +1,109 @@
+#ifndef _SHARDED_H_
+#define _SHARDED_H_
+
+#include <pthread.h>
+
+#include "lru_cache.h"
+
+/*
+ * Shards are padded to a cache line so that threads
+ * working on neighbouring shards do not share lock lines
+ */
+#define SHARD_CACHE_LINE 64
+
+/*
+ * One independent LRU cache guarded by its own lock.
+ * Lookups of buffered shards and of policies with concurrent hits
+ * only take the lock shared
+ */
+typedef struct CacheShard {
+    pthread_rwlock_t lock;
+    LRUCache *cache;
+} __attribute__((aligned(SHARD_CACHE_LINE))) CacheShard;
+
+/*
+ * Thread-safe cache split into a power of two number of shards
+ * Keys are routed by hash, so a key always lives in the same shard
+ * and each shard evicts its own least recently used entries
+ */
+typedef struct ShardedLRUCache {
+    size_t capacity;
+    size_t shard_count;
+    unsigned shard_shift;
+    CacheShard *shards;
+} ShardedLRUCache;
+
+/*
+ * Initialize cache holding about "capacity" entries in total,
+ * "shard_count" is rounded up to a power of two.
+ * Every shard gets capacity / shard_count entries (at least one)
+ */
+ShardedLRUCache *init_sharded_cache(size_t capacity, size_t shard_count);
+
+/*
+ * Same as init_sharded_cache with "policy" eviction in every shard
+ */
+ShardedLRUCache *init_sharded_policy_cache(size_t capacity, size_t shard_count, const EvictionPolicy *policy);
+
+/*
+ * Same as init_sharded_cache with CLOCK eviction in every shard
+ */
+ShardedLRUCache *init_sharded_clock_cache(size_t capacity, size_t shard_count);
+
+/*
+ * Same as init_sharded_cache with buffered hits in every shard.
+ * The thread that finds its read buffer stripe full drains the shard's
+ * buffer if it gets the exclusive lock without waiting
+ */
+ShardedLRUCache *init_sharded_buffered_cache(size_t capacity, size_t shard_count);
+
+/*
+ * Same semantics as get/put of LRUCache, each call locks one shard.
+ * The table index returned by get is only valid under the shard lock,
+ * so sharded_get reports SUCCESS or FAILURE instead
+ */
+int sharded_get(ShardedLRUCache *cache, const char *key);
+int sharded_put(ShardedLRUCache *cache, const char *key, char *value);
+int sharded_get_value(ShardedLRUCache *cache, const void *key, size_t key_len, void **value, size_t *value_len);
+int sharded_put_bytes(ShardedLRUCache *cache, const void *key, size_t key_len, void *value, size_t value_len);
+
+/*
+ * put_ttl on the key's shard. Each shard keeps its own timer wheel,
+ * advanced by the puts routed to it
+ */
+int sharded_put_ttl(ShardedLRUCache *cache, const void *key, size_t key_len, void *value, size_t value_len, u_int64_t ttl_ms);
+
+/*
+ * remove_key on the key's shard
+ */
+int sharded_remove(ShardedLRUCache *cache, const void *key, size_t key_len);
+
+/*
+ * set_removal_listener on every shard. Without "deferred" the listener
+ * runs under the shard lock. Deferred removals are handed over in batches
+ * of LRU_REMOVAL_BATCH after the writer that filled one unlocks, so the
+ * listener may take its time or call back into the cache. It runs on
+ * whichever thread unlocked, possibly on several at once
+ */
+int sharded_set_removal_listener(ShardedLRUCache *cache, RemovalListener listener, void *arg, bool deferred);
+
+/*
+ * Deliver the deferred removals still queued in every shard,
+ * returns how many there were
+ */
+size_t sharded_reclaim_removals(ShardedLRUCache *cache);
+
+/*
+ * Number of entries over all shards, locks each shard in turn
+ */
+size_t sharded_count(ShardedLRUCache *cache);
+
+/*
+ * Sum of the counters of all shards, see cache_stats_snapshot.
+ * Takes no locks, traffic keeps flowing while it runs
+ */
+void sharded_stats_snapshot(ShardedLRUCache *cache, CacheStats *out);
+
+void free_sharded_cache(ShardedLRUCache *cache);
+
+#endif
@@ -0,0 +1,115 @@
+/*
+ * sketch.c
+ * Count-min frequency sketch with 4-bit counters and periodic aging
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sketch.h"
+
+#define COUNTERS_PER_WORD 16
+
+/*
+ * Odd multipliers, one per row. The top bits of the product
+ * pick the counter, so rows index independently
+ */
+static const u_int32_t row_seeds[SKETCH_DEPTH] = {
+    0x9E3779B1u, 0x85EBCA77u, 0xC2B2AE3Du, 0x27D4EB2Fu
+};
+
+static inline size_t counter_index(const FrequencySketch *sketch, u_int32_t hval, int row) {
+    return (u_int32_t)(hval * row_seeds[row]) >> (32 - sketch->width_bits);
+}
+
+static inline u_int64_t *counter_word(const FrequencySketch *sketch, int row, size_t index) {
+    return &sketch->table[(size_t)row * (sketch->width / COUNTERS_PER_WORD) + index / COUNTERS_PER_WORD];
+}
+
+static inline unsigned int counter_shift(size_t index) {
+    return (unsigned int)(index % COUNTERS_PER_WORD) * 4;
+}
+
+FrequencySketch *init_frequency_sketch(size_t capacity) {
+    if (capacity == 0) {
+        fprintf(stderr, "Sketch capacity must be positive!\n");
+        return NULL;
+    }
+
+    FrequencySketch *sketch = (FrequencySketch *)calloc(1, sizeof(FrequencySketch));
+    if (!sketch) {
+        fprintf(stderr, "Could not allocate memory for frequency sketch!\n");
+        return NULL;
+    }
+
+    sketch->width = COUNTERS_PER_WORD;
+    sketch->width_bits = 4;
+    while (sketch->width < capacity && sketch->width_bits < 32) {
+        sketch->width <<= 1;
+        sketch->width_bits++;
+    }
+
+    /*
+     * Age once the sketch has seen about ten times the cache's worth of keys
+     */
+    sketch->sample_size = 10 * capacity;
+    sketch->table = (u_int64_t *)calloc(SKETCH_DEPTH * (sketch->width / COUNTERS_PER_WORD), sizeof(u_int64_t));
+    if (!sketch->table) {
+        fprintf(stderr, "Could not allocate memory for sketch counters!\n");
+        free(sketch);
+        return NULL;
+    }
+
+    return sketch;
+}
+
+void sketch_increment(FrequencySketch *sketch, u_int32_t hval) {
+    int added = 0;
+    for (int row = 0; row < SKETCH_DEPTH; row++) {
+        size_t index = counter_index(sketch, hval, row);
+        u_int64_t *word = counter_word(sketch, row, index);
+        unsigned int shift = counter_shift(index);
+
+        if (((*word >> shift) & 0xF) < SKETCH_MAX_COUNT) {
+            *word += (u_int64_t)1 << shift;
+            added = 1;
+        }
+    }
+
+    if (added && ++sketch->additions >= sketch->sample_size)
+        sketch_age(sketch);
+}
+
+unsigned int sketch_frequency(const FrequencySketch *sketch, u_int32_t hval) {
+    unsigned int frequency = SKETCH_MAX_COUNT;
+    for (int row = 0; row < SKETCH_DEPTH; row++) {
+        size_t index = counter_index(sketch, hval, row);
+        unsigned int count = (unsigned int)((*counter_word(sketch, row, index) >> counter_shift(index)) & 0xF);
+        if (count < frequency)
+            frequency = count;
+    }
+
+    return frequency;
+}
+
+/*
+ * Shift every counter right, the mask drops the bit
+ * each counter would take from its upper neighbour
+ */
+void sketch_age(FrequencySketch *sketch) {
+    size_t words = SKETCH_DEPTH * (sketch->width / COUNTERS_PER_WORD);
+    for (size_t i = 0; i < words; i++)
+        sketch->table[i] = (sketch->table[i] >> 1) & 0x7777777777777777ULL;
+
+    sketch->additions /= 2;
+}
+
+void free_frequency_sketch(FrequencySketch *sketch) {
+    if (!sketch) {
+        fprintf(stderr, "Frequency sketch is not valid or is null!\n");
+        return;
+    }
+
+    free(sketch->table);
+    free(sketch);
+}
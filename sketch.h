@@ -0,0 +1,58 @@
+#ifndef _SKETCH_H_
+#define _SKETCH_H_
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#define SUCCESS 0
+#define FAILURE -1
+#define IS_NULL -2
+
+/*
+ * Rows of the sketch, each indexed by its own hash of the key
+ */
+#define SKETCH_DEPTH 4
+
+/*
+ * 4-bit counters saturate at this value
+ */
+#define SKETCH_MAX_COUNT 15
+
+/*
+ * Count-min sketch of 4-bit counters, 16 counters per word
+ * Every row holds "width" counters, a power of two not smaller than
+ * the capacity it was sized for: SKETCH_DEPTH / 2 bytes per counter column.
+ * After "sample_size" increments every counter is halved, so old
+ * popularity fades out
+ */
+typedef struct FrequencySketch {
+    size_t width;
+    unsigned int width_bits;
+    size_t sample_size;
+    size_t additions;
+    u_int64_t *table;
+} FrequencySketch;
+
+/*
+ * Initialize sketch for a cache of "capacity" entries
+ */
+FrequencySketch *init_frequency_sketch(size_t capacity);
+
+/*
+ * Count one occurrence of the key hashing to "hval"
+ */
+void sketch_increment(FrequencySketch *sketch, u_int32_t hval);
+
+/*
+ * Estimated occurrences of the key hashing to "hval", at most SKETCH_MAX_COUNT
+ */
+unsigned int sketch_frequency(const FrequencySketch *sketch, u_int32_t hval);
+
+/*
+ * Halve every counter
+ */
+void sketch_age(FrequencySketch *sketch);
+
+void free_frequency_sketch(FrequencySketch *sketch);
+
+#endif // _SKETCH_H_
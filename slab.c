@@ -0,0 +1,129 @@
+/*
+ * slab.c
+ * Fixed-size object pool backed by large preallocated chunks
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "slab.h"
+
+/*
+ * Objects are at least pointer sized and pointer aligned,
+ * so a free object can hold the link to the next free one
+ */
+static size_t align_object_size(size_t object_size) {
+    size_t align = sizeof(void *);
+    if (object_size < sizeof(void *))
+        object_size = sizeof(void *);
+
+    return (object_size + align - 1) & ~(align - 1);
+}
+
+SlabPool *init_slab_pool(size_t object_size, size_t capacity) {
+    if (object_size == 0 || capacity == 0) {
+        fprintf(stderr, "Slab pool object size and capacity must be positive!\n");
+        return NULL;
+    }
+
+    SlabPool *pool = (SlabPool *)calloc(1, sizeof(SlabPool));
+    if (!pool) {
+        fprintf(stderr, "Could not allocate slab pool!\n");
+        return NULL;
+    }
+
+    pool->object_size = align_object_size(object_size);
+    pool->chunk_objects = capacity;
+    pool->count_used = 0;
+    pool->count_total = 0;
+    pool->free_list = NULL;
+    pool->chunks = NULL;
+
+    if (grow_slab_pool(pool, capacity) != SUCCESS) {
+        free(pool);
+        return NULL;
+    }
+
+    return pool;
+}
+
+int grow_slab_pool(SlabPool *pool, size_t count) {
+    if (!pool) {
+        fprintf(stderr, "Slab pool is not valid or is null!\n");
+        return IS_NULL;
+    }
+
+    SlabChunk *chunk = (SlabChunk *)malloc(sizeof(SlabChunk) + count * pool->object_size);
+    if (!chunk) {
+        fprintf(stderr, "Could not allocate slab chunk!\n");
+        return IS_NULL;
+    }
+
+    chunk->object_count = count;
+    chunk->next = pool->chunks;
+    pool->chunks = chunk;
+
+    /*
+     * Thread every object of the new chunk onto the free list,
+     * last object first so allocation walks memory forward
+     */
+    char *objects = (char *)(chunk + 1);
+    for (size_t i = count; i > 0; i--) {
+        void *object = objects + (i - 1) * pool->object_size;
+        *(void **)object = pool->free_list;
+        pool->free_list = object;
+    }
+
+    pool->count_total += count;
+
+    return SUCCESS;
+}
+
+void *slab_alloc(SlabPool *pool) {
+    if (!pool) {
+        fprintf(stderr, "Slab pool is not valid or is null!\n");
+        return NULL;
+    }
+
+    if (!pool->free_list) {
+        if (grow_slab_pool(pool, pool->chunk_objects) != SUCCESS)
+            return NULL;
+    }
+
+    void *object = pool->free_list;
+    pool->free_list = *(void **)object;
+    pool->count_used++;
+
+    memset(object, 0, pool->object_size);
+
+    return object;
+}
+
+void slab_free(SlabPool *pool, void *object) {
+    if (!pool || !object)
+        return;
+
+    *(void **)object = pool->free_list;
+    pool->free_list = object;
+    pool->count_used--;
+}
+
+void free_slab_pool(SlabPool *pool) {
+    if (!pool) {
+        fprintf(stderr, "Slab pool is not valid or is null!\n");
+        return;
+    }
+
+    SlabChunk *chunk = pool->chunks;
+    while (chunk) {
+        SlabChunk *next_chunk = chunk->next;
+        free(chunk);
+        chunk = next_chunk;
+    }
+
+    free(pool);
+    pool = NULL;
+
+    return;
+}
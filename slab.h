@@ -0,0 +1,60 @@
+#ifndef _SLAB_H_
+#define _SLAB_H_
+
+#include <stddef.h>
+
+#define SUCCESS 0
+#define FAILURE -1
+#define IS_NULL -2
+
+/*
+ * Header of every chunk of objects allocated by the pool.
+ * Objects follow the header in the same allocation
+ */
+typedef struct SlabChunk {
+    struct SlabChunk *next;
+    size_t object_count;
+} SlabChunk;
+
+/*
+ * Fixed-size object pool
+ * Objects are carved out of large chunks and recycled through
+ * an intrusive free list, so alloc/free never touch malloc
+ * while the pool has free objects left
+ */
+typedef struct SlabPool {
+    size_t object_size;
+    size_t chunk_objects;
+    size_t count_used;
+    size_t count_total;
+    void *free_list;
+    SlabChunk *chunks;
+} SlabPool;
+
+/*
+ * Initialize pool with "capacity" preallocated objects of "object_size" bytes
+ */
+SlabPool *init_slab_pool(size_t object_size, size_t capacity);
+
+/*
+ * Preallocate another chunk of "count" objects
+ */
+int grow_slab_pool(SlabPool *pool, size_t count);
+
+/*
+ * Take a zeroed object from the pool.
+ * Grows the pool by another chunk if it is exhausted
+ */
+void *slab_alloc(SlabPool *pool);
+
+/*
+ * Return object to the pool
+ */
+void slab_free(SlabPool *pool, void *object);
+
+/*
+ * Free every chunk and the pool itself
+ */
+void free_slab_pool(SlabPool *pool);
+
+#endif // _SLAB_H_
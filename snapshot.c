@@ -0,0 +1,325 @@
+/*
+ * snapshot.c
+ * Cache snapshot files: streamed out through stdio, mapped back in
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "snapshot.h"
+#include "hash.h"
+
+/*
+ * Buffer of the writer's stream, large enough that writes stay sequential
+ */
+#define SNAPSHOT_BUFFER (1 << 20)
+
+static const char snapshot_magic[8] = { 'L', 'R', 'U', 'S', 'N', 'A', 'P', '\0' };
+static const char zero_pad[8];
+
+static inline size_t pad8(size_t len) {
+    return (len + 7) & ~(size_t)7;
+}
+
+static u_int64_t header_checksum(const SnapshotHeader *header) {
+    return murmur_hash64a(header, offsetof(SnapshotHeader, header_checksum), 0);
+}
+
+/*
+ * Chain a record's header, key and value into "checksum"
+ */
+static u_int64_t record_checksum(u_int64_t checksum, const SnapshotRecord *record, const void *key,
+                                 const void *value) {
+    checksum = murmur_hash64a(record, sizeof(*record), checksum);
+    checksum = murmur_hash64a(key, record->key_len, checksum);
+
+    return murmur_hash64a(value, record->value_len, checksum);
+}
+
+static void free_writer(SnapshotWriter *writer) {
+    free(writer->path);
+    free(writer->tmp_path);
+    free(writer);
+}
+
+SnapshotWriter *open_snapshot(const char *path) {
+    if (!path) {
+        fprintf(stderr, "Snapshot path is not valid or is null!\n");
+        return NULL;
+    }
+
+    SnapshotWriter *writer = (SnapshotWriter *)calloc(1, sizeof(SnapshotWriter));
+    if (!writer) {
+        fprintf(stderr, "Could not allocate memory for snapshot writer!\n");
+        return NULL;
+    }
+
+    size_t len = strlen(path);
+    writer->path = (char *)malloc(len + 1);
+    writer->tmp_path = (char *)malloc(len + sizeof(".tmp"));
+    if (!writer->path || !writer->tmp_path) {
+        fprintf(stderr, "Could not allocate memory for snapshot writer!\n");
+        free_writer(writer);
+        return NULL;
+    }
+    memcpy(writer->path, path, len + 1);
+    memcpy(writer->tmp_path, path, len);
+    memcpy(writer->tmp_path + len, ".tmp", sizeof(".tmp"));
+
+    writer->file = fopen(writer->tmp_path, "wb");
+    if (!writer->file) {
+        fprintf(stderr, "Could not create snapshot %s!\n", writer->tmp_path);
+        free_writer(writer);
+        return NULL;
+    }
+    setvbuf(writer->file, NULL, _IOFBF, SNAPSHOT_BUFFER);
+
+    /*
+     * Header is written for real once the records are counted
+     */
+    if (fwrite(&writer->header, sizeof(SnapshotHeader), 1, writer->file) != 1) {
+        fprintf(stderr, "Could not write snapshot %s!\n", writer->tmp_path);
+        abort_snapshot(writer);
+        return NULL;
+    }
+
+    return writer;
+}
+
+int write_snapshot_record(SnapshotWriter *writer, const void *key, size_t key_len, const void *value,
+                          size_t value_len, u_int32_t weight, u_int64_t ttl_ms) {
+    if (!writer || (!key && key_len > 0) || (!value && value_len > 0)) {
+        fprintf(stderr, "Snapshot writer, key or value are not valid or are null!\n");
+        return IS_NULL;
+    }
+
+    if (key_len > UINT32_MAX) {
+        fprintf(stderr, "Snapshot: Key of %zu bytes is too long!\n", key_len);
+        return FAILURE;
+    }
+
+    SnapshotRecord record = { (u_int32_t)key_len, weight, value_len, ttl_ms };
+    FILE *file = writer->file;
+    if (fwrite(&record, sizeof(record), 1, file) != 1
+            || fwrite(key, 1, key_len, file) != key_len
+            || fwrite(zero_pad, 1, pad8(key_len) - key_len, file) != pad8(key_len) - key_len
+            || fwrite(value, 1, value_len, file) != value_len
+            || fwrite(zero_pad, 1, pad8(value_len) - value_len, file) != pad8(value_len) - value_len) {
+        fprintf(stderr, "Could not write snapshot %s!\n", writer->tmp_path);
+        return FAILURE;
+    }
+
+    SnapshotHeader *header = &writer->header;
+    header->count++;
+    header->data_size += sizeof(record) + pad8(key_len) + pad8(value_len);
+    header->data_checksum = record_checksum(header->data_checksum, &record, key, value);
+
+    return SUCCESS;
+}
+
+int commit_snapshot(SnapshotWriter *writer) {
+    if (!writer) {
+        fprintf(stderr, "Snapshot writer is not valid or is null!\n");
+        return IS_NULL;
+    }
+
+    SnapshotHeader *header = &writer->header;
+    memcpy(header->magic, snapshot_magic, sizeof(snapshot_magic));
+    header->version = SNAPSHOT_VERSION;
+    header->byte_order = SNAPSHOT_BYTE_ORDER;
+    header->header_checksum = header_checksum(header);
+
+    /*
+     * Records reach the disk before the file replaces the old snapshot
+     */
+    FILE *file = writer->file;
+    if (fflush(file) != 0 || fseek(file, 0, SEEK_SET) != 0
+            || fwrite(header, sizeof(SnapshotHeader), 1, file) != 1
+            || fflush(file) != 0 || fsync(fileno(file)) != 0) {
+        fprintf(stderr, "Could not write snapshot %s!\n", writer->tmp_path);
+        abort_snapshot(writer);
+        return FAILURE;
+    }
+
+    writer->file = NULL;
+    if (fclose(file) != 0 || rename(writer->tmp_path, writer->path) != 0) {
+        fprintf(stderr, "Could not move snapshot into place at %s!\n", writer->path);
+        abort_snapshot(writer);
+        return FAILURE;
+    }
+    free_writer(writer);
+
+    return SUCCESS;
+}
+
+void abort_snapshot(SnapshotWriter *writer) {
+    if (!writer) {
+        fprintf(stderr, "Snapshot writer is not valid or is null!\n");
+        return;
+    }
+
+    if (writer->file)
+        fclose(writer->file);
+    unlink(writer->tmp_path);
+    free_writer(writer);
+}
+
+/*
+ * Header of a mapped file, NULL if it does not describe "size" bytes
+ * of snapshot this build can read
+ */
+static const SnapshotHeader *check_header(const void *map, size_t size) {
+    const SnapshotHeader *header = (const SnapshotHeader *)map;
+    if (size < sizeof(SnapshotHeader) || memcmp(header->magic, snapshot_magic, sizeof(snapshot_magic)) != 0) {
+        fprintf(stderr, "Snapshot: Not a snapshot file!\n");
+        return NULL;
+    }
+
+    if (header->version != SNAPSHOT_VERSION || header->byte_order != SNAPSHOT_BYTE_ORDER) {
+        fprintf(stderr, "Snapshot: Version %u or byte order not supported!\n", header->version);
+        return NULL;
+    }
+
+    if (header->header_checksum != header_checksum(header)
+            || header->data_size != size - sizeof(SnapshotHeader)) {
+        fprintf(stderr, "Snapshot: Header is corrupt or file is truncated!\n");
+        return NULL;
+    }
+
+    return header;
+}
+
+/*
+ * Walk every record once, checking bounds and the checksum chain
+ * and locating the first view->loaded records
+ */
+static int check_records(SnapshotView *view, const SnapshotHeader *header) {
+    const char *data = (const char *)view->map;
+    size_t offset = sizeof(SnapshotHeader);
+    u_int64_t checksum = 0;
+
+    for (u_int64_t i = 0; i < header->count; i++) {
+        if (view->size - offset < sizeof(SnapshotRecord))
+            return FAILURE;
+
+        const SnapshotRecord *record = (const SnapshotRecord *)(data + offset);
+        size_t room = view->size - offset - sizeof(SnapshotRecord);
+        if (pad8(record->key_len) > room || record->value_len > room - pad8(record->key_len)
+                || pad8(record->value_len) > room - pad8(record->key_len))
+            return FAILURE;
+
+        checksum = record_checksum(checksum, record, snapshot_key(record), snapshot_value(record));
+        if (i < view->loaded)
+            view->offsets[i] = offset;
+        offset += sizeof(SnapshotRecord) + pad8(record->key_len) + pad8(record->value_len);
+    }
+
+    return offset == view->size && checksum == header->data_checksum ? SUCCESS : FAILURE;
+}
+
+SnapshotView *map_snapshot(const char *path, size_t max_records) {
+    if (!path) {
+        fprintf(stderr, "Snapshot path is not valid or is null!\n");
+        return NULL;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Could not open snapshot %s!\n", path);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(SnapshotHeader)) {
+        fprintf(stderr, "Snapshot: %s is not a snapshot file!\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    /*
+     * Private mapping: values handed out may be written to,
+     * their pages are copied and the file stays intact
+     */
+    size_t size = (size_t)st.st_size;
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "Could not map snapshot %s!\n", path);
+        return NULL;
+    }
+
+    SnapshotView *view = (SnapshotView *)calloc(1, sizeof(SnapshotView));
+    if (!view) {
+        fprintf(stderr, "Could not allocate memory for snapshot view!\n");
+        munmap(map, size);
+        return NULL;
+    }
+    view->map = map;
+    view->size = size;
+
+    const SnapshotHeader *header = check_header(map, size);
+    if (!header) {
+        unmap_snapshot(view);
+        return NULL;
+    }
+    view->count = header->count;
+    view->loaded = header->count < max_records ? (size_t)header->count : max_records;
+    if (view->loaded > 0) {
+        view->offsets = (size_t *)malloc(view->loaded * sizeof(size_t));
+        if (!view->offsets) {
+            fprintf(stderr, "Could not allocate memory for snapshot offsets!\n");
+            unmap_snapshot(view);
+            return NULL;
+        }
+    }
+
+    madvise(map, size, MADV_SEQUENTIAL);
+    if (check_records(view, header) != SUCCESS) {
+        fprintf(stderr, "Snapshot: Records of %s are corrupt!\n", path);
+        unmap_snapshot(view);
+        return NULL;
+    }
+    madvise(map, size, MADV_NORMAL);
+
+    return view;
+}
+
+const SnapshotRecord *snapshot_record(const SnapshotView *view, size_t index) {
+    return (const SnapshotRecord *)((const char *)view->map + view->offsets[index]);
+}
+
+const char *snapshot_key(const SnapshotRecord *record) {
+    return (const char *)(record + 1);
+}
+
+void *snapshot_value(const SnapshotRecord *record) {
+    return (char *)(record + 1) + pad8(record->key_len);
+}
+
+bool snapshot_owns(const SnapshotView *view, const void *value) {
+    const char *begin = (const char *)view->map;
+
+    return (const char *)value >= begin && (const char *)value < begin + view->size;
+}
+
+void release_snapshot_offsets(SnapshotView *view) {
+    free(view->offsets);
+    view->offsets = NULL;
+    view->loaded = 0;
+}
+
+void unmap_snapshot(SnapshotView *view) {
+    if (!view) {
+        fprintf(stderr, "Snapshot view is not valid or is null!\n");
+        return;
+    }
+
+    munmap(view->map, view->size);
+    free(view->offsets);
+    free(view);
+}
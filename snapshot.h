@@ -0,0 +1,128 @@
+#ifndef _SNAPSHOT_H_
+#define _SNAPSHOT_H_
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+#define SUCCESS 0
+#define FAILURE -1
+#define IS_NULL -2
+
+#define SNAPSHOT_VERSION 1
+
+/*
+ * Written as 0x01020304 by the host, a loader reading anything else
+ * runs on the other byte order
+ */
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+
+/*
+ * Snapshot file format
+ *
+ *   SnapshotHeader
+ *   "count" records, each 8 byte aligned:
+ *     SnapshotRecord, key, zero padding to 8, value, zero padding to 8
+ *
+ * Records run from the most to the least recently used entry, so loading
+ * a prefix keeps the hottest ones. Fields are in host byte order: records
+ * are used in place from a mapping of the file, values included.
+ *
+ * data_checksum chains MurmurHash64A over the records, each one's hash
+ * seeding the next, so it is computed while streaming them out.
+ * header_checksum covers the header up to itself
+ */
+typedef struct SnapshotHeader {
+    char magic[8];
+    u_int32_t version;
+    u_int32_t byte_order;
+    u_int64_t count;
+    u_int64_t data_size;
+    u_int64_t data_checksum;
+    u_int64_t header_checksum;
+} SnapshotHeader;
+
+/*
+ * ttl_ms is what was left of the entry's TTL when it was written,
+ * 0 if it never expires
+ */
+typedef struct SnapshotRecord {
+    u_int32_t key_len;
+    u_int32_t weight;
+    u_int64_t value_len;
+    u_int64_t ttl_ms;
+} SnapshotRecord;
+
+/*
+ * Snapshot being written to "tmp_path", renamed over "path" on commit
+ * so readers never see a partial file
+ */
+typedef struct SnapshotWriter {
+    FILE *file;
+    char *path;
+    char *tmp_path;
+    SnapshotHeader header;
+} SnapshotWriter;
+
+/*
+ * Verified snapshot mapped copy-on-write: records may be read and values
+ * written in place. offsets[i] locates record i for the first "loaded"
+ * records, see map_snapshot
+ */
+typedef struct SnapshotView {
+    void *map;
+    size_t size;
+    u_int64_t count;
+    size_t loaded;
+    size_t *offsets;
+} SnapshotView;
+
+/*
+ * Start a snapshot at "path", NULL on failure
+ */
+SnapshotWriter *open_snapshot(const char *path);
+
+/*
+ * Append one record
+ */
+int write_snapshot_record(SnapshotWriter *writer, const void *key, size_t key_len, const void *value,
+                          size_t value_len, u_int32_t weight, u_int64_t ttl_ms);
+
+/*
+ * Write the header, sync and move the file into place. Frees "writer"
+ * whatever the result, a failed snapshot leaves "path" untouched
+ */
+int commit_snapshot(SnapshotWriter *writer);
+
+/*
+ * Drop the partial file and free "writer"
+ */
+void abort_snapshot(SnapshotWriter *writer);
+
+/*
+ * Map "path" and check its header and checksums, locating the first
+ * "max_records" records. NULL if the file is not a valid snapshot
+ */
+SnapshotView *map_snapshot(const char *path, size_t max_records);
+
+/*
+ * Record "index" (< view->loaded), its key and its value
+ */
+const SnapshotRecord *snapshot_record(const SnapshotView *view, size_t index);
+const char *snapshot_key(const SnapshotRecord *record);
+void *snapshot_value(const SnapshotRecord *record);
+
+/*
+ * True if "value" points into the mapping
+ */
+bool snapshot_owns(const SnapshotView *view, const void *value);
+
+/*
+ * Free the record offsets, the mapping stays for the values in it
+ */
+void release_snapshot_offsets(SnapshotView *view);
+
+void unmap_snapshot(SnapshotView *view);
+
+#endif // _SNAPSHOT_H_
@@ -0,0 +1,217 @@
+/*
+ * stack_distance.c
+ * LRU stack distances of a key stream in bounded memory
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stack_distance.h"
+
+#define EMPTY_TIME 0xFFFFFFFFu
+
+static inline size_t home_slot(const StackDistance *stack, u_int64_t key) {
+    return (size_t)((key * 0x9E3779B97F4A7C15ull) >> (64 - stack->map_bits));
+}
+
+/*
+ * Slot holding "key", or the empty slot where it would go
+ */
+static size_t find_slot(const StackDistance *stack, u_int64_t key) {
+    size_t slot = home_slot(stack, key);
+    while (stack->map_times[slot] != EMPTY_TIME && stack->map_keys[slot] != key)
+        slot = (slot + 1) & stack->map_mask;
+
+    return slot;
+}
+
+/*
+ * Empty "slot", shifting back later keys of its cluster
+ * so lookups never stop short of them
+ */
+static void delete_slot(StackDistance *stack, size_t slot) {
+    size_t next = slot;
+    for (;;) {
+        next = (next + 1) & stack->map_mask;
+        if (stack->map_times[next] == EMPTY_TIME)
+            break;
+
+        size_t home = home_slot(stack, stack->map_keys[next]);
+        if (((next - home) & stack->map_mask) >= ((next - slot) & stack->map_mask)) {
+            stack->map_keys[slot] = stack->map_keys[next];
+            stack->map_times[slot] = stack->map_times[next];
+            slot = next;
+        }
+    }
+
+    stack->map_times[slot] = EMPTY_TIME;
+}
+
+static void tree_add(StackDistance *stack, size_t time, int delta) {
+    for (size_t i = time + 1; i <= stack->window; i += i & -i)
+        stack->tree[i] += (u_int32_t)delta;
+}
+
+/*
+ * Live times <= "time"
+ */
+static size_t tree_prefix(const StackDistance *stack, size_t time) {
+    size_t sum = 0;
+    for (size_t i = time + 1; i > 0; i -= i & -i)
+        sum += stack->tree[i];
+
+    return sum;
+}
+
+/*
+ * Oldest live time, by descending the tree
+ */
+static size_t tree_first(const StackDistance *stack) {
+    size_t pos = 0;
+    for (size_t step = stack->window; step > 0; step >>= 1) {
+        if (pos + step <= stack->window && stack->tree[pos + step] == 0)
+            pos += step;
+    }
+
+    return pos;
+}
+
+static void set_live(StackDistance *stack, size_t time, u_int64_t key) {
+    stack->time_keys[time] = key;
+    stack->live[time / 64] |= 1ull << (time % 64);
+    tree_add(stack, time, 1);
+}
+
+static void clear_live(StackDistance *stack, size_t time) {
+    stack->live[time / 64] &= ~(1ull << (time % 64));
+    tree_add(stack, time, -1);
+}
+
+/*
+ * Renumber live times 0..count-1 in their order and rebuild the tree
+ */
+static void compact(StackDistance *stack) {
+    size_t next = 0;
+    for (size_t time = 0; time < stack->window; time++) {
+        if (!(stack->live[time / 64] & (1ull << (time % 64))))
+            continue;
+
+        u_int64_t key = stack->time_keys[time];
+        stack->time_keys[next] = key;
+        stack->map_times[find_slot(stack, key)] = (u_int32_t)next;
+        next++;
+    }
+
+    memset(stack->live, 0, stack->window / 8);
+    memset(stack->tree, 0, (stack->window + 1) * sizeof(u_int32_t));
+    for (size_t time = 0; time < next; time++) {
+        stack->live[time / 64] |= 1ull << (time % 64);
+        stack->tree[time + 1] = 1;
+    }
+    for (size_t i = 1; i <= stack->window; i++) {
+        size_t parent = i + (i & -i);
+        if (parent <= stack->window)
+            stack->tree[parent] += stack->tree[i];
+    }
+
+    stack->now = next;
+}
+
+StackDistance *init_stack_distance(size_t max_keys) {
+    if (max_keys == 0 || max_keys > EMPTY_TIME / 4) {
+        fprintf(stderr, "Stack distance key limit is out of range!\n");
+        return NULL;
+    }
+
+    StackDistance *stack = (StackDistance *)calloc(1, sizeof(StackDistance));
+    if (!stack) {
+        fprintf(stderr, "Could not allocate memory for stack distance!\n");
+        return NULL;
+    }
+
+    /*
+     * Both the map and the time window are at least twice the keys:
+     * probes stay short and a renumbering frees half the window
+     */
+    stack->max_keys = max_keys;
+    stack->map_bits = 6;
+    while (((size_t)1 << stack->map_bits) < 2 * max_keys)
+        stack->map_bits++;
+    stack->map_mask = ((size_t)1 << stack->map_bits) - 1;
+    stack->window = (size_t)1 << stack->map_bits;
+
+    stack->map_keys = (u_int64_t *)malloc(stack->window * sizeof(u_int64_t));
+    stack->map_times = (u_int32_t *)malloc(stack->window * sizeof(u_int32_t));
+    stack->time_keys = (u_int64_t *)malloc(stack->window * sizeof(u_int64_t));
+    stack->live = (u_int64_t *)calloc(stack->window / 64, sizeof(u_int64_t));
+    stack->tree = (u_int32_t *)calloc(stack->window + 1, sizeof(u_int32_t));
+    if (!stack->map_keys || !stack->map_times || !stack->time_keys || !stack->live || !stack->tree) {
+        fprintf(stderr, "Could not allocate memory for stack distance tables!\n");
+        free_stack_distance(stack);
+        return NULL;
+    }
+    memset(stack->map_times, 0xFF, stack->window * sizeof(u_int32_t));
+
+    return stack;
+}
+
+size_t stack_distance_access(StackDistance *stack, u_int64_t key) {
+    if (stack->now == stack->window)
+        compact(stack);
+
+    size_t distance = STACK_DISTANCE_COLD;
+    size_t slot = find_slot(stack, key);
+    if (stack->map_times[slot] != EMPTY_TIME) {
+        size_t time = stack->map_times[slot];
+        distance = stack->count - tree_prefix(stack, time) + 1;
+        clear_live(stack, time);
+    } else {
+        if (stack->count == stack->max_keys) {
+            size_t oldest = tree_first(stack);
+            delete_slot(stack, find_slot(stack, stack->time_keys[oldest]));
+            clear_live(stack, oldest);
+            stack->count--;
+            slot = find_slot(stack, key);
+        }
+        stack->map_keys[slot] = key;
+        stack->count++;
+    }
+
+    stack->map_times[slot] = (u_int32_t)stack->now;
+    set_live(stack, stack->now, key);
+    stack->now++;
+
+    return distance;
+}
+
+int stack_distance_remove(StackDistance *stack, u_int64_t key) {
+    if (!stack) {
+        fprintf(stderr, "Stack distance is not valid or is null!\n");
+        return IS_NULL;
+    }
+
+    size_t slot = find_slot(stack, key);
+    if (stack->map_times[slot] == EMPTY_TIME)
+        return FAILURE;
+
+    clear_live(stack, stack->map_times[slot]);
+    delete_slot(stack, slot);
+    stack->count--;
+
+    return SUCCESS;
+}
+
+void free_stack_distance(StackDistance *stack) {
+    if (!stack) {
+        fprintf(stderr, "Stack distance is not valid or is null!\n");
+        return;
+    }
+
+    free(stack->map_keys);
+    free(stack->map_times);
+    free(stack->time_keys);
+    free(stack->live);
+    free(stack->tree);
+    free(stack);
+}
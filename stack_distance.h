@@ -0,0 +1,71 @@
+#ifndef _STACK_DISTANCE_H_
+#define _STACK_DISTANCE_H_
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#define SUCCESS 0
+#define FAILURE -1
+#define IS_NULL -2
+
+/*
+ * Distance reported for a key that is not tracked:
+ * first access, or dropped since its last one
+ */
+#define STACK_DISTANCE_COLD 0
+
+/*
+ * LRU stack distance (Mattson et al.) of a stream of 64 bit key ids.
+ * The distance of an access is the key's depth in an LRU stack of
+ * every key seen: 1 if it was the last key accessed, d if d - 1 other
+ * keys were accessed since. An LRU cache of "c" entries hits exactly
+ * the accesses at distance <= c, so one pass yields hits of every size.
+ *
+ * Each tracked key holds its last access time, a Fenwick tree over
+ * times counts the keys accessed after it in O(log n). Times live in
+ * a window of 2 * max_keys, renumbered in one pass when it runs out.
+ * At most "max_keys" keys are tracked, a new one drops the least
+ * recently accessed, so memory is about 50 bytes per key whatever
+ * the length of the stream
+ */
+typedef struct StackDistance {
+    size_t max_keys;
+    size_t count;
+
+    /*
+     * Key id -> last access time, linear probing
+     */
+    u_int64_t *map_keys;
+    u_int32_t *map_times;
+    size_t map_mask;
+    unsigned int map_bits;
+
+    /*
+     * Key id, live bit and Fenwick count by access time
+     */
+    u_int64_t *time_keys;
+    u_int64_t *live;
+    u_int32_t *tree;
+    size_t window;
+    size_t now;
+} StackDistance;
+
+/*
+ * Initialize tracker of at most "max_keys" keys
+ */
+StackDistance *init_stack_distance(size_t max_keys);
+
+/*
+ * Record an access of "key", returns its stack distance
+ * or STACK_DISTANCE_COLD
+ */
+size_t stack_distance_access(StackDistance *stack, u_int64_t key);
+
+/*
+ * Stop tracking "key", FAILURE if it is not tracked
+ */
+int stack_distance_remove(StackDistance *stack, u_int64_t key);
+
+void free_stack_distance(StackDistance *stack);
+
+#endif // _STACK_DISTANCE_H_
@@ -0,0 +1,135 @@
+/*
+ * stats.c
+ * Cache counters, log2 latency histograms and their aggregation
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "stats.h"
+
+static unsigned int next_stripe;
+_Thread_local unsigned int stats_thread_stripe;
+
+unsigned int stats_assign_stripe(void) {
+    stats_thread_stripe = __atomic_add_fetch(&next_stripe, 1, __ATOMIC_RELAXED);
+    if (stats_thread_stripe == 0)
+        stats_thread_stripe = __atomic_add_fetch(&next_stripe, 1, __ATOMIC_RELAXED);
+
+    return stats_thread_stripe;
+}
+
+LookupStats *init_lookup_stats(void) {
+    LookupStats *stats = (LookupStats *)aligned_alloc(64, sizeof(LookupStats));
+    if (!stats) {
+        fprintf(stderr, "Could not allocate memory for lookup stats!\n");
+        return NULL;
+    }
+
+    for (size_t i = 0; i < STATS_STRIPES; i++) {
+        stats->stripes[i].hits = 0;
+        stats->stripes[i].misses = 0;
+    }
+
+    return stats;
+}
+
+void stats_merge_lookups(CacheStats *into, const LookupStats *from) {
+    if (!into || !from) {
+        fprintf(stderr, "Stats are not valid or are null!\n");
+        return;
+    }
+
+    for (size_t i = 0; i < STATS_STRIPES; i++) {
+        into->hits += __atomic_load_n(&from->stripes[i].hits, __ATOMIC_RELAXED);
+        into->misses += __atomic_load_n(&from->stripes[i].misses, __ATOMIC_RELAXED);
+    }
+}
+
+void free_lookup_stats(LookupStats *stats) {
+    if (!stats) {
+        fprintf(stderr, "Lookup stats are not valid or are null!\n");
+        return;
+    }
+
+    free(stats);
+}
+
+void stats_record_latency(u_int64_t *histogram, u_int64_t ns) {
+    unsigned int bucket = ns ? 64 - (unsigned int)__builtin_clzll(ns) : 0;
+    if (bucket >= STATS_LATENCY_BUCKETS)
+        bucket = STATS_LATENCY_BUCKETS - 1;
+
+    STATS_ADD(histogram[bucket], 1);
+}
+
+static void merge_counters(u_int64_t *into, const u_int64_t *from, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        into[i] += __atomic_load_n(&from[i], __ATOMIC_RELAXED);
+}
+
+void stats_merge(CacheStats *into, const CacheStats *from) {
+    if (!into || !from) {
+        fprintf(stderr, "Stats are not valid or are null!\n");
+        return;
+    }
+
+    /*
+     * CacheStats is nothing but u_int64_t counters
+     */
+    merge_counters((u_int64_t *)into, (const u_int64_t *)from, sizeof(CacheStats) / sizeof(u_int64_t));
+}
+
+double stats_hit_ratio(const CacheStats *stats) {
+    u_int64_t lookups = stats->hits + stats->misses;
+
+    return lookups ? (double)stats->hits / (double)lookups : 0.0;
+}
+
+u_int64_t stats_latency_quantile(const u_int64_t *histogram, double q) {
+    u_int64_t total = 0;
+    for (int i = 0; i < STATS_LATENCY_BUCKETS; i++)
+        total += histogram[i];
+    if (total == 0)
+        return 0;
+
+    u_int64_t rank = (u_int64_t)(q * (double)total);
+    if (rank >= total)
+        rank = total - 1;
+
+    u_int64_t seen = 0;
+    for (int i = 0; i < STATS_LATENCY_BUCKETS; i++) {
+        seen += histogram[i];
+        if (seen > rank)
+            return (u_int64_t)1 << i;
+    }
+
+    return (u_int64_t)1 << (STATS_LATENCY_BUCKETS - 1);
+}
+
+void print_stats(const CacheStats *stats) {
+    if (!stats) {
+        fprintf(stderr, "Stats are not valid or are null!\n");
+        return;
+    }
+
+    printf("hits: %llu, misses: %llu, hit ratio: %.4f\n", (unsigned long long)stats->hits,
+           (unsigned long long)stats->misses, stats_hit_ratio(stats));
+    printf("inserts: %llu, replacements: %llu, evictions: %llu, expirations: %llu\n",
+           (unsigned long long)stats->inserts, (unsigned long long)stats->replacements,
+           (unsigned long long)stats->evictions, (unsigned long long)stats->expirations);
+
+    printf("probe lengths:");
+    for (int i = 0; i < STATS_PROBE_BUCKETS; i++)
+        printf(" %llu", (unsigned long long)stats->probe_lengths[i]);
+    printf("\n");
+
+    printf("get latency p50/p99/p999 (ns): %llu/%llu/%llu\n",
+           (unsigned long long)stats_latency_quantile(stats->get_latency, 0.5),
+           (unsigned long long)stats_latency_quantile(stats->get_latency, 0.99),
+           (unsigned long long)stats_latency_quantile(stats->get_latency, 0.999));
+    printf("put latency p50/p99/p999 (ns): %llu/%llu/%llu\n",
+           (unsigned long long)stats_latency_quantile(stats->put_latency, 0.5),
+           (unsigned long long)stats_latency_quantile(stats->put_latency, 0.99),
+           (unsigned long long)stats_latency_quantile(stats->put_latency, 0.999));
+}
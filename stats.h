@@ -0,0 +1,120 @@
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#define SUCCESS 0
+#define FAILURE -1
+#define IS_NULL -2
+
+/*
+ * Probe length buckets: searches that took 1, 2, ... probes,
+ * the last bucket counts everything longer
+ */
+#define STATS_PROBE_BUCKETS 16
+
+/*
+ * Latency buckets: bucket "b" counts operations that took
+ * [2^(b-1), 2^b) nanoseconds, the last one everything slower
+ */
+#define STATS_LATENCY_BUCKETS 32
+
+/*
+ * Add to a counter other threads may update or read at the same time.
+ * Relaxed: counters are independent, only their totals matter
+ */
+#define STATS_ADD(counter, n) __atomic_fetch_add(&(counter), (n), __ATOMIC_RELAXED)
+
+/*
+ * Stripes of the lookup counters, a power of two
+ */
+#ifndef STATS_STRIPES
+#define STATS_STRIPES 16
+#endif
+
+/*
+ * Counters of one cache
+ * replacements are puts of a key that was already cached,
+ * evictions and expirations count entries removed for room and for age.
+ * peek_value counts nothing, so monitoring does not skew the hit ratio
+ */
+typedef struct CacheStats {
+    u_int64_t hits;
+    u_int64_t misses;
+    u_int64_t inserts;
+    u_int64_t replacements;
+    u_int64_t evictions;
+    u_int64_t expirations;
+    u_int64_t probe_lengths[STATS_PROBE_BUCKETS];
+    u_int64_t get_latency[STATS_LATENCY_BUCKETS];
+    u_int64_t put_latency[STATS_LATENCY_BUCKETS];
+} CacheStats;
+
+/*
+ * Hits and misses of the threads sharing a stripe,
+ * padded to a cache line so stripes do not share lines
+ */
+typedef struct StatsStripe {
+    u_int64_t hits;
+    u_int64_t misses;
+} __attribute__((aligned(64))) StatsStripe;
+
+/*
+ * Lookup counters striped by thread, so lookups running concurrently
+ * under a shared lock each write their own cache line
+ */
+typedef struct LookupStats {
+    StatsStripe stripes[STATS_STRIPES];
+} LookupStats;
+
+LookupStats *init_lookup_stats(void);
+
+/*
+ * Threads get stripes round robin on first use,
+ * 0 means the thread has no stripe yet
+ */
+extern _Thread_local unsigned int stats_thread_stripe;
+unsigned int stats_assign_stripe(void);
+
+static inline StatsStripe *lookup_stripe(LookupStats *stats) {
+    unsigned int stripe = stats_thread_stripe;
+    if (stripe == 0)
+        stripe = stats_assign_stripe();
+
+    return &stats->stripes[stripe & (STATS_STRIPES - 1)];
+}
+
+/*
+ * Add the hits and misses of every stripe to "into",
+ * each counter read atomically on its own
+ */
+void stats_merge_lookups(CacheStats *into, const LookupStats *from);
+
+void free_lookup_stats(LookupStats *stats);
+
+/*
+ * Count one operation that took "ns" nanoseconds
+ */
+void stats_record_latency(u_int64_t *histogram, u_int64_t ns);
+
+/*
+ * Add every counter of "from" to "into". "from" may be updated
+ * concurrently, each counter is read atomically on its own
+ */
+void stats_merge(CacheStats *into, const CacheStats *from);
+
+/*
+ * Hits over lookups, 0 before the first lookup
+ */
+double stats_hit_ratio(const CacheStats *stats);
+
+/*
+ * Upper bound in nanoseconds of the bucket holding quantile "q" (0..1)
+ * of a latency histogram, 0 if it is empty
+ */
+u_int64_t stats_latency_quantile(const u_int64_t *histogram, double q);
+
+void print_stats(const CacheStats *stats);
+
+#endif // _STATS_H_
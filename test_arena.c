@@ -0,0 +1,60 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "arena.h"
+
+int main(void) {
+    KeyArena *arena = init_key_arena(8);
+    if (arena == NULL) {
+        printf("Failed to initialize key arena!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /*
+     * TESTS
+     */
+#ifdef TESTS
+    char *small = (char *)arena_alloc(arena, 24);
+    char *medium = (char *)arena_alloc(arena, 100);
+    if (small == NULL || medium == NULL || arena->bytes_used != 32 + 128) {
+        fprintf(stderr, "TEST 1 FAILED: Blocks not served from size classes!\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(small, 'a', 24);
+    memset(medium, 'b', 100);
+    printf("TEST 1 PASSED\n");
+
+    char *large = (char *)arena_alloc(arena, 10000);
+    if (large == NULL || arena->bytes_used != 32 + 128 + 10000) {
+        fprintf(stderr, "TEST 2 FAILED: Large block not allocated!\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(large, 'c', 10000);
+    printf("TEST 2 PASSED\n");
+
+    arena_free(arena, medium, 100);
+    char *reused = (char *)arena_alloc(arena, 90);
+    if (reused != medium) {
+        fprintf(stderr, "TEST 3 FAILED: Freed block was not recycled!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 3 PASSED\n");
+
+    arena_free(arena, small, 24);
+    arena_free(arena, reused, 90);
+    arena_free(arena, large, 10000);
+    if (arena->bytes_used != 0) {
+        fprintf(stderr, "TEST 4 FAILED: %ld bytes still accounted!\n", arena->bytes_used);
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 4 PASSED\n");
+
+    printf("ALL TESTS PASSED!\n");
+#endif // TESTS
+
+    free_key_arena(arena);
+
+    exit(EXIT_SUCCESS);
+}
@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "hash.h"
 
@@ -102,6 +103,446 @@ int main(void) {
     print_table(hash_table);
 #endif
 
+    /*
+     * Entries probed past the removed one must still be found
+     */
+    if (search_entry("key1", hash_table) < 0 || search_entry("key2", hash_table) < 0 || search_entry("key4", hash_table) < 0) {
+        fprintf(stderr, "TEST 8 FAILED: Lost key after removal!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 8 PASSED\n");
+
+    if (search_entry("key333", hash_table) >= 0 || hash_table->count_entry != 3) {
+        fprintf(stderr, "TEST 9 FAILED: Removed key is still present!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 9 PASSED\n");
+
+    /*
+     * Robin Hood table filled close to ROBIN_HOOD_ALPHA_MAX
+     */
+    static char rh_keys[200][16];
+    HashTable *rh_table = init_robin_hood_table(230);
+    if (rh_table == NULL) {
+        fprintf(stderr, "TEST 10 FAILED: Couldn't initialize Robin Hood table!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < 200; i++) {
+        snprintf(rh_keys[i], sizeof(rh_keys[i]), "rh_key%d", i);
+        if (add_hash_entry(rh_keys[i], "rh_val", rh_table, !RESIZE_AUTOMATICALLY) < 0) {
+            fprintf(stderr, "TEST 10 FAILED: Couldn't add key %s!\n", rh_keys[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int i = 0; i < 200; i++) {
+        if (search_entry(rh_keys[i], rh_table) < 0) {
+            fprintf(stderr, "TEST 10 FAILED: Couldn't find key %s!\n", rh_keys[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    printf("TEST 10 PASSED\n");
+
+    /*
+     * Backward shift deletion keeps every other key reachable
+     */
+    for (int i = 0; i < 200; i += 2) {
+        if (remove_hash_entry(rh_keys[i], rh_table, !RESIZE_AUTOMATICALLY) != SUCCESS) {
+            fprintf(stderr, "TEST 11 FAILED: Couldn't remove key %s!\n", rh_keys[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int i = 0; i < 200; i++) {
+        if ((search_entry(rh_keys[i], rh_table) >= 0) != (i % 2 == 1)) {
+            fprintf(stderr, "TEST 11 FAILED: Wrong lookup result for key %s!\n", rh_keys[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    printf("TEST 11 PASSED\n");
+
+    if (rh_table->count_entry != 100 || resize_table(rh_table, RESIZE_UP) != SUCCESS
+            || search_entry(rh_keys[199], rh_table) < 0) {
+        fprintf(stderr, "TEST 12 FAILED: Robin Hood table lost entries on resize!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 12 PASSED\n");
+
+    free_table(rh_table);
+
+    /*
+     * Control bytes of a linear table stay in sync with its slots
+     * after inserts, removals and tombstone purges
+     */
+    static char ctrl_keys[300][16];
+    HashTable *ctrl_table = init_hash_table(64);
+    for (int i = 0; i < 300; i++) {
+        snprintf(ctrl_keys[i], sizeof(ctrl_keys[i]), "ctrl_key%d", i);
+        if (add_hash_entry(ctrl_keys[i], "ctrl_val", ctrl_table, !RESIZE_AUTOMATICALLY) < 0) {
+            fprintf(stderr, "TEST 13 FAILED: Couldn't add key %s!\n", ctrl_keys[i]);
+            exit(EXIT_FAILURE);
+        }
+        if (i >= 40 && remove_hash_entry(ctrl_keys[i - 40], ctrl_table, !RESIZE_AUTOMATICALLY) != SUCCESS) {
+            fprintf(stderr, "TEST 13 FAILED: Couldn't remove key %s!\n", ctrl_keys[i - 40]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    unsigned int full_slots = 0;
+    for (size_t i = 0; i < ctrl_table->table_size + CTRL_GROUP_WIDTH; i++) {
+        size_t slot = i % ctrl_table->table_size;
+        if (ctrl_table->ctrl[i] != ctrl_table->ctrl[slot]
+                || ((ctrl_table->ctrl[slot] & 0x80) == 0) != IS_LIVE_ENTRY(ctrl_table->table[slot])) {
+            fprintf(stderr, "TEST 13 FAILED: Control byte %ld out of sync!\n", i);
+            exit(EXIT_FAILURE);
+        }
+        if (i < ctrl_table->table_size && (ctrl_table->ctrl[i] & 0x80) == 0)
+            full_slots++;
+    }
+    if (full_slots != ctrl_table->count_entry || ctrl_table->count_entry != 40) {
+        fprintf(stderr, "TEST 13 FAILED: %u full control bytes for %u entries!\n", full_slots, ctrl_table->count_entry);
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 13 PASSED\n");
+
+    for (int i = 0; i < 300; i++) {
+        if ((search_entry(ctrl_keys[i], ctrl_table) >= 0) != (i >= 260)) {
+            fprintf(stderr, "TEST 14 FAILED: Wrong lookup result for key %s!\n", ctrl_keys[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    printf("TEST 14 PASSED\n");
+
+    free_table(ctrl_table);
+
+    /*
+     * Grows and shrinks rehash every entry from its stored hash
+     */
+    static char grow_keys[500][16];
+    HashTable *grow_table = init_hash_table(4);
+    for (int i = 0; i < 500; i++) {
+        snprintf(grow_keys[i], sizeof(grow_keys[i]), "grow_key%d", i);
+        if (add_hash_entry(grow_keys[i], "grow_val", grow_table, RESIZE_AUTOMATICALLY) < 0) {
+            fprintf(stderr, "TEST 15 FAILED: Couldn't add key %s!\n", grow_keys[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int i = 0; i < 500; i++) {
+        int index = search_entry(grow_keys[i], grow_table);
+        if (index < 0 || grow_table->table[index]->hash != hash_key(grow_table, grow_keys[i], strlen(grow_keys[i]))) {
+            fprintf(stderr, "TEST 15 FAILED: Lost key %s after growing!\n", grow_keys[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if ((grow_table->table_size & (grow_table->table_size - 1)) != 0 || grow_table->load_factor > ALPHA_MAX) {
+        fprintf(stderr, "TEST 15 FAILED: Table size %ld is not a power of two!\n", grow_table->table_size);
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 15 PASSED\n");
+
+    size_t grown_size = grow_table->table_size;
+    for (int i = 0; i < 480; i++) {
+        if (remove_hash_entry(grow_keys[i], grow_table, RESIZE_AUTOMATICALLY) != SUCCESS) {
+            fprintf(stderr, "TEST 16 FAILED: Couldn't remove key %s!\n", grow_keys[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int i = 480; i < 500; i++) {
+        if (search_entry(grow_keys[i], grow_table) < 0) {
+            fprintf(stderr, "TEST 16 FAILED: Lost key %s after shrinking!\n", grow_keys[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (grow_table->table_size >= grown_size) {
+        fprintf(stderr, "TEST 16 FAILED: Table did not shrink!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 16 PASSED\n");
+
+    free_table(grow_table);
+
+    /*
+     * Incremental resizing keeps every key reachable
+     * while entries are split between the old and new arrays
+     */
+    static char inc_keys[2000][16];
+    for (int probing = PROBE_LINEAR; probing <= PROBE_ROBIN_HOOD; probing++) {
+        HashTable *inc_table = probing == PROBE_LINEAR ? init_hash_table(4) : init_robin_hood_table(4);
+        inc_table->incremental_resize = true;
+
+        bool seen_rehash = false;
+        for (int i = 0; i < 2000; i++) {
+            snprintf(inc_keys[i], sizeof(inc_keys[i]), "inc_key%d", i);
+            if (add_hash_entry(inc_keys[i], "inc_val", inc_table, RESIZE_AUTOMATICALLY) < 0) {
+                fprintf(stderr, "TEST 17 FAILED: Couldn't add key %s!\n", inc_keys[i]);
+                exit(EXIT_FAILURE);
+            }
+            if (inc_table->old_table) {
+                seen_rehash = true;
+                if (search_entry(inc_keys[i / 2], inc_table) < 0) {
+                    fprintf(stderr, "TEST 17 FAILED: Lost key %s while resizing!\n", inc_keys[i / 2]);
+                    exit(EXIT_FAILURE);
+                }
+            }
+        }
+        if (!seen_rehash || inc_table->count_entry != 2000) {
+            fprintf(stderr, "TEST 17 FAILED: No incremental resize happened!\n");
+            exit(EXIT_FAILURE);
+        }
+        printf("TEST 17 PASSED\n");
+
+        for (int i = 0; i < 1900; i++) {
+            if (remove_hash_entry(inc_keys[i], inc_table, RESIZE_AUTOMATICALLY) != SUCCESS) {
+                fprintf(stderr, "TEST 18 FAILED: Couldn't remove key %s!\n", inc_keys[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        while (inc_table->old_table)
+            rehash_step(inc_table, HASH_REHASH_STEP);
+        for (int i = 0; i < 2000; i++) {
+            if ((search_entry(inc_keys[i], inc_table) >= 0) != (i >= 1900)) {
+                fprintf(stderr, "TEST 18 FAILED: Wrong lookup result for key %s!\n", inc_keys[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        printf("TEST 18 PASSED\n");
+
+        free_table(inc_table);
+    }
+
+    /*
+     * Pluggable hash functions
+     */
+    if (fnv_hash("key4", 4) != fnv_32a_str("key4", FNV1_32A_INIT)) {
+        fprintf(stderr, "TEST 19 FAILED: Length aware FNV differs from string FNV!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 19 PASSED\n");
+
+    HashTable *murmur_table = init_hash_table(4);
+    murmur_table->hash_fn = murmur_hash;
+    for (int i = 0; i < 500; i++) {
+        if (add_hash_entry(grow_keys[i], "murmur_val", murmur_table, RESIZE_AUTOMATICALLY) < 0) {
+            fprintf(stderr, "TEST 20 FAILED: Couldn't add key %s!\n", grow_keys[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int i = 0; i < 500; i++) {
+        int index = search_entry(grow_keys[i], murmur_table);
+        if (index < 0 || murmur_table->table[index]->hash != murmur_hash(grow_keys[i], strlen(grow_keys[i]))) {
+            fprintf(stderr, "TEST 20 FAILED: Lost key %s!\n", grow_keys[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    printf("TEST 20 PASSED\n");
+
+    free_table(murmur_table);
+
+    /*
+     * Linked entries are found again by length and hash after a resize
+     * moves them, binary keys starting with NUL included
+     */
+    static char link_keys[64][4];
+    static HashEntry link_entries[64];
+    HashTable *link_table = init_hash_table(4);
+    if (link_table == NULL)
+        exit(EXIT_FAILURE);
+    link_table->owns_entries = false;
+    for (int i = 0; i < 64; i++) {
+        link_keys[i][1] = (char)('a' + i % 26);
+        link_keys[i][2] = (char)i;
+        link_keys[i][3] = '\0';
+        link_entries[i].key = link_keys[i];
+        link_entries[i].key_len = sizeof(link_keys[i]);
+        link_entries[i].hash = hash_key(link_table, link_keys[i], sizeof(link_keys[i]));
+        int index = link_hash_entry(&link_entries[i], link_table, RESIZE_AUTOMATICALLY);
+        if (index < 0 || link_table->table[index] != &link_entries[i]) {
+            fprintf(stderr, "TEST 21 FAILED: Linking binary key %d returned %d!\n", i, index);
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int i = 0; i < 64; i++) {
+        int index = search_hashed_entry(link_keys[i], sizeof(link_keys[i]), link_entries[i].hash, link_table);
+        if (index < 0 || link_table->table[index] != &link_entries[i]) {
+            fprintf(stderr, "TEST 21 FAILED: Lost binary key %d after resizing!\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (link_table->count_entry != 64 || link_table->table_size <= 4) {
+        fprintf(stderr, "TEST 21 FAILED: Table did not grow around the linked keys!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 21 PASSED\n");
+    free_table(link_table);
+
+    /*
+     * Read-only lookup finds keys in both arrays of a pending
+     * resize without migrating anything
+     */
+    HashTable *read_table = init_robin_hood_table(4);
+    read_table->incremental_resize = true;
+    int added = 0;
+    while (!read_table->old_table || read_table->rehash_index == 0) {
+        add_hash_entry(inc_keys[added], "inc_val", read_table, RESIZE_AUTOMATICALLY);
+        added++;
+    }
+    size_t rehash_index = read_table->rehash_index;
+    for (int i = 0; i < added; i++) {
+        HashEntry *entry = lookup_hashed_entry(inc_keys[i], strlen(inc_keys[i]),
+                hash_key(read_table, inc_keys[i], strlen(inc_keys[i])), read_table);
+        if (!entry || strcmp(entry->key, inc_keys[i]) != 0) {
+            fprintf(stderr, "TEST 22 FAILED: Lookup lost key %s!\n", inc_keys[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (lookup_hashed_entry("missing", 7, hash_key(read_table, "missing", 7), read_table) != NULL
+            || read_table->rehash_index != rehash_index) {
+        fprintf(stderr, "TEST 22 FAILED: Lookup modified the table!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 22 PASSED\n");
+
+    /*
+     * Batched lookup agrees with lookup_hashed_entry, hits and misses,
+     * during a pending resize, on a linear table and on a table
+     * with long probe chains
+     */
+    HashTable *batch_table = init_robin_hood_table(2048);
+    HashTable *linear_batch_table = init_hash_table(1024);
+    for (int i = 0; i < 1500; i++) {
+        add_hash_entry(inc_keys[i], "inc_val", batch_table, RESIZE_AUTOMATICALLY);
+        add_hash_entry(inc_keys[i], "inc_val", linear_batch_table, RESIZE_AUTOMATICALLY);
+    }
+    HashTable *batch_tables[] = { read_table, linear_batch_table, batch_table };
+    static const char *batch_keys[2000];
+    static size_t batch_lens[2000];
+    static Fnv32_t batch_hashes[2000];
+    static HashEntry *batch_results[2000];
+    for (int t = 0; t < 3; t++) {
+        for (int i = 0; i < 2000; i++) {
+            batch_keys[i] = inc_keys[(i * 7) % 2000];
+            batch_lens[i] = strlen(batch_keys[i]);
+            batch_hashes[i] = hash_key(batch_tables[t], batch_keys[i], batch_lens[i]);
+        }
+        lookup_hashed_batch(batch_keys, batch_lens, batch_hashes, 2000, batch_tables[t], batch_results);
+        for (int i = 0; i < 2000; i++) {
+            if (batch_results[i] != lookup_hashed_entry(batch_keys[i], batch_lens[i], batch_hashes[i], batch_tables[t])) {
+                fprintf(stderr, "TEST 23 FAILED: Batch lookup of %s differs!\n", batch_keys[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+    if (read_table->rehash_index != rehash_index) {
+        fprintf(stderr, "TEST 23 FAILED: Batch lookup modified the table!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 23 PASSED\n");
+
+    /*
+     * Probe histogram counts each search once, batched lookups
+     * record the same lengths as scalar ones
+     */
+    u_int64_t scalar_hist[HASH_PROBE_BUCKETS] = { 0 };
+    u_int64_t batch_hist[HASH_PROBE_BUCKETS] = { 0 };
+    batch_table->probe_hist = scalar_hist;
+    for (int i = 0; i < 2000; i++)
+        lookup_hashed_entry(batch_keys[i], batch_lens[i], batch_hashes[i], batch_table);
+    batch_table->probe_hist = batch_hist;
+    lookup_hashed_batch(batch_keys, batch_lens, batch_hashes, 2000, batch_table, batch_results);
+    batch_table->probe_hist = NULL;
+    u_int64_t searches = 0;
+    for (int i = 0; i < HASH_PROBE_BUCKETS; i++)
+        searches += scalar_hist[i];
+    if (searches != 2000 || memcmp(scalar_hist, batch_hist, sizeof(scalar_hist)) != 0) {
+        fprintf(stderr, "TEST 24 FAILED: Probe histograms differ!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 24 PASSED\n");
+
+    free_table(batch_table);
+    free_table(linear_batch_table);
+    free_table(read_table);
+
+    /*
+     * Robin Hood tables keep a size that is not a power of two,
+     * through inserts, removals and resizes
+     */
+    HashTable *odd_table = init_robin_hood_table(557);
+    if (odd_table == NULL || odd_table->table_size != 557)
+        exit(EXIT_FAILURE);
+    for (int i = 0; i < 500; i++) {
+        if (add_hash_entry(grow_keys[i], "odd_val", odd_table, !RESIZE_AUTOMATICALLY) < 0) {
+            fprintf(stderr, "TEST 25 FAILED: Couldn't add key %s!\n", grow_keys[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int i = 0; i < 500; i += 2)
+        remove_hash_entry(grow_keys[i], odd_table, !RESIZE_AUTOMATICALLY);
+    if (resize_table(odd_table, RESIZE_UP) != SUCCESS || odd_table->table_size != 1114
+            || resize_table(odd_table, RESIZE_DOWN) != SUCCESS || odd_table->table_size != 557) {
+        fprintf(stderr, "TEST 25 FAILED: Table size %zu after resizing!\n", odd_table->table_size);
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < 500; i++) {
+        if ((search_entry(grow_keys[i], odd_table) >= 0) != (i % 2 == 1)) {
+            fprintf(stderr, "TEST 25 FAILED: Wrong lookup result for key %s!\n", grow_keys[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    printf("TEST 25 PASSED\n");
+    free_table(odd_table);
+
+    /*
+     * Bulk loading grows an empty Robin Hood table once up front,
+     * then places entries without resizing; full tables refuse
+     */
+    HashTable *bulk_table = init_robin_hood_table(MIN_TABLE_SIZE);
+    HashEntry bulk_entries[500];
+    if (bulk_table == NULL || reserve_hash_table(bulk_table, 500) != SUCCESS
+            || bulk_table->table_size < 500 / ROBIN_HOOD_ALPHA_MAX)
+        exit(EXIT_FAILURE);
+    bulk_table->owns_entries = false;
+    size_t bulk_size = bulk_table->table_size;
+    for (int i = 0; i < 500; i++) {
+        bulk_entries[i].key = grow_keys[i];
+        bulk_entries[i].key_len = strlen(grow_keys[i]);
+        bulk_entries[i].value = "bulk_val";
+        bulk_entries[i].hash = hash_key(bulk_table, grow_keys[i], bulk_entries[i].key_len);
+        if (place_hash_entry(&bulk_entries[i], bulk_table) < 0) {
+            fprintf(stderr, "TEST 26 FAILED: Couldn't place key %s!\n", grow_keys[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (bulk_table->table_size != bulk_size || bulk_table->count_entry != 500
+            || reserve_hash_table(bulk_table, 1000) != FAILURE) {
+        fprintf(stderr, "TEST 26 FAILED: Table resized while placing entries!\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < 500; i++) {
+        int index = search_entry(grow_keys[i], bulk_table);
+        if (index < 0 || bulk_table->table[index] != &bulk_entries[i]) {
+            fprintf(stderr, "TEST 26 FAILED: Placed key %s not found!\n", grow_keys[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    free_table(bulk_table);
+
+    HashTable *full_table = init_robin_hood_table(MIN_TABLE_SIZE);
+    HashTable *linear_table = init_hash_table(MIN_TABLE_SIZE);
+    if (full_table == NULL || linear_table == NULL)
+        exit(EXIT_FAILURE);
+    full_table->owns_entries = false;
+    int full_placed = 0;
+    while (full_placed < 500 && place_hash_entry(&bulk_entries[full_placed], full_table) >= 0)
+        full_placed++;
+    if (full_placed != (int)(ROBIN_HOOD_ALPHA_MAX * MIN_TABLE_SIZE)
+            || place_hash_entry(&bulk_entries[0], linear_table) != FAILURE) {
+        fprintf(stderr, "TEST 26 FAILED: Placed %d entries into a full table!\n", full_placed);
+        exit(EXIT_FAILURE);
+    }
+    free_table(full_table);
+    free_table(linear_table);
+    printf("TEST 26 PASSED\n");
+
     printf("ALL TESTS PASSED!\n");
 #endif // TESTS
 
@@ -1,5 +1,70 @@
+#include <string.h>
+#include <unistd.h>
+
 #include "lru_cache.h"
 
+#ifdef TESTS
+/*
+ * Weighs only the value, plus a fixed per-entry overhead
+ */
+static size_t value_weigher(const void *key, size_t key_len, const void *value, size_t value_len) {
+    (void)key;
+    (void)key_len;
+    (void)value;
+    return value_len + 10;
+}
+
+static u_int64_t fake_now = 1000;
+
+static u_int64_t fake_clock(void) {
+    return fake_now;
+}
+
+/*
+ * Removals seen by record_removals: reasons counted, keys and values
+ * of the last REMOVAL_LOG kept in order
+ */
+#define REMOVAL_LOG 256
+
+typedef struct RemovalLog {
+    size_t count;
+    size_t calls;
+    size_t reasons[4];
+    char keys[REMOVAL_LOG][48];
+    void *values[REMOVAL_LOG];
+} RemovalLog;
+
+static void record_removals(const Removal *removals, size_t count, void *arg) {
+    RemovalLog *log = (RemovalLog *)arg;
+    log->calls++;
+    for (size_t i = 0; i < count; i++, log->count++) {
+        log->reasons[removals[i].reason]++;
+        size_t slot = log->count % REMOVAL_LOG;
+        snprintf(log->keys[slot], sizeof(log->keys[slot]), "%.*s", (int)removals[i].key_len,
+                 (const char *)removals[i].key);
+        log->values[slot] = removals[i].value;
+    }
+}
+
+/*
+ * Counts removals of "stored:N" keys whose value is no longer
+ * the 'a' + N % 26 bytes it was put with
+ */
+static void check_stored_removals(const Removal *removals, size_t count, void *arg) {
+    size_t *corrupt = (size_t *)arg;
+    for (size_t i = 0; i < count; i++) {
+        int n = atoi((const char *)removals[i].key + strlen("stored:"));
+        const char *value = (const char *)removals[i].value;
+        for (size_t j = 0; j < removals[i].value_len; j++) {
+            if (value[j] != 'a' + n % 26) {
+                (*corrupt)++;
+                break;
+            }
+        }
+    }
+}
+#endif
+
 int main(void) {
     LRUCache *lru = init_lru_cache(4);
     printf("\nLRU INFO: \n");
@@ -83,5 +148,1041 @@ int main(void) {
 
     free_lru(lru);
 
+    /*
+     * TESTS
+     */
+#ifdef TESTS
+    /*
+     * Churn many distinct keys through a small cache.
+     * Evictions leave tombstones behind, yet misses must still
+     * end at an empty slot and only the newest keys survive
+     */
+    static char churn_keys[1000][16];
+    lru = init_lru_cache(4);
+    if (!lru)
+        exit(EXIT_FAILURE);
+
+    for (int i = 0; i < 1000; i++) {
+        snprintf(churn_keys[i], sizeof(churn_keys[i]), "churn%d", i);
+        if (put(lru, churn_keys[i], "value") != SUCCESS) {
+            fprintf(stderr, "TEST 1 FAILED: Could not put key %s!\n", churn_keys[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    printf("TEST 1 PASSED\n");
+
+    if (lru->hash_table->count_entry != 4 || lru->dll->list_size != 4) {
+        fprintf(stderr, "TEST 2 FAILED: Cache holds %u entries!\n", lru->hash_table->count_entry);
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 2 PASSED\n");
+
+    for (int i = 996; i < 1000; i++) {
+        if (get(lru, churn_keys[i]) < 0) {
+            fprintf(stderr, "TEST 3 FAILED: Lost key %s!\n", churn_keys[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (get(lru, churn_keys[995]) >= 0) {
+        fprintf(stderr, "TEST 3 FAILED: Evicted key is still present!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 3 PASSED\n");
+
+    size_t empty_slots = 0;
+    for (size_t i = 0; i < lru->hash_table->table_size; i++) {
+        if (lru->hash_table->table[i] == NULL)
+            empty_slots++;
+    }
+    if (empty_slots == 0) {
+        fprintf(stderr, "TEST 4 FAILED: Tombstones filled the whole table!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 4 PASSED\n");
+
+    free_lru(lru);
+
+    /*
+     * Keys are copied: binary keys with NUL bytes, long keys
+     * stored in the arena, and caller buffers reused after put
+     */
+    lru = init_lru_cache(2);
+    if (!lru)
+        exit(EXIT_FAILURE);
+
+    char binary_key[8] = { 'b', 'i', 'n', '\0', 'k', 'e', 'y', '\0' };
+    char long_key[100];
+    memset(long_key, 'L', sizeof(long_key));
+
+    if (put_bytes(lru, binary_key, sizeof(binary_key), "binary", 6) != SUCCESS
+            || put_bytes(lru, long_key, sizeof(long_key), "long", 4) != SUCCESS) {
+        fprintf(stderr, "TEST 5 FAILED: Could not put binary keys!\n");
+        exit(EXIT_FAILURE);
+    }
+    if (get_bytes(lru, binary_key, sizeof(binary_key)) < 0 || get_bytes(lru, binary_key, 3) >= 0
+            || get(lru, "bin") >= 0) {
+        fprintf(stderr, "TEST 5 FAILED: Binary key matched by prefix!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 5 PASSED\n");
+
+    memset(long_key, 'X', sizeof(long_key));
+    if (get_bytes(lru, long_key, sizeof(long_key)) >= 0) {
+        fprintf(stderr, "TEST 6 FAILED: Cache kept the caller's key buffer!\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(long_key, 'L', sizeof(long_key));
+    if (get_bytes(lru, long_key, sizeof(long_key)) < 0 || lru->keys->bytes_used == 0) {
+        fprintf(stderr, "TEST 6 FAILED: Long key not stored in the arena!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 6 PASSED\n");
+
+    /*
+     * Evicting the long key gives its arena block back
+     */
+    put(lru, "short1", "value");
+    put(lru, "short2", "value");
+    if (lru->keys->bytes_used != 0) {
+        fprintf(stderr, "TEST 7 FAILED: Evicted key still holds arena memory!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 7 PASSED\n");
+
+    free_lru(lru);
+
+    /*
+     * Value lookups: get_value promotes, peek_value does not
+     */
+    lru = init_lru_cache(2);
+    if (!lru)
+        exit(EXIT_FAILURE);
+
+    put(lru, "first", "value1");
+    put(lru, "second", "value2");
+
+    void *value = NULL;
+    size_t value_len = 0;
+    if (peek_value(lru, "first", 5, &value, &value_len) != SUCCESS
+            || strcmp((char *)value, "value1") != 0 || value_len != 6) {
+        fprintf(stderr, "TEST 8 FAILED: peek_value returned wrong value!\n");
+        exit(EXIT_FAILURE);
+    }
+    put(lru, "third", "value3");
+    if (peek_value(lru, "first", 5, NULL, NULL) != FAILURE) {
+        fprintf(stderr, "TEST 8 FAILED: peek_value promoted the entry!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 8 PASSED\n");
+
+    if (get_value(lru, "second", 6, &value, NULL) != SUCCESS || strcmp((char *)value, "value2") != 0) {
+        fprintf(stderr, "TEST 9 FAILED: get_value returned wrong value!\n");
+        exit(EXIT_FAILURE);
+    }
+    put(lru, "fourth", "value4");
+    if (peek_value(lru, "second", 6, NULL, NULL) != SUCCESS || peek_value(lru, "third", 5, NULL, NULL) != FAILURE) {
+        fprintf(stderr, "TEST 9 FAILED: get_value did not promote the entry!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 9 PASSED\n");
+
+    free_lru(lru);
+
+    /*
+     * CLOCK: a referenced entry at the tail gets a second chance
+     */
+    lru = init_clock_cache(3);
+    if (!lru)
+        exit(EXIT_FAILURE);
+
+    put(lru, "a", "1");
+    put(lru, "b", "2");
+    put(lru, "c", "3");
+    get_value(lru, "a", 1, NULL, NULL);
+    if (lru->dll->tail != &((LRUEntry *)lookup_hashed_entry("a", 1, hash_key(lru->hash_table, "a", 1), lru->hash_table))->node) {
+        fprintf(stderr, "TEST 10 FAILED: CLOCK hit changed the list!\n");
+        exit(EXIT_FAILURE);
+    }
+    put(lru, "d", "4");
+    if (peek_value(lru, "a", 1, NULL, NULL) != SUCCESS || peek_value(lru, "b", 1, NULL, NULL) != FAILURE) {
+        fprintf(stderr, "TEST 10 FAILED: Referenced entry was evicted!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 10 PASSED\n");
+
+    /*
+     * With every bit set the hand goes around once and evicts
+     * the oldest entry of the new order
+     */
+    get_value(lru, "a", 1, NULL, NULL);
+    get_value(lru, "c", 1, NULL, NULL);
+    get_value(lru, "d", 1, NULL, NULL);
+    put(lru, "e", "5");
+    if (peek_value(lru, "c", 1, NULL, NULL) != FAILURE || lru->hash_table->count_entry != 3
+            || peek_value(lru, "a", 1, NULL, NULL) != SUCCESS || peek_value(lru, "d", 1, NULL, NULL) != SUCCESS) {
+        fprintf(stderr, "TEST 11 FAILED: Wrong victim after full sweep!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 11 PASSED\n");
+
+    free_lru(lru);
+
+    /*
+     * Buffered LRU: hits are applied by the next put
+     */
+    lru = init_buffered_cache(3);
+    if (!lru)
+        exit(EXIT_FAILURE);
+
+    put(lru, "a", "1");
+    put(lru, "b", "2");
+    put(lru, "c", "3");
+    get_value(lru, "a", 1, NULL, NULL);
+    if (((LRUEntry *)lru->dll->tail->data)->hash_entry.key[0] != 'a') {
+        fprintf(stderr, "TEST 12 FAILED: Buffered hit changed the list!\n");
+        exit(EXIT_FAILURE);
+    }
+    put(lru, "d", "4");
+    if (peek_value(lru, "a", 1, NULL, NULL) != SUCCESS || peek_value(lru, "b", 1, NULL, NULL) != FAILURE) {
+        fprintf(stderr, "TEST 12 FAILED: Buffered hit was not applied before eviction!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 12 PASSED\n");
+
+    free_lru(lru);
+
+    /*
+     * SLRU: a scan only flushes probation
+     */
+    lru = init_policy_cache(5, &slru_policy);
+    if (!lru)
+        exit(EXIT_FAILURE);
+
+    put(lru, "a", "1");
+    put(lru, "b", "2");
+    get_value(lru, "a", 1, NULL, NULL);
+    char scan_key[16];
+    for (int i = 0; i < 20; i++) {
+        snprintf(scan_key, sizeof(scan_key), "scan%d", i);
+        put(lru, scan_key, "scan");
+    }
+    if (peek_value(lru, "a", 1, NULL, NULL) != SUCCESS || peek_value(lru, "b", 1, NULL, NULL) != FAILURE
+            || lru->hash_table->count_entry != 5) {
+        fprintf(stderr, "TEST 13 FAILED: Protected entry lost to a scan!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 13 PASSED\n");
+
+    free_lru(lru);
+
+    /*
+     * 2Q: a key evicted from A1in and seen again goes to Am
+     */
+    lru = init_policy_cache(8, &two_queue_policy);
+    if (!lru)
+        exit(EXIT_FAILURE);
+
+    char queue_key[16];
+    for (int i = 0; i < 9; i++) {
+        snprintf(queue_key, sizeof(queue_key), "k%d", i);
+        put(lru, queue_key, "value");
+    }
+    if (peek_value(lru, "k0", 2, NULL, NULL) != FAILURE) {
+        fprintf(stderr, "TEST 14 FAILED: Oldest A1in entry was not evicted!\n");
+        exit(EXIT_FAILURE);
+    }
+    put(lru, "k0", "value");
+    LRUEntry *entry = (LRUEntry *)lookup_hashed_entry("k0", 2, hash_key(lru->hash_table, "k0", 2), lru->hash_table);
+    if (!entry || entry->segment != 1) {
+        fprintf(stderr, "TEST 14 FAILED: Ghost hit was not admitted to Am!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 14 PASSED\n");
+
+    free_lru(lru);
+
+    /*
+     * ARC: entries hit twice move to T2, a B1 ghost hit is admitted to T2
+     */
+    lru = init_policy_cache(4, &arc_policy);
+    if (!lru)
+        exit(EXIT_FAILURE);
+
+    put(lru, "a", "1");
+    put(lru, "b", "2");
+    put(lru, "c", "3");
+    put(lru, "d", "4");
+    get_value(lru, "a", 1, NULL, NULL);
+    get_value(lru, "b", 1, NULL, NULL);
+    put(lru, "e", "5");
+    put(lru, "c", "3");
+    entry = (LRUEntry *)lookup_hashed_entry("c", 1, hash_key(lru->hash_table, "c", 1), lru->hash_table);
+    if (!entry || entry->segment != 1 || peek_value(lru, "d", 1, NULL, NULL) != FAILURE
+            || peek_value(lru, "a", 1, NULL, NULL) != SUCCESS || peek_value(lru, "b", 1, NULL, NULL) != SUCCESS) {
+        fprintf(stderr, "TEST 15 FAILED: Wrong ARC replacement!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 15 PASSED\n");
+
+    free_lru(lru);
+
+    /*
+     * W-TinyLFU: one-hit wonders do not push out a popular hot set
+     */
+    lru = init_policy_cache(100, &tinylfu_policy);
+    if (!lru)
+        exit(EXIT_FAILURE);
+
+    char lfu_key[16];
+    for (int round = 0; round < 4; round++) {
+        for (int i = 0; i < 50; i++) {
+            snprintf(lfu_key, sizeof(lfu_key), "hot%d", i);
+            if (get_value(lru, lfu_key, strlen(lfu_key), NULL, NULL) != SUCCESS)
+                put(lru, lfu_key, "hot");
+        }
+    }
+    for (int i = 0; i < 1000; i++) {
+        snprintf(lfu_key, sizeof(lfu_key), "once%d", i);
+        put(lru, lfu_key, "once");
+    }
+    int hot_left = 0;
+    for (int i = 0; i < 50; i++) {
+        snprintf(lfu_key, sizeof(lfu_key), "hot%d", i);
+        if (peek_value(lru, lfu_key, strlen(lfu_key), NULL, NULL) == SUCCESS)
+            hot_left++;
+    }
+    if (hot_left < 45 || lru->hash_table->count_entry != 100) {
+        fprintf(stderr, "TEST 16 FAILED: Only %d of 50 hot keys survived!\n", hot_left);
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 16 PASSED\n");
+
+    free_lru(lru);
+
+    /*
+     * Byte budget: weights evict from the tail until the new entry fits
+     */
+    lru = init_weighted_cache(100, 100, &lru_policy, NULL);
+    if (!lru)
+        exit(EXIT_FAILURE);
+
+    char blob[64] = { 0 };
+    put_weighted(lru, "a", 1, blob, sizeof(blob), 40);
+    put_weighted(lru, "b", 1, blob, sizeof(blob), 40);
+    put_weighted(lru, "c", 1, blob, sizeof(blob), 20);
+    if (lru->total_weight != 100 || lru->hash_table->count_entry != 3) {
+        fprintf(stderr, "TEST 17 FAILED: Expected weight 100 in 3 entries, got %zu!\n", lru->total_weight);
+        exit(EXIT_FAILURE);
+    }
+    put_weighted(lru, "d", 1, blob, sizeof(blob), 70);
+    if (lru->total_weight != 90 || peek_value(lru, "a", 1, NULL, NULL) != FAILURE
+            || peek_value(lru, "b", 1, NULL, NULL) != FAILURE || peek_value(lru, "c", 1, NULL, NULL) != SUCCESS) {
+        fprintf(stderr, "TEST 17 FAILED: Wrong entries evicted for weight, total %zu!\n", lru->total_weight);
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 17 PASSED\n");
+
+    /*
+     * Entries heavier than the whole budget are refused and evict nothing
+     */
+    if (put_weighted(lru, "e", 1, blob, sizeof(blob), 101) != FAILURE
+            || lru->total_weight != 90 || lru->hash_table->count_entry != 2) {
+        fprintf(stderr, "TEST 18 FAILED: Oversized entry was not rejected!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 18 PASSED\n");
+
+    /*
+     * Updates keep total weight exact, shrinking and growing
+     */
+    put_weighted(lru, "d", 1, blob, sizeof(blob), 30);
+    if (lru->total_weight != 50) {
+        fprintf(stderr, "TEST 19 FAILED: Shrinking update left weight %zu!\n", lru->total_weight);
+        exit(EXIT_FAILURE);
+    }
+    put_weighted(lru, "c", 1, blob, sizeof(blob), 60);
+    if (lru->total_weight != 90 || lru->hash_table->count_entry != 2) {
+        fprintf(stderr, "TEST 19 FAILED: Growing update left weight %zu!\n", lru->total_weight);
+        exit(EXIT_FAILURE);
+    }
+    put_weighted(lru, "d", 1, blob, sizeof(blob), 80);
+    if (lru->total_weight != 80 || lru->hash_table->count_entry != 1 || peek_value(lru, "c", 1, NULL, NULL) != FAILURE) {
+        fprintf(stderr, "TEST 19 FAILED: Update past budget left weight %zu!\n", lru->total_weight);
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 19 PASSED\n");
+
+    free_lru(lru);
+
+    /*
+     * Weigher callback sizes entries put without explicit weight
+     */
+    lru = init_weighted_cache(100, 100, &slru_policy, value_weigher);
+    if (!lru)
+        exit(EXIT_FAILURE);
+
+    for (int i = 0; i < 20; i++) {
+        snprintf(lfu_key, sizeof(lfu_key), "w%d", i);
+        put_bytes(lru, lfu_key, strlen(lfu_key), blob, 15);
+    }
+    if (lru->total_weight != 100 || lru->hash_table->count_entry != 4
+            || peek_value(lru, "w19", 3, NULL, NULL) != SUCCESS) {
+        fprintf(stderr, "TEST 20 FAILED: Weigher gave total %zu in %u entries!\n",
+                lru->total_weight, lru->hash_table->count_entry);
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 20 PASSED\n");
+
+    free_lru(lru);
+
+    /*
+     * TTL: expired entries miss and get_value removes them
+     */
+    lru = init_lru_cache(100);
+    if (!lru)
+        exit(EXIT_FAILURE);
+    lru->clock = fake_clock;
+
+    put_ttl(lru, "a", 1, blob, 1, 100);
+    put_bytes(lru, "b", 1, blob, 1);
+    fake_now += 99;
+    if (get_value(lru, "a", 1, NULL, NULL) != SUCCESS) {
+        fprintf(stderr, "TEST 21 FAILED: Entry expired early!\n");
+        exit(EXIT_FAILURE);
+    }
+    fake_now += 1;
+    if (peek_value(lru, "a", 1, NULL, NULL) != FAILURE || lru->hash_table->count_entry != 2) {
+        fprintf(stderr, "TEST 21 FAILED: peek_value should miss without removing!\n");
+        exit(EXIT_FAILURE);
+    }
+    if (get_value(lru, "a", 1, NULL, NULL) != FAILURE || lru->hash_table->count_entry != 1
+            || lru->total_weight != 2 || get_value(lru, "b", 1, NULL, NULL) != SUCCESS) {
+        fprintf(stderr, "TEST 21 FAILED: Expired entry was not removed!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 21 PASSED\n");
+
+    /*
+     * Timer wheel removes expired entries nobody looks up
+     */
+    for (int i = 0; i < 50; i++) {
+        snprintf(lfu_key, sizeof(lfu_key), "ttl%d", i);
+        put_ttl(lru, lfu_key, strlen(lfu_key), blob, 1, 10 + i);
+    }
+    fake_now += 100;
+    expire_entries(lru, (size_t)-1);
+    if (lru->hash_table->count_entry != 1 || lru->timers->count != 0 || lru->timer_pool->count_used != 0) {
+        fprintf(stderr, "TEST 22 FAILED: %u entries left after expiry!\n", lru->hash_table->count_entry);
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < 50; i++) {
+        snprintf(lfu_key, sizeof(lfu_key), "ttl%d", i);
+        put_ttl(lru, lfu_key, strlen(lfu_key), blob, 1, 10);
+    }
+    fake_now += 10;
+    for (int i = 0; i < 20; i++)
+        put_bytes(lru, "b", 1, blob, 1);
+    if (lru->hash_table->count_entry != 1) {
+        fprintf(stderr, "TEST 22 FAILED: Puts did not advance the timer wheel!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 22 PASSED\n");
+
+    /*
+     * Plain put clears the TTL, put_ttl again extends it
+     */
+    put_ttl(lru, "c", 1, blob, 1, 10);
+    put_bytes(lru, "c", 1, blob, 1);
+    put_ttl(lru, "d", 1, blob, 1, 10);
+    fake_now += 5;
+    put_ttl(lru, "d", 1, blob, 1, 10);
+    fake_now += 5;
+    if (get_value(lru, "c", 1, NULL, NULL) != SUCCESS || get_value(lru, "d", 1, NULL, NULL) != SUCCESS) {
+        fprintf(stderr, "TEST 23 FAILED: TTL was not cleared or extended!\n");
+        exit(EXIT_FAILURE);
+    }
+    fake_now += 5;
+    if (get_value(lru, "d", 1, NULL, NULL) != FAILURE || lru->timers->count != 0) {
+        fprintf(stderr, "TEST 23 FAILED: Extended TTL did not expire!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 23 PASSED\n");
+
+    free_lru(lru);
+
+    /*
+     * Shared-lock lookups only miss, the next put removes the entry
+     */
+    lru = init_buffered_cache(100);
+    if (!lru)
+        exit(EXIT_FAILURE);
+    lru->clock = fake_clock;
+
+    put_ttl(lru, "a", 1, blob, 1, 10);
+    get_value(lru, "a", 1, NULL, NULL);
+    fake_now += 10;
+    if (get_value(lru, "a", 1, NULL, NULL) != FAILURE || lru->hash_table->count_entry != 1) {
+        fprintf(stderr, "TEST 24 FAILED: Buffered lookup removed or returned expired entry!\n");
+        exit(EXIT_FAILURE);
+    }
+    put_bytes(lru, "b", 1, blob, 1);
+    if (peek_value(lru, "a", 1, NULL, NULL) != FAILURE || lru->hash_table->count_entry != 1) {
+        fprintf(stderr, "TEST 24 FAILED: Put did not expire buffered entry!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 24 PASSED\n");
+
+    free_lru(lru);
+
+    /*
+     * mget matches get_value key by key, misses included,
+     * and promotes its hits
+     */
+    lru = init_lru_cache(100);
+    if (!lru)
+        exit(EXIT_FAILURE);
+
+    static char batch_keys[150][16];
+    static char batch_values[150][16];
+    const void *keys[150];
+    size_t key_lens[150];
+    void *values[150];
+    size_t value_lens[150];
+    for (int i = 0; i < 150; i++) {
+        snprintf(batch_keys[i], sizeof(batch_keys[i]), "batch%d", i);
+        snprintf(batch_values[i], sizeof(batch_values[i]), "value%d", i);
+        keys[i] = batch_keys[i];
+        key_lens[i] = strlen(batch_keys[i]);
+        values[i] = batch_values[i];
+        value_lens[i] = strlen(batch_values[i]);
+    }
+
+    /*
+     * Only the last 100 pairs fit
+     */
+    if (mput(lru, keys, key_lens, values, value_lens, 150) != SUCCESS || lru->hash_table->count_entry != 100) {
+        fprintf(stderr, "TEST 25 FAILED: mput stored %u entries!\n", lru->hash_table->count_entry);
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 25 PASSED\n");
+
+    void *found[150];
+    size_t found_lens[150];
+    size_t hits = mget(lru, keys, key_lens, 150, found, found_lens);
+    if (hits != 100) {
+        fprintf(stderr, "TEST 26 FAILED: mget found %zu of 100 keys!\n", hits);
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < 150; i++) {
+        void *value = NULL;
+        size_t value_len = 0;
+        peek_value(lru, keys[i], key_lens[i], &value, &value_len);
+        if (found[i] != value || found_lens[i] != value_len || (i >= 50 && found[i] != batch_values[i])) {
+            fprintf(stderr, "TEST 26 FAILED: mget disagrees on %s!\n", batch_keys[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    /*
+     * Hits are promoted in batch order, batch50 is oldest again
+     * until a batch of its own moves it to the front
+     */
+    const void *first[] = { keys[50] };
+    mget(lru, first, &key_lens[50], 1, NULL, NULL);
+    put(lru, "newcomer", "value");
+    if (peek_value(lru, keys[50], key_lens[50], NULL, NULL) != SUCCESS
+            || peek_value(lru, keys[51], key_lens[51], NULL, NULL) != FAILURE) {
+        fprintf(stderr, "TEST 26 FAILED: mget did not promote its hits!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 26 PASSED\n");
+
+    free_lru(lru);
+
+    /*
+     * Counters follow every kind of operation
+     */
+    lru = init_lru_cache(2);
+    if (lru == NULL)
+        exit(EXIT_FAILURE);
+    lru->clock = fake_clock;
+
+    put(lru, "one", "value");
+    put(lru, "two", "value");
+    put(lru, "one", "changed");
+    put(lru, "three", "value");
+    get_value(lru, "one", 3, NULL, NULL);
+    get_value(lru, "two", 3, NULL, NULL);
+    peek_value(lru, "one", 3, NULL, NULL);
+    put_ttl(lru, "four", 4, "value", 5, 10);
+    fake_now += 10;
+    get_value(lru, "four", 4, NULL, NULL);
+
+    CacheStats stats;
+    cache_stats_snapshot(lru, &stats);
+    if (stats.inserts != 4 || stats.replacements != 1 || stats.evictions != 2
+            || stats.hits != 1 || stats.misses != 2 || stats.expirations != 1
+            || stats_hit_ratio(&stats) < 0.33 || stats_hit_ratio(&stats) > 0.34) {
+        fprintf(stderr, "TEST 27 FAILED: Counters do not match the operations!\n");
+        print_stats(&stats);
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 27 PASSED\n");
+
+    free_lru(lru);
+
+    /*
+     * Once enabled every search lands in the probe histogram,
+     * latency is only recorded once sampling is on
+     */
+    lru = init_lru_cache(1000);
+    if (lru == NULL)
+        exit(EXIT_FAILURE);
+    if (lru->hash_table->probe_hist != NULL || enable_probe_stats(lru) != SUCCESS) {
+        fprintf(stderr, "TEST 28 FAILED: Probe histogram is not opt-in!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    char stats_key[32];
+    for (int i = 0; i < 1000; i++) {
+        snprintf(stats_key, sizeof(stats_key), "stats:%d", i);
+        put_bytes(lru, stats_key, strlen(stats_key), "value", 5);
+    }
+    lru->latency_sample = 4;
+    for (int i = 0; i < 1000; i++) {
+        snprintf(stats_key, sizeof(stats_key), "stats:%d", i);
+        get_value(lru, stats_key, strlen(stats_key), NULL, NULL);
+    }
+
+    cache_stats_snapshot(lru, &stats);
+    u_int64_t searches = 0, sampled = 0;
+    for (int i = 0; i < STATS_PROBE_BUCKETS; i++)
+        searches += stats.probe_lengths[i];
+    for (int i = 0; i < STATS_LATENCY_BUCKETS; i++) {
+        sampled += stats.get_latency[i];
+        if (stats.put_latency[i] != 0) {
+            fprintf(stderr, "TEST 28 FAILED: Put latency recorded while sampling was off!\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (searches != 2000 || stats.probe_lengths[0] == 0 || sampled != 250
+            || stats_latency_quantile(stats.get_latency, 0.5) == 0) {
+        fprintf(stderr, "TEST 28 FAILED: %llu searches, %llu sampled gets!\n",
+                (unsigned long long)searches, (unsigned long long)sampled);
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 28 PASSED\n");
+
+    free_lru(lru);
+
+    /*
+     * Sampled curve predicts the miss ratio the cache actually had
+     */
+    lru = init_lru_cache(500);
+    if (lru == NULL || enable_mrc_sampler(lru, 400) != SUCCESS)
+        exit(EXIT_FAILURE);
+
+    unsigned int mrc_seed = 3;
+    for (int i = 0; i < 50000; i++) {
+        mrc_seed = mrc_seed * 1103515245u + 12345u;
+        double u = (double)(mrc_seed >> 8) / (double)(1u << 24);
+        snprintf(stats_key, sizeof(stats_key), "mrc:%u", (unsigned int)(5000 * u * u));
+        if (get_value(lru, stats_key, strlen(stats_key), NULL, NULL) != SUCCESS)
+            put_bytes(lru, stats_key, strlen(stats_key), "value", 5);
+    }
+
+    cache_stats_snapshot(lru, &stats);
+    double observed = 1.0 - stats_hit_ratio(&stats);
+    double estimated = cache_miss_ratio(lru, 500);
+    if (mrc_sample_rate(lru->mrc) >= 1.0 || estimated < observed - 0.03 || estimated > observed + 0.03
+            || cache_miss_ratio(lru, 2000) >= estimated) {
+        fprintf(stderr, "TEST 29 FAILED: Estimated miss ratio %.4f, observed %.4f!\n", estimated, observed);
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 29 PASSED\n");
+
+    free_lru(lru);
+
+    /*
+     * Removal listener hears every value leaving the cache, with its reason
+     */
+    static RemovalLog removal_log;
+    static char removal_values[8][8] = { "v0", "v1", "v2", "v3", "v4", "v5", "v6", "v7" };
+    lru = init_lru_cache(2);
+    if (lru == NULL || set_removal_listener(lru, record_removals, &removal_log, false) != SUCCESS)
+        exit(EXIT_FAILURE);
+    lru->clock = fake_clock;
+
+    put_bytes(lru, "a", 1, removal_values[0], 2);
+    put_bytes(lru, "a", 1, removal_values[0], 2);                 // same value, nothing removed
+    put_bytes(lru, "a", 1, removal_values[1], 2);                 // replaced
+    put_bytes(lru, "b", 1, removal_values[2], 2);
+    put_bytes(lru, "c", 1, removal_values[3], 2);                 // evicts a
+    remove_key(lru, "b", 1);                              // explicit
+    put_ttl(lru, "d", 1, removal_values[4], 2, 10);
+    fake_now += 10;
+    if (remove_key(lru, "b", 1) != FAILURE || get_value(lru, "d", 1, NULL, NULL) != FAILURE) {
+        fprintf(stderr, "TEST 30 FAILED: Removed keys are still cached!\n");
+        exit(EXIT_FAILURE);
+    }
+    if (removal_log.count != 4 || removal_log.reasons[REMOVAL_REPLACED] != 1
+            || removal_log.reasons[REMOVAL_EVICTED] != 1 || removal_log.reasons[REMOVAL_EXPLICIT] != 1
+            || removal_log.reasons[REMOVAL_EXPIRED] != 1 || removal_log.values[0] != removal_values[0]
+            || removal_log.values[1] != removal_values[1] || strcmp(removal_log.keys[1], "a") != 0
+            || removal_log.values[2] != removal_values[2] || removal_log.values[3] != removal_values[4]) {
+        fprintf(stderr, "TEST 30 FAILED: Wrong removals reported!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    free_lru(lru);
+    if (removal_log.count != 5 || removal_log.reasons[REMOVAL_EXPLICIT] != 2 || removal_log.values[4] != removal_values[3]) {
+        fprintf(stderr, "TEST 30 FAILED: free_lru did not report the cached values!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 30 PASSED\n");
+
+    /*
+     * Deferred removals wait in the queue with copies of their keys
+     * and are delivered in batches
+     */
+    memset(&removal_log, 0, sizeof(removal_log));
+    lru = init_lru_cache(10);
+    if (lru == NULL || set_removal_listener(lru, record_removals, &removal_log, true) != SUCCESS)
+        exit(EXIT_FAILURE);
+
+    char removal_key[48];
+    for (int i = 0; i < 10 + 2 * LRU_REMOVAL_BATCH + 5; i++) {
+        snprintf(removal_key, sizeof(removal_key), "deferred:%d:padded-past-the-inline-key", i);
+        put_bytes(lru, removal_key, strlen(removal_key), removal_values[i % 8], 2);
+    }
+    if (removal_log.count != 0 || lru->removals.count != 2 * LRU_REMOVAL_BATCH + 5) {
+        fprintf(stderr, "TEST 31 FAILED: Removals were not deferred!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    RemovalQueue taken;
+    if (take_removals(lru, &taken) != 2 * LRU_REMOVAL_BATCH + 5 || lru->removals.count != 0
+            || deliver_removals(&taken, record_removals, &removal_log) != 2 * LRU_REMOVAL_BATCH + 5
+            || removal_log.calls != 3 || removal_log.reasons[REMOVAL_EVICTED] != 2 * LRU_REMOVAL_BATCH + 5
+            || strcmp(removal_log.keys[0], "deferred:0:padded-past-the-inline-key") != 0
+            || removal_log.values[1] != removal_values[1]) {
+        fprintf(stderr, "TEST 31 FAILED: Deferred removals were not delivered in batches!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    put_bytes(lru, "short", 5, removal_values[0], 2);
+    if (reclaim_removals(lru) != 1 || strcmp(removal_log.keys[(removal_log.count - 1) % REMOVAL_LOG],
+                                             "deferred:133:padded-past-the-inline-key") != 0) {
+        fprintf(stderr, "TEST 31 FAILED: Reclaimed wrong removal!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    remove_key(lru, "short", 5);
+    size_t before_free = removal_log.count;
+    free_lru(lru);
+    if (removal_log.count != before_free + 10 || strcmp(removal_log.keys[before_free % REMOVAL_LOG], "short") != 0) {
+        fprintf(stderr, "TEST 31 FAILED: free_lru dropped deferred removals!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 31 PASSED\n");
+
+    /*
+     * Snapshots restore entries, values and recency order;
+     * a smaller cache keeps the most recently used ones
+     */
+    char snapshot_path[] = "/tmp/test_lru_snapshot.XXXXXX";
+    int snapshot_fd = mkstemp(snapshot_path);
+    if (snapshot_fd < 0)
+        exit(EXIT_FAILURE);
+    close(snapshot_fd);
+
+    static char snapshot_values[100][16];
+    lru = init_lru_cache(100);
+    if (lru == NULL)
+        exit(EXIT_FAILURE);
+    lru->clock = fake_clock;
+    for (int i = 0; i < 100; i++) {
+        snprintf(removal_key, sizeof(removal_key), i % 2 ? "snap:%d" : "snapshot-key-longer-than-inline:%d", i);
+        snprintf(snapshot_values[i], sizeof(snapshot_values[i]), "value %d", i);
+        if (i == 7)
+            put_ttl(lru, removal_key, strlen(removal_key), snapshot_values[i], strlen(snapshot_values[i]) + 1, 500);
+        else
+            put_bytes(lru, removal_key, strlen(removal_key), snapshot_values[i], strlen(snapshot_values[i]) + 1);
+    }
+    get_value(lru, "snap:1", 6, NULL, NULL);
+    if (save_snapshot(lru, snapshot_path) != SUCCESS) {
+        fprintf(stderr, "TEST 32 FAILED: Could not save snapshot!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    LRUCache *restored = init_lru_cache(100);
+    if (restored == NULL || load_snapshot(restored, snapshot_path) != SUCCESS
+            || restored->hash_table->count_entry != 100 || restored->total_weight != lru->total_weight) {
+        fprintf(stderr, "TEST 32 FAILED: Snapshot did not load!\n");
+        exit(EXIT_FAILURE);
+    }
+    for (Node *a = lru->dll->head, *b = restored->dll->head; a || b; a = a->next, b = b->next) {
+        LRUEntry *x = (LRUEntry *)a->data, *y = b ? (LRUEntry *)b->data : NULL;
+        if (!y || x->hash_entry.key_len != y->hash_entry.key_len
+                || memcmp(x->hash_entry.key, y->hash_entry.key, x->hash_entry.key_len) != 0
+                || x->value_len != y->value_len || memcmp(x->hash_entry.value, y->hash_entry.value, x->value_len) != 0
+                || !cache_owns_value(restored, y->hash_entry.value) || cache_owns_value(lru, x->hash_entry.value)) {
+            fprintf(stderr, "TEST 32 FAILED: Restored entries differ or are out of order!\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    void *restored_value = NULL;
+    if (get_value(restored, "snap:1", 6, &restored_value, NULL) != SUCCESS || strcmp(restored_value, "value 1") != 0
+            || restored->timers == NULL || put_bytes(restored, "new", 3, "value", 5) != SUCCESS) {
+        fprintf(stderr, "TEST 32 FAILED: Restored cache does not work!\n");
+        exit(EXIT_FAILURE);
+    }
+    free_lru(restored);
+
+    restored = init_lru_cache(10);
+    if (restored == NULL || load_snapshot(restored, snapshot_path) != SUCCESS
+            || restored->hash_table->count_entry != 10 || peek_value(restored, "snap:1", 6, NULL, NULL) != SUCCESS
+            || peek_value(restored, "snap:99", 7, NULL, NULL) != SUCCESS
+            || peek_value(restored, "snapshot-key-longer-than-inline:0", 33, NULL, NULL) != FAILURE
+            || load_snapshot(restored, snapshot_path) != FAILURE) {
+        fprintf(stderr, "TEST 32 FAILED: Smaller cache did not keep the hottest entries!\n");
+        exit(EXIT_FAILURE);
+    }
+    free_lru(restored);
+    free_lru(lru);
+    printf("TEST 32 PASSED\n");
+
+    /*
+     * Segmented policies save every segment, TTLs keep running
+     * and corrupt snapshots load nothing
+     */
+    lru = init_policy_cache(50, &slru_policy);
+    if (lru == NULL)
+        exit(EXIT_FAILURE);
+    lru->clock = fake_clock;
+    for (int i = 0; i < 50; i++) {
+        snprintf(removal_key, sizeof(removal_key), "slru:%d", i);
+        if (i < 25)
+            put_ttl(lru, removal_key, strlen(removal_key), snapshot_values[i], 8, 100);
+        else
+            put_bytes(lru, removal_key, strlen(removal_key), snapshot_values[i], 8);
+    }
+    for (int i = 0; i < 10; i++) {
+        snprintf(removal_key, sizeof(removal_key), "slru:%d", i);
+        get_value(lru, removal_key, strlen(removal_key), NULL, NULL);
+    }
+    fake_now += 50;
+    if (save_snapshot(lru, snapshot_path) != SUCCESS)
+        exit(EXIT_FAILURE);
+    free_lru(lru);
+
+    lru = init_policy_cache(50, &slru_policy);
+    if (lru == NULL)
+        exit(EXIT_FAILURE);
+    lru->clock = fake_clock;
+    if (load_snapshot(lru, snapshot_path) != SUCCESS || lru->hash_table->count_entry != 50) {
+        fprintf(stderr, "TEST 33 FAILED: Segmented cache did not load!\n");
+        exit(EXIT_FAILURE);
+    }
+    fake_now += 50;
+    if (expire_entries(lru, 100) != 25 || lru->hash_table->count_entry != 25) {
+        fprintf(stderr, "TEST 33 FAILED: Loaded TTLs did not keep running!\n");
+        exit(EXIT_FAILURE);
+    }
+    free_lru(lru);
+
+    FILE *snapshot_file = fopen(snapshot_path, "r+b");
+    if (!snapshot_file)
+        exit(EXIT_FAILURE);
+    fseek(snapshot_file, -1, SEEK_END);
+    fputc('!', snapshot_file);
+    fclose(snapshot_file);
+    lru = init_lru_cache(50);
+    if (lru == NULL || load_snapshot(lru, snapshot_path) == SUCCESS || lru->hash_table->count_entry != 0) {
+        fprintf(stderr, "TEST 33 FAILED: Corrupt snapshot was loaded!\n");
+        exit(EXIT_FAILURE);
+    }
+    free_lru(lru);
+    unlink(snapshot_path);
+    printf("TEST 33 PASSED\n");
+
+    /*
+     * Value store copies every value, the caller's buffer is reused.
+     * Segments are reclaimed least recently used first,
+     * taking the entries whose values live there
+     */
+    memset(&removal_log, 0, sizeof(removal_log));
+    lru = init_lru_cache(1000);
+    if (lru == NULL || enable_value_store(lru, 4096, 4, NULL) != SUCCESS
+            || set_removal_listener(lru, record_removals, &removal_log, false) != SUCCESS)
+        exit(EXIT_FAILURE);
+
+    char stored_value[200];
+    for (int i = 0; i < 100; i++) {
+        if (i == 60)
+            get_value(lru, "stored:0", 8, NULL, NULL);
+        snprintf(removal_key, sizeof(removal_key), "stored:%d", i);
+        memset(stored_value, 'a' + i % 26, sizeof(stored_value));
+        if (put_bytes(lru, removal_key, strlen(removal_key), stored_value, sizeof(stored_value)) != SUCCESS) {
+            fprintf(stderr, "TEST 34 FAILED: Could not put stored value %d!\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    void *stored = NULL;
+    size_t stored_len = 0;
+    cache_stats_snapshot(lru, &stats);
+    if (get_value(lru, "stored:99", 9, &stored, &stored_len) != SUCCESS || stored_len != sizeof(stored_value)
+            || ((char *)stored)[0] != 'a' + 99 % 26 || ((char *)stored)[199] != 'a' + 99 % 26
+            || !cache_owns_value(lru, stored) || cache_owns_value(lru, stored_value)) {
+        fprintf(stderr, "TEST 34 FAILED: Stored value is not a copy owned by the cache!\n");
+        exit(EXIT_FAILURE);
+    }
+    if (peek_value(lru, "stored:0", 8, NULL, NULL) != SUCCESS || peek_value(lru, "stored:18", 9, NULL, NULL) != FAILURE
+            || stats.evictions == 0 || removal_log.reasons[REMOVAL_EVICTED] != stats.evictions
+            || lru->hash_table->count_entry != 100 - stats.evictions) {
+        fprintf(stderr, "TEST 34 FAILED: Reclaimed segment was not the least recently used!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t live_bytes = lru->values->live_bytes;
+    if (put_bytes(lru, "stored:99", 9, "short", 5) != SUCCESS || removal_log.reasons[REMOVAL_REPLACED] != 1
+            || lru->values->live_bytes != live_bytes - 200 + 8) {
+        fprintf(stderr, "TEST 34 FAILED: Replaced value was not released!\n");
+        exit(EXIT_FAILURE);
+    }
+    free_lru(lru);
+    printf("TEST 34 PASSED\n");
+
+    /*
+     * File-backed store works the same, its file is gone once mapped.
+     * A value larger than a segment is refused
+     */
+    char store_path[] = "/tmp/test_lru_values.XXXXXX";
+    int store_fd = mkstemp(store_path);
+    if (store_fd < 0)
+        exit(EXIT_FAILURE);
+    close(store_fd);
+    lru = init_lru_cache(100);
+    if (lru == NULL || enable_value_store(lru, 4096, 2, store_path) != SUCCESS || access(store_path, F_OK) == 0) {
+        fprintf(stderr, "TEST 35 FAILED: File-backed store not created or file left behind!\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(stored_value, "file value", 11);
+    if (put_bytes(lru, "file", 4, stored_value, 11) != SUCCESS)
+        exit(EXIT_FAILURE);
+    memset(stored_value, 0, sizeof(stored_value));
+    if (get_value(lru, "file", 4, &stored, NULL) != SUCCESS || strcmp(stored, "file value") != 0
+            || !cache_owns_value(lru, stored)) {
+        fprintf(stderr, "TEST 35 FAILED: File-backed value is wrong!\n");
+        exit(EXIT_FAILURE);
+    }
+    static char large_value[8192];
+    if (put_bytes(lru, "large", 5, large_value, sizeof(large_value)) == SUCCESS
+            || peek_value(lru, "large", 5, NULL, NULL) != FAILURE || lru->hash_table->count_entry != 1) {
+        fprintf(stderr, "TEST 35 FAILED: Value larger than a segment was stored!\n");
+        exit(EXIT_FAILURE);
+    }
+    free_lru(lru);
+    printf("TEST 35 PASSED\n");
+
+    /*
+     * Buffered cache under reads alone: full stripes are drained
+     * by the lookups themselves, so no hit is lost and recency holds
+     */
+    lru = init_buffered_cache(100);
+    if (lru == NULL)
+        exit(EXIT_FAILURE);
+    for (int i = 0; i < 100; i++) {
+        snprintf(removal_key, sizeof(removal_key), "read:%d", i);
+        put_bytes(lru, removal_key, strlen(removal_key), "value", 5);
+    }
+    for (int i = 0; i < 80; i++) {
+        snprintf(removal_key, sizeof(removal_key), "read:%d", i);
+        get_value(lru, removal_key, strlen(removal_key), NULL, NULL);
+    }
+    drain_reads(lru);
+    Node *read_node = lru->dll->tail;
+    for (int i = 80; i < 100; i++, read_node = read_node->prev) {
+        snprintf(removal_key, sizeof(removal_key), "read:%d", i);
+        LRUEntry *read_entry = (LRUEntry *)read_node->data;
+        if (read_entry->hash_entry.key_len != strlen(removal_key)
+                || memcmp(read_entry->hash_entry.key, removal_key, read_entry->hash_entry.key_len) != 0) {
+            fprintf(stderr, "TEST 36 FAILED: %s is not where reads alone should leave it!\n", removal_key);
+            exit(EXIT_FAILURE);
+        }
+    }
+    free_lru(lru);
+    printf("TEST 36 PASSED\n");
+
+    /*
+     * Policies without on_load still load every entry,
+     * through on_insert from the coldest one
+     */
+    char tinylfu_path[] = "/tmp/test_lru_snapshot.XXXXXX";
+    int tinylfu_fd = mkstemp(tinylfu_path);
+    if (tinylfu_fd < 0)
+        exit(EXIT_FAILURE);
+    close(tinylfu_fd);
+    lru = init_policy_cache(100, &tinylfu_policy);
+    if (lru == NULL)
+        exit(EXIT_FAILURE);
+    for (int i = 0; i < 100; i++) {
+        snprintf(removal_key, sizeof(removal_key), "tinylfu:%d", i);
+        put_bytes(lru, removal_key, strlen(removal_key), snapshot_values[i], 8);
+    }
+    if (save_snapshot(lru, tinylfu_path) != SUCCESS)
+        exit(EXIT_FAILURE);
+    restored = init_policy_cache(100, &tinylfu_policy);
+    if (restored == NULL || load_snapshot(restored, tinylfu_path) != SUCCESS
+            || restored->hash_table->count_entry != 100) {
+        fprintf(stderr, "TEST 37 FAILED: Snapshot did not load through on_insert!\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < 100; i++) {
+        snprintf(removal_key, sizeof(removal_key), "tinylfu:%d", i);
+        void *loaded = NULL;
+        if (peek_value(restored, removal_key, strlen(removal_key), &loaded, NULL) != SUCCESS
+                || memcmp(loaded, snapshot_values[i], 8) != 0) {
+            fprintf(stderr, "TEST 37 FAILED: %s was not loaded!\n", removal_key);
+            exit(EXIT_FAILURE);
+        }
+    }
+    free_lru(restored);
+    free_lru(lru);
+    unlink(tinylfu_path);
+    printf("TEST 37 PASSED\n");
+
+    /*
+     * Deferred removals keep a copy of stored values,
+     * their segments are reclaimed and reused before delivery
+     */
+    size_t corrupt = 0;
+    lru = init_lru_cache(1000);
+    if (lru == NULL || enable_value_store(lru, 4096, 4, NULL) != SUCCESS
+            || set_removal_listener(lru, check_stored_removals, &corrupt, true) != SUCCESS)
+        exit(EXIT_FAILURE);
+    for (int i = 0; i < 100; i++) {
+        snprintf(removal_key, sizeof(removal_key), "stored:%d", i);
+        memset(stored_value, 'a' + i % 26, sizeof(stored_value));
+        put_bytes(lru, removal_key, strlen(removal_key), stored_value, sizeof(stored_value));
+    }
+    size_t queued = lru->removals.count;
+    cache_stats_snapshot(lru, &stats);
+    if (queued == 0 || queued != stats.evictions || reclaim_removals(lru) != queued || corrupt != 0) {
+        fprintf(stderr, "TEST 38 FAILED: %zu of %zu deferred stored values changed before delivery!\n",
+                corrupt, queued);
+        exit(EXIT_FAILURE);
+    }
+    free_lru(lru);
+    if (corrupt != 0) {
+        fprintf(stderr, "TEST 38 FAILED: free_lru reported changed stored values!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 38 PASSED\n");
+
+    printf("ALL TESTS PASSED!\n");
+#endif // TESTS
+
     exit(EXIT_SUCCESS);
 }
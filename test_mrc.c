@@ -0,0 +1,112 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "mrc.h"
+
+#ifdef TESTS
+#define ACCESSES 2000000
+#define KEY_SPACE 1000000
+#define MAX_CAPACITY 64000
+
+static unsigned long long rng_state = 5;
+
+static unsigned long long next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+/*
+ * Skewed keys with a uniform tail, hashed like a table would
+ */
+static u_int32_t next_key(void) {
+    double u = (double)(next_random() >> 11) / (double)(1ULL << 53);
+    u_int32_t key = next_random() % 10 ? (u_int32_t)(200000 * u * u) : (u_int32_t)(next_random() % KEY_SPACE);
+
+    return (key + 1) * 0x9E3779B1u;
+}
+
+static u_int64_t exact_hits[MAX_CAPACITY];
+#endif
+
+int main(void) {
+    MissRatioSampler *sampler = init_mrc_sampler(MRC_SAMPLE_KEYS);
+    if (sampler == NULL) {
+        printf("Failed to initialize miss ratio sampler!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /*
+     * TESTS
+     */
+#ifdef TESTS
+    if (mrc_miss_ratio(sampler, 100) != 1.0 || mrc_sample_rate(sampler) != 1.0) {
+        fprintf(stderr, "TEST 1 FAILED: Empty sampler predicts hits!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /*
+     * Below the key limit every key is sampled, the curve is exact
+     * up to the width of a histogram bucket (100..103 here)
+     */
+    for (int round = 0; round < 3; round++) {
+        for (u_int32_t key = 1; key <= 100; key++)
+            mrc_access(sampler, key);
+    }
+    if (mrc_sample_rate(sampler) != 1.0 || fabs(mrc_miss_ratio(sampler, 103) - 1.0 / 3) > 1e-9
+            || mrc_miss_ratio(sampler, 99) != 1.0) {
+        fprintf(stderr, "TEST 1 FAILED: Fully sampled loop gives wrong ratios!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 1 PASSED\n");
+
+    /*
+     * Estimates follow the exact LRU curve within a few points
+     * while tracking a fraction of the keys
+     */
+    free_mrc_sampler(sampler);
+    sampler = init_mrc_sampler(MRC_SAMPLE_KEYS);
+    StackDistance *exact = init_stack_distance(MAX_CAPACITY);
+    if (!sampler || !exact)
+        exit(EXIT_FAILURE);
+
+    for (int i = 0; i < ACCESSES; i++) {
+        u_int32_t hval = next_key();
+        mrc_access(sampler, hval);
+        size_t distance = stack_distance_access(exact, hval);
+        if (distance != STACK_DISTANCE_COLD)
+            exact_hits[distance - 1]++;
+    }
+    if (mrc_sample_rate(sampler) > 0.05 || sampler->stack->count > MRC_SAMPLE_KEYS) {
+        fprintf(stderr, "TEST 2 FAILED: Sampler kept %zu keys at rate %.4f!\n",
+                sampler->stack->count, mrc_sample_rate(sampler));
+        exit(EXIT_FAILURE);
+    }
+
+    u_int64_t hits = 0;
+    size_t depth = 0;
+    for (size_t capacity = 1000; capacity <= MAX_CAPACITY; capacity *= 2) {
+        for (; depth < capacity; depth++)
+            hits += exact_hits[depth];
+        double expected = 1.0 - (double)hits / ACCESSES;
+        double estimate = mrc_miss_ratio(sampler, capacity);
+        if (fabs(estimate - expected) > 0.02) {
+            fprintf(stderr, "TEST 2 FAILED: Miss ratio at %zu estimated %.4f, exact %.4f!\n",
+                    capacity, estimate, expected);
+            exit(EXIT_FAILURE);
+        }
+    }
+    printf("TEST 2 PASSED\n");
+
+    free_stack_distance(exact);
+
+    printf("ALL TESTS PASSED!\n");
+#endif
+
+    free_mrc_sampler(sampler);
+
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include "read_buffer.h"
+
+#define THREAD_COUNT 8
+
+static ReadBuffer *shared;
+static int items[READ_BUFFER_SIZE * 2];
+static int order_ok = 1;
+static int next_expected;
+
+static void check_order(void *item, void *arg) {
+    (void)arg;
+    if ((int *)item != &items[next_expected])
+        order_ok = 0;
+    next_expected++;
+}
+
+static void count_item(void *item, void *arg) {
+    (void)item;
+    (*(size_t *)arg)++;
+}
+
+/*
+ * Record until the thread's own stripe is full
+ */
+static void *recorder(void *arg) {
+    size_t *recorded = (size_t *)arg;
+    for (int i = 0; i < READ_BUFFER_SIZE * 4; i++) {
+        if (record_read(shared, &items[i % READ_BUFFER_SIZE]) == SUCCESS)
+            (*recorded)++;
+    }
+
+    return NULL;
+}
+
+int main(void) {
+    ReadBuffer *buffer = init_read_buffer();
+    if (buffer == NULL) {
+        printf("Failed to initialize read buffer!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /*
+     * TESTS
+     */
+#ifdef TESTS
+    for (int i = 0; i < READ_BUFFER_SIZE; i++) {
+        if (record_read(buffer, &items[i]) != SUCCESS) {
+            fprintf(stderr, "TEST 1 FAILED: Record %d dropped before stripe was full!\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (!read_buffer_full(buffer) || record_read(buffer, &items[READ_BUFFER_SIZE]) != FAILURE) {
+        fprintf(stderr, "TEST 1 FAILED: Full stripe accepted another record!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 1 PASSED\n");
+
+    if (drain_read_buffer(buffer, check_order, NULL) != READ_BUFFER_SIZE || !order_ok) {
+        fprintf(stderr, "TEST 2 FAILED: Drain did not apply records in order!\n");
+        exit(EXIT_FAILURE);
+    }
+    if (read_buffer_full(buffer) || drain_read_buffer(buffer, check_order, NULL) != 0) {
+        fprintf(stderr, "TEST 2 FAILED: Buffer not empty after drain!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 2 PASSED\n");
+
+    /*
+     * Ring wraps around after a drain
+     */
+    next_expected = 0;
+    for (int i = 0; i < READ_BUFFER_SIZE / 2; i++)
+        record_read(buffer, &items[i]);
+    if (drain_read_buffer(buffer, check_order, NULL) != READ_BUFFER_SIZE / 2 || !order_ok) {
+        fprintf(stderr, "TEST 3 FAILED: Wrapped records applied wrongly!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 3 PASSED\n");
+
+    /*
+     * Threads take their own stripes, each one fills up exactly once
+     */
+    shared = buffer;
+    pthread_t threads[THREAD_COUNT];
+    size_t recorded[THREAD_COUNT] = { 0 };
+    for (size_t i = 0; i < THREAD_COUNT; i++)
+        pthread_create(&threads[i], NULL, recorder, &recorded[i]);
+    for (size_t i = 0; i < THREAD_COUNT; i++)
+        pthread_join(threads[i], NULL);
+
+    size_t total = 0, drained = 0;
+    for (size_t i = 0; i < THREAD_COUNT; i++)
+        total += recorded[i];
+    drain_read_buffer(buffer, count_item, &drained);
+    if (total != THREAD_COUNT * READ_BUFFER_SIZE || drained != total) {
+        fprintf(stderr, "TEST 4 FAILED: Recorded %zu, drained %zu!\n", total, drained);
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 4 PASSED\n");
+
+    printf("ALL TESTS PASSED!\n");
+#endif
+
+    free_read_buffer(buffer);
+
+    return 0;
+}
@@ -0,0 +1,286 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "sharded.h"
+
+#define THREAD_COUNT 8
+#define THREAD_OPS 20000
+#define THREAD_KEYS 512
+
+static ShardedLRUCache *shared;
+static u_int64_t fake_now = 1000;
+
+static u_int64_t fake_clock(void) {
+    return fake_now;
+}
+
+/*
+ * Deferred removals delivered so far and the largest batch
+ */
+static u_int64_t removed;
+static size_t largest_batch;
+
+static void count_removals(const Removal *removals, size_t count, void *arg) {
+    (void)removals;
+    __atomic_fetch_add(&removed, count, __ATOMIC_RELAXED);
+
+    size_t largest = __atomic_load_n(&largest_batch, __ATOMIC_RELAXED);
+    while (count > largest
+            && !__atomic_compare_exchange_n(&largest_batch, &largest, count, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+
+    /*
+     * Delivery happens off the shard lock, calling back in is safe
+     */
+    if (arg)
+        sharded_count((ShardedLRUCache *)arg);
+}
+
+/*
+ * Mixed puts and gets on keys shared by all threads
+ */
+static void *worker(void *arg) {
+    unsigned seed = (unsigned)(size_t)arg;
+    char key[32];
+
+    for (int i = 0; i < THREAD_OPS; i++) {
+        seed = seed * 1103515245u + 12345u;
+        snprintf(key, sizeof(key), "key:%u", (seed >> 16) % THREAD_KEYS);
+        if (seed & 1)
+            sharded_put(shared, key, "value");
+        else
+            sharded_get(shared, key);
+    }
+
+    return NULL;
+}
+
+int main(void) {
+    ShardedLRUCache *cache = init_sharded_cache(64, 6);
+    if (cache == NULL) {
+        printf("Failed to initialize sharded cache!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /*
+     * TESTS
+     */
+#ifdef TESTS
+    if (cache->shard_count != 8 || cache->shards[0].cache->capacity != 8) {
+        fprintf(stderr, "TEST 1 FAILED: Shard count not rounded to power of two!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 1 PASSED\n");
+
+    sharded_put(cache, "first", "value1");
+    sharded_put(cache, "second", "value2");
+    void *value = NULL;
+    size_t value_len = 0;
+    if (sharded_get_value(cache, "first", 5, &value, &value_len) != SUCCESS
+            || strcmp((char *)value, "value1") != 0 || value_len != 6
+            || sharded_get(cache, "second") != SUCCESS || sharded_get(cache, "third") != FAILURE) {
+        fprintf(stderr, "TEST 2 FAILED: Lookup returned wrong result!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 2 PASSED\n");
+
+    /*
+     * Every shard evicts on its own, total never exceeds the sum of shards
+     */
+    char key[32];
+    for (int i = 0; i < 1000; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        sharded_put(cache, key, "value");
+    }
+    if (sharded_count(cache) != 64) {
+        fprintf(stderr, "TEST 3 FAILED: Expected 64 entries, found %zu!\n", sharded_count(cache));
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 3 PASSED\n");
+
+    free_sharded_cache(cache);
+
+    /*
+     * Concurrent access from several threads
+     */
+    shared = init_sharded_cache(128, 16);
+    if (shared == NULL)
+        exit(EXIT_FAILURE);
+
+    pthread_t threads[THREAD_COUNT];
+    for (size_t i = 0; i < THREAD_COUNT; i++)
+        pthread_create(&threads[i], NULL, worker, (void *)(i + 1));
+    for (size_t i = 0; i < THREAD_COUNT; i++)
+        pthread_join(threads[i], NULL);
+
+    if (sharded_count(shared) > 128) {
+        fprintf(stderr, "TEST 4 FAILED: Cache grew beyond capacity!\n");
+        exit(EXIT_FAILURE);
+    }
+    sharded_put(shared, "last", "value");
+    if (sharded_get(shared, "last") != SUCCESS) {
+        fprintf(stderr, "TEST 4 FAILED: Cache unusable after concurrent access!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 4 PASSED\n");
+
+    free_sharded_cache(shared);
+
+    /*
+     * CLOCK shards serve lookups under the shared lock
+     */
+    shared = init_sharded_clock_cache(128, 16);
+    if (shared == NULL || shared->shards[0].cache->policy != &clock_policy)
+        exit(EXIT_FAILURE);
+
+    for (size_t i = 0; i < THREAD_COUNT; i++)
+        pthread_create(&threads[i], NULL, worker, (void *)(i + 1));
+    for (size_t i = 0; i < THREAD_COUNT; i++)
+        pthread_join(threads[i], NULL);
+
+    if (sharded_count(shared) > 128) {
+        fprintf(stderr, "TEST 5 FAILED: CLOCK cache grew beyond capacity!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 5 PASSED\n");
+
+    free_sharded_cache(shared);
+
+    /*
+     * Buffered shards drain hits under try-lock
+     */
+    shared = init_sharded_buffered_cache(128, 16);
+    if (shared == NULL || !shared->shards[0].cache->reads)
+        exit(EXIT_FAILURE);
+
+    for (size_t i = 0; i < THREAD_COUNT; i++)
+        pthread_create(&threads[i], NULL, worker, (void *)(i + 1));
+    for (size_t i = 0; i < THREAD_COUNT; i++)
+        pthread_join(threads[i], NULL);
+
+    if (sharded_count(shared) > 128) {
+        fprintf(stderr, "TEST 6 FAILED: Buffered cache grew beyond capacity!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 6 PASSED\n");
+
+    free_sharded_cache(shared);
+
+    /*
+     * Every shard expires its own entries
+     */
+    shared = init_sharded_cache(256, 8);
+    if (shared == NULL)
+        exit(EXIT_FAILURE);
+    for (size_t i = 0; i < shared->shard_count; i++)
+        shared->shards[i].cache->clock = fake_clock;
+
+    char ttl_key[32];
+    for (int i = 0; i < 100; i++) {
+        snprintf(ttl_key, sizeof(ttl_key), "ttl:%d", i);
+        sharded_put_ttl(shared, ttl_key, strlen(ttl_key), "value", 5, 10);
+    }
+    fake_now += 10;
+    for (int i = 0; i < 100; i++) {
+        snprintf(ttl_key, sizeof(ttl_key), "ttl:%d", i);
+        if (sharded_get_value(shared, ttl_key, strlen(ttl_key), NULL, NULL) != FAILURE) {
+            fprintf(stderr, "TEST 7 FAILED: Expired key %s was returned!\n", ttl_key);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (sharded_count(shared) != 0) {
+        fprintf(stderr, "TEST 7 FAILED: %zu expired entries left!\n", sharded_count(shared));
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 7 PASSED\n");
+
+    free_sharded_cache(shared);
+
+    /*
+     * Snapshots run alongside traffic and account for every operation
+     */
+    shared = init_sharded_clock_cache(128, 4);
+    if (shared == NULL)
+        exit(EXIT_FAILURE);
+
+    for (size_t i = 0; i < THREAD_COUNT; i++)
+        pthread_create(&threads[i], NULL, worker, (void *)(i + 1));
+    CacheStats snapshot;
+    u_int64_t seen = 0;
+    for (int i = 0; i < 100; i++) {
+        sharded_stats_snapshot(shared, &snapshot);
+        u_int64_t ops = snapshot.hits + snapshot.misses + snapshot.inserts + snapshot.replacements;
+        if (ops < seen) {
+            fprintf(stderr, "TEST 8 FAILED: Counters went backwards!\n");
+            exit(EXIT_FAILURE);
+        }
+        seen = ops;
+    }
+    for (size_t i = 0; i < THREAD_COUNT; i++)
+        pthread_join(threads[i], NULL);
+
+    sharded_stats_snapshot(shared, &snapshot);
+    if (snapshot.hits + snapshot.misses + snapshot.inserts + snapshot.replacements
+            != (u_int64_t)THREAD_COUNT * THREAD_OPS
+            || snapshot.inserts - snapshot.evictions != sharded_count(shared)) {
+        fprintf(stderr, "TEST 8 FAILED: Snapshot lost operations!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 8 PASSED\n");
+
+    free_sharded_cache(shared);
+
+    /*
+     * Deferred removals reach the listener in batches, every
+     * eviction is delivered once the queues are reclaimed
+     */
+    shared = init_sharded_cache(128, 4);
+    if (shared == NULL || sharded_set_removal_listener(shared, count_removals, shared, true) != SUCCESS)
+        exit(EXIT_FAILURE);
+
+    for (size_t i = 0; i < THREAD_COUNT; i++)
+        pthread_create(&threads[i], NULL, worker, (void *)(i + 1));
+    for (size_t i = 0; i < THREAD_COUNT; i++)
+        pthread_join(threads[i], NULL);
+
+    u_int64_t delivered = removed;
+    delivered += sharded_reclaim_removals(shared);
+    sharded_stats_snapshot(shared, &snapshot);
+    if (delivered != snapshot.evictions || removed != delivered || largest_batch > LRU_REMOVAL_BATCH
+            || snapshot.evictions == 0) {
+        fprintf(stderr, "TEST 9 FAILED: %llu removals delivered, %llu evictions!\n",
+                (unsigned long long)delivered, (unsigned long long)snapshot.evictions);
+        exit(EXIT_FAILURE);
+    }
+
+    /*
+     * The cache being freed must not be called back
+     */
+    sharded_set_removal_listener(shared, count_removals, NULL, true);
+    sharded_reclaim_removals(shared);
+    sharded_put(shared, "explicit", "value");
+    sharded_reclaim_removals(shared);
+    u_int64_t expected = removed + sharded_count(shared);
+    if (sharded_remove(shared, "explicit", 8) != SUCCESS || sharded_remove(shared, "explicit", 8) != FAILURE
+            || sharded_reclaim_removals(shared) != 1) {
+        fprintf(stderr, "TEST 9 FAILED: sharded_remove did not remove once!\n");
+        exit(EXIT_FAILURE);
+    }
+    free_sharded_cache(shared);
+    if (removed != expected) {
+        fprintf(stderr, "TEST 9 FAILED: Freeing reported %llu values, expected %llu!\n",
+                (unsigned long long)removed, (unsigned long long)expected);
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 9 PASSED\n");
+
+    printf("ALL TESTS PASSED!\n");
+#else
+    free_sharded_cache(cache);
+#endif
+
+    return 0;
+}
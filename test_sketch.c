@@ -0,0 +1,79 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "sketch.h"
+
+int main(void) {
+    FrequencySketch *sketch = init_frequency_sketch(1000);
+    if (sketch == NULL) {
+        printf("Failed to initialize frequency sketch!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /*
+     * TESTS
+     */
+#ifdef TESTS
+    if (sketch->width != 1024 || sketch->sample_size != 10000) {
+        fprintf(stderr, "TEST 1 FAILED: Sketch sized wrongly!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 1 PASSED\n");
+
+    u_int32_t hot = 0xDEADBEEFu;
+    for (int i = 0; i < 5; i++)
+        sketch_increment(sketch, hot);
+    if (sketch_frequency(sketch, hot) != 5) {
+        fprintf(stderr, "TEST 2 FAILED: Expected frequency 5, got %u!\n", sketch_frequency(sketch, hot));
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < 20; i++)
+        sketch_increment(sketch, hot);
+    if (sketch_frequency(sketch, hot) != SKETCH_MAX_COUNT) {
+        fprintf(stderr, "TEST 2 FAILED: Counter did not saturate!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 2 PASSED\n");
+
+    /*
+     * Keys seen once stay far below a hot key
+     */
+    unsigned int overestimated = 0;
+    for (u_int32_t i = 1; i <= 500; i++)
+        sketch_increment(sketch, i * 2654435761u);
+    for (u_int32_t i = 1; i <= 500; i++) {
+        if (sketch_frequency(sketch, i * 2654435761u) > 2)
+            overestimated++;
+    }
+    if (overestimated > 10) {
+        fprintf(stderr, "TEST 3 FAILED: %u of 500 keys overestimated!\n", overestimated);
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 3 PASSED\n");
+
+    sketch_age(sketch);
+    if (sketch_frequency(sketch, hot) != SKETCH_MAX_COUNT / 2) {
+        fprintf(stderr, "TEST 4 FAILED: Aging did not halve the counter!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 4 PASSED\n");
+
+    /*
+     * Increments alone trigger aging after sample_size additions
+     */
+    for (u_int32_t i = 0; i < 20000; i++)
+        sketch_increment(sketch, (i + 1000) * 2246822519u);
+    if (sketch_frequency(sketch, hot) >= SKETCH_MAX_COUNT / 2 || sketch->additions >= sketch->sample_size) {
+        fprintf(stderr, "TEST 5 FAILED: Sketch did not age on its own!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 5 PASSED\n");
+
+    printf("ALL TESTS PASSED!\n");
+#endif
+
+    free_frequency_sketch(sketch);
+
+    return 0;
+}
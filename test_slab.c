@@ -0,0 +1,70 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "slab.h"
+
+typedef struct Object {
+    long a;
+    long b;
+    char name[24];
+} Object;
+
+int main(void) {
+    SlabPool *pool = init_slab_pool(sizeof(Object), 4);
+    if (pool == NULL) {
+        printf("Failed to initialize slab pool!\n");
+        exit(EXIT_FAILURE);
+    }
+
+#ifdef DEBUG
+    printf("Object size: %ld\n", pool->object_size);
+    printf("# of objects: %ld\n", pool->count_total);
+#endif
+
+    /*
+     * TESTS
+     */
+#ifdef TESTS
+    Object *objects[4];
+    for (int i = 0; i < 4; i++) {
+        objects[i] = (Object *)slab_alloc(pool);
+        if (objects[i] == NULL || objects[i]->a != 0 || objects[i]->name[0] != '\0') {
+            fprintf(stderr, "TEST 1 FAILED: Couldn't allocate zeroed object!\n");
+            exit(EXIT_FAILURE);
+        }
+        objects[i]->a = i;
+    }
+    printf("TEST 1 PASSED\n");
+
+    if (pool->count_used != 4 || pool->count_total != 4) {
+        fprintf(stderr, "TEST 2 FAILED: Pool grew before it was exhausted!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 2 PASSED\n");
+
+    /*
+     * Freed object is handed out again without growing the pool
+     */
+    slab_free(pool, objects[2]);
+    Object *reused = (Object *)slab_alloc(pool);
+    if (reused != objects[2] || pool->count_total != 4) {
+        fprintf(stderr, "TEST 3 FAILED: Freed object was not recycled!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 3 PASSED\n");
+
+    Object *extra = (Object *)slab_alloc(pool);
+    if (extra == NULL || pool->count_total != 8 || pool->count_used != 5) {
+        fprintf(stderr, "TEST 4 FAILED: Exhausted pool did not grow!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 4 PASSED\n");
+
+    printf("ALL TESTS PASSED!\n");
+#endif // TESTS
+
+    free_slab_pool(pool);
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,158 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "snapshot.h"
+
+#ifdef TESTS
+#define RECORDS 1000
+
+static char path[] = "/tmp/test_snapshot.XXXXXX";
+
+/*
+ * Write RECORDS records, record i holds key "key:i" and i + 1 bytes of value
+ */
+static int write_records(const char *target) {
+    static char value[RECORDS + 1];
+    SnapshotWriter *writer = open_snapshot(target);
+    if (!writer)
+        return FAILURE;
+
+    char key[32];
+    for (int i = 0; i < RECORDS; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        memset(value, 'a' + i % 26, (size_t)i + 1);
+        if (write_snapshot_record(writer, key, strlen(key), value, (size_t)i + 1, (u_int32_t)i, (u_int64_t)i * 10)
+                != SUCCESS) {
+            abort_snapshot(writer);
+            return FAILURE;
+        }
+    }
+
+    return commit_snapshot(writer);
+}
+
+/*
+ * Flip one byte at "offset" of the file
+ */
+static void corrupt(const char *target, long offset) {
+    FILE *file = fopen(target, "r+b");
+    if (!file)
+        exit(EXIT_FAILURE);
+    fseek(file, offset, SEEK_SET);
+    int byte = fgetc(file);
+    fseek(file, offset, SEEK_SET);
+    fputc(byte ^ 0x40, file);
+    fclose(file);
+}
+#endif
+
+int main(void) {
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        printf("Failed to create snapshot file!\n");
+        exit(EXIT_FAILURE);
+    }
+    close(fd);
+
+    /*
+     * TESTS
+     */
+#ifdef TESTS
+    if (write_records(path) != SUCCESS) {
+        fprintf(stderr, "TEST 1 FAILED: Could not write snapshot!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    SnapshotView *view = map_snapshot(path, SIZE_MAX);
+    if (!view || view->count != RECORDS || view->loaded != RECORDS) {
+        fprintf(stderr, "TEST 1 FAILED: Snapshot did not map back!\n");
+        exit(EXIT_FAILURE);
+    }
+    char key[32];
+    for (int i = 0; i < RECORDS; i++) {
+        const SnapshotRecord *record = snapshot_record(view, (size_t)i);
+        const char *value = (const char *)snapshot_value(record);
+        snprintf(key, sizeof(key), "key:%d", i);
+        if (record->key_len != strlen(key) || memcmp(snapshot_key(record), key, record->key_len) != 0
+                || record->value_len != (u_int64_t)i + 1 || record->weight != (u_int32_t)i
+                || record->ttl_ms != (u_int64_t)i * 10 || value[0] != 'a' + i % 26 || value[i] != 'a' + i % 26
+                || (uintptr_t)value % 8 != 0 || !snapshot_owns(view, value)) {
+            fprintf(stderr, "TEST 1 FAILED: Record %d came back wrong!\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (snapshot_owns(view, key)) {
+        fprintf(stderr, "TEST 1 FAILED: Stack memory is not part of the snapshot!\n");
+        exit(EXIT_FAILURE);
+    }
+    unmap_snapshot(view);
+    printf("TEST 1 PASSED\n");
+
+    /*
+     * Only a prefix is located, all of it is checked
+     */
+    view = map_snapshot(path, 10);
+    if (!view || view->count != RECORDS || view->loaded != 10
+            || memcmp(snapshot_key(snapshot_record(view, 9)), "key:9", 5) != 0) {
+        fprintf(stderr, "TEST 2 FAILED: Prefix of the snapshot not located!\n");
+        exit(EXIT_FAILURE);
+    }
+    unmap_snapshot(view);
+    printf("TEST 2 PASSED\n");
+
+    /*
+     * Corrupt or truncated files are refused
+     */
+    corrupt(path, (long)sizeof(SnapshotHeader) + 4000);
+    if (map_snapshot(path, 10) != NULL) {
+        fprintf(stderr, "TEST 3 FAILED: Corrupt record accepted!\n");
+        exit(EXIT_FAILURE);
+    }
+    corrupt(path, (long)sizeof(SnapshotHeader) + 4000);
+    corrupt(path, (long)offsetof(SnapshotHeader, count));
+    if (map_snapshot(path, 10) != NULL) {
+        fprintf(stderr, "TEST 3 FAILED: Corrupt header accepted!\n");
+        exit(EXIT_FAILURE);
+    }
+    corrupt(path, (long)offsetof(SnapshotHeader, count));
+    if (truncate(path, 4096) != 0 || map_snapshot(path, 10) != NULL) {
+        fprintf(stderr, "TEST 3 FAILED: Truncated snapshot accepted!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 3 PASSED\n");
+
+    /*
+     * An aborted snapshot leaves the previous one in place
+     */
+    if (write_records(path) != SUCCESS)
+        exit(EXIT_FAILURE);
+    SnapshotWriter *writer = open_snapshot(path);
+    if (!writer || write_snapshot_record(writer, "only", 4, "value", 5, 0, 0) != SUCCESS)
+        exit(EXIT_FAILURE);
+    abort_snapshot(writer);
+    view = map_snapshot(path, 1);
+    if (!view || view->count != RECORDS) {
+        fprintf(stderr, "TEST 4 FAILED: Aborted snapshot replaced the previous one!\n");
+        exit(EXIT_FAILURE);
+    }
+    unmap_snapshot(view);
+
+    writer = open_snapshot(path);
+    if (!writer || commit_snapshot(writer) != SUCCESS || !(view = map_snapshot(path, 1)) || view->count != 0) {
+        fprintf(stderr, "TEST 4 FAILED: Empty snapshot did not replace the previous one!\n");
+        exit(EXIT_FAILURE);
+    }
+    unmap_snapshot(view);
+    printf("TEST 4 PASSED\n");
+
+    printf("ALL TESTS PASSED!\n");
+#endif // TESTS
+
+    unlink(path);
+
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "stack_distance.h"
+
+#define MAX_KEYS 100
+
+#ifdef TESTS
+
+/*
+ * Reference LRU stack, most recent first
+ */
+static u_int64_t reference[MAX_KEYS];
+static size_t reference_count;
+
+static size_t reference_access(u_int64_t key, size_t max_keys) {
+    size_t depth = 0;
+    while (depth < reference_count && reference[depth] != key)
+        depth++;
+
+    size_t distance = depth < reference_count ? depth + 1 : STACK_DISTANCE_COLD;
+    if (depth == reference_count) {
+        if (reference_count < max_keys)
+            reference_count++;
+        depth = reference_count - 1;
+    }
+    memmove(&reference[1], &reference[0], depth * sizeof(u_int64_t));
+    reference[0] = key;
+
+    return distance;
+}
+
+static void reference_remove(u_int64_t key) {
+    for (size_t depth = 0; depth < reference_count; depth++) {
+        if (reference[depth] == key) {
+            memmove(&reference[depth], &reference[depth + 1], (reference_count - depth - 1) * sizeof(u_int64_t));
+            reference_count--;
+            return;
+        }
+    }
+}
+
+static unsigned long long rng_state = 11;
+
+static unsigned long long next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+#endif
+
+int main(void) {
+    StackDistance *stack = init_stack_distance(MAX_KEYS);
+    if (stack == NULL) {
+        printf("Failed to initialize stack distance!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /*
+     * TESTS
+     */
+#ifdef TESTS
+    u_int64_t trace[] = { 1, 2, 3, 1, 1, 3, 2, 4 };
+    size_t expected[] = { 0, 0, 0, 3, 1, 2, 3, 0 };
+    for (size_t i = 0; i < sizeof(trace) / sizeof(trace[0]); i++) {
+        size_t distance = stack_distance_access(stack, trace[i]);
+        if (distance != expected[i]) {
+            fprintf(stderr, "TEST 1 FAILED: Access %zu at distance %zu, expected %zu!\n", i, distance, expected[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    printf("TEST 1 PASSED\n");
+
+    /*
+     * Long random stream agrees with a naive LRU stack through
+     * renumbering, dropped keys and removals
+     */
+    free_stack_distance(stack);
+    stack = init_stack_distance(MAX_KEYS);
+    for (int i = 0; i < 200000; i++) {
+        u_int64_t key = next_random() % 150;
+        if (i % 7 == 0) {
+            int removed = stack_distance_remove(stack, key);
+            size_t before = reference_count;
+            reference_remove(key);
+            if ((removed == SUCCESS) != (reference_count < before)) {
+                fprintf(stderr, "TEST 2 FAILED: Removal of %llu disagrees!\n", (unsigned long long)key);
+                exit(EXIT_FAILURE);
+            }
+            continue;
+        }
+
+        size_t distance = stack_distance_access(stack, key);
+        size_t expected_distance = reference_access(key, MAX_KEYS);
+        if (distance != expected_distance || stack->count != reference_count) {
+            fprintf(stderr, "TEST 2 FAILED: Access %d of %llu at distance %zu, expected %zu!\n",
+                    i, (unsigned long long)key, distance, expected_distance);
+            exit(EXIT_FAILURE);
+        }
+    }
+    printf("TEST 2 PASSED\n");
+
+    /*
+     * Keys that share a home slot survive deletions in their cluster
+     */
+    free_stack_distance(stack);
+    stack = init_stack_distance(4);
+    u_int64_t colliding[4];
+    size_t found = 0;
+    for (u_int64_t key = 1; found < 4; key++) {
+        if ((key * 0x9E3779B97F4A7C15ull) >> (64 - stack->map_bits) == 0)
+            colliding[found++] = key;
+    }
+    for (size_t i = 0; i < 4; i++)
+        stack_distance_access(stack, colliding[i]);
+    stack_distance_remove(stack, colliding[0]);
+    if (stack_distance_access(stack, colliding[3]) != 1 || stack_distance_access(stack, colliding[1]) != 3
+            || stack_distance_remove(stack, colliding[0]) != FAILURE) {
+        fprintf(stderr, "TEST 3 FAILED: Colliding keys were lost!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 3 PASSED\n");
+
+    printf("ALL TESTS PASSED!\n");
+#endif
+
+    free_stack_distance(stack);
+
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "stats.h"
+
+int main(void) {
+    CacheStats stats;
+    memset(&stats, 0, sizeof(stats));
+
+    /*
+     * TESTS
+     */
+#ifdef TESTS
+    if (stats_hit_ratio(&stats) != 0.0 || stats_latency_quantile(stats.get_latency, 0.5) != 0) {
+        fprintf(stderr, "TEST 1 FAILED: Empty stats are not zero!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 1 PASSED\n");
+
+    /*
+     * Latencies land in the power of two bucket above them
+     */
+    stats_record_latency(stats.get_latency, 0);
+    stats_record_latency(stats.get_latency, 1);
+    stats_record_latency(stats.get_latency, 100);
+    stats_record_latency(stats.get_latency, 127);
+    stats_record_latency(stats.get_latency, 128);
+    stats_record_latency(stats.get_latency, (u_int64_t)1 << 40);
+    if (stats.get_latency[0] != 1 || stats.get_latency[1] != 1 || stats.get_latency[7] != 2
+            || stats.get_latency[8] != 1 || stats.get_latency[STATS_LATENCY_BUCKETS - 1] != 1) {
+        fprintf(stderr, "TEST 2 FAILED: Latency recorded in the wrong bucket!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 2 PASSED\n");
+
+    /*
+     * Quantiles report the upper bound of their bucket
+     */
+    memset(stats.get_latency, 0, sizeof(stats.get_latency));
+    for (int i = 0; i < 990; i++)
+        stats_record_latency(stats.get_latency, 50);
+    for (int i = 0; i < 9; i++)
+        stats_record_latency(stats.get_latency, 5000);
+    stats_record_latency(stats.get_latency, 100000);
+    if (stats_latency_quantile(stats.get_latency, 0.5) != 64
+            || stats_latency_quantile(stats.get_latency, 0.99) != 8192
+            || stats_latency_quantile(stats.get_latency, 0.999) != 131072
+            || stats_latency_quantile(stats.get_latency, 1.0) != 131072) {
+        fprintf(stderr, "TEST 3 FAILED: Wrong latency quantile!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 3 PASSED\n");
+
+    /*
+     * Merging adds every counter and histogram bucket
+     */
+    CacheStats total;
+    memset(&total, 0, sizeof(total));
+    stats.hits = 3;
+    stats.misses = 1;
+    stats.evictions = 7;
+    stats.probe_lengths[STATS_PROBE_BUCKETS - 1] = 2;
+    stats_merge(&total, &stats);
+    stats_merge(&total, &stats);
+    if (total.hits != 6 || total.misses != 2 || total.evictions != 14
+            || total.probe_lengths[STATS_PROBE_BUCKETS - 1] != 4 || total.get_latency[6] != 1980
+            || stats_hit_ratio(&total) != 0.75) {
+        fprintf(stderr, "TEST 4 FAILED: Merge lost counters!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 4 PASSED\n");
+
+    /*
+     * Lookup stripes are summed into hits and misses,
+     * a thread keeps the stripe it was given
+     */
+    LookupStats *lookups = init_lookup_stats();
+    if (lookups == NULL)
+        exit(EXIT_FAILURE);
+    StatsStripe *stripe = lookup_stripe(lookups);
+    STATS_ADD(stripe->hits, 5);
+    STATS_ADD(lookup_stripe(lookups)->misses, 2);
+    lookups->stripes[STATS_STRIPES - 1].hits += 1;
+    memset(&total, 0, sizeof(total));
+    stats_merge_lookups(&total, lookups);
+    if (lookup_stripe(lookups) != stripe || total.hits != 6 || total.misses != 2) {
+        fprintf(stderr, "TEST 5 FAILED: Lookup stripes do not add up!\n");
+        exit(EXIT_FAILURE);
+    }
+    free_lookup_stats(lookups);
+    printf("TEST 5 PASSED\n");
+
+    printf("ALL TESTS PASSED!\n");
+#endif
+
+    return 0;
+}
@@ -0,0 +1,156 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "timer_wheel.h"
+
+#ifdef TESTS
+#define TIMER_COUNT 2000
+
+static Timer timers[TIMER_COUNT];
+static u_int64_t fired_at[TIMER_COUNT];
+static u_int64_t clock_now;
+
+static void record_expiry(Timer *timer, void *arg) {
+    size_t *fired = (size_t *)arg;
+    fired_at[timer - timers] = clock_now;
+    (*fired)++;
+}
+
+static unsigned long long rng_state = 7;
+
+static unsigned long long next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+#endif
+
+int main(void) {
+    u_int64_t clock_start = 1000;
+    TimerWheel *wheel = init_timer_wheel(clock_start);
+    if (wheel == NULL) {
+        printf("Failed to initialize timer wheel!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /*
+     * TESTS
+     */
+#ifdef TESTS
+    size_t fired = 0;
+    clock_now = clock_start;
+
+    /*
+     * Deadlines spread over several levels fire on their exact tick
+     */
+    for (size_t i = 0; i < TIMER_COUNT; i++) {
+        init_timer(&timers[i], NULL);
+        schedule_timer(wheel, &timers[i], clock_now + next_random() % 300000);
+    }
+    while (clock_now < 1000 + 300000) {
+        clock_now += 1 + next_random() % 50;
+        advance_timer_wheel(wheel, clock_now, (size_t)-1, record_expiry, &fired);
+        for (size_t i = 0; i < TIMER_COUNT; i++) {
+            if (timers[i].level == TIMER_IDLE && fired_at[i] == clock_now && timers[i].expires > clock_now) {
+                fprintf(stderr, "TEST 1 FAILED: Timer due at %llu fired at %llu!\n",
+                        (unsigned long long)timers[i].expires, (unsigned long long)clock_now);
+                exit(EXIT_FAILURE);
+            }
+            if (timers[i].level != TIMER_IDLE && timers[i].expires <= clock_now) {
+                fprintf(stderr, "TEST 1 FAILED: Timer due at %llu still pending at %llu!\n",
+                        (unsigned long long)timers[i].expires, (unsigned long long)clock_now);
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+    if (fired != TIMER_COUNT || wheel->count != 0) {
+        fprintf(stderr, "TEST 1 FAILED: Fired %zu of %d timers!\n", fired, TIMER_COUNT);
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 1 PASSED\n");
+
+    /*
+     * Cancelled timers never fire, rescheduled ones fire at the new deadline
+     */
+    fired = 0;
+    schedule_timer(wheel, &timers[0], clock_now + 100);
+    schedule_timer(wheel, &timers[1], clock_now + 100);
+    schedule_timer(wheel, &timers[2], clock_now + 100);
+    cancel_timer(wheel, &timers[1]);
+    schedule_timer(wheel, &timers[2], clock_now + 5000);
+    clock_now += 100;
+    advance_timer_wheel(wheel, clock_now, (size_t)-1, record_expiry, &fired);
+    if (fired != 1 || timers[0].level != TIMER_IDLE || timers[2].level == TIMER_IDLE || wheel->count != 1) {
+        fprintf(stderr, "TEST 2 FAILED: Cancel or reschedule ignored!\n");
+        exit(EXIT_FAILURE);
+    }
+    clock_now += 4900;
+    advance_timer_wheel(wheel, clock_now, (size_t)-1, record_expiry, &fired);
+    if (fired != 2 || wheel->count != 0) {
+        fprintf(stderr, "TEST 2 FAILED: Rescheduled timer did not fire!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 2 PASSED\n");
+
+    /*
+     * Idle stretches are skipped in a handful of steps
+     */
+    fired = 0;
+    schedule_timer(wheel, &timers[0], clock_now + 36000000);
+    clock_now += 36000000;
+    advance_timer_wheel(wheel, clock_now, 4 * TIMER_WHEEL_LEVELS, record_expiry, &fired);
+    if (fired != 1 || wheel->current != clock_now + 1) {
+        fprintf(stderr, "TEST 3 FAILED: Ten idle hours took too many steps!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 3 PASSED\n");
+
+    /*
+     * Advancing is bounded, the rest fires on later calls
+     */
+    fired = 0;
+    for (size_t i = 0; i < 100; i++)
+        schedule_timer(wheel, &timers[i], clock_now + 10);
+    clock_now += 10;
+    advance_timer_wheel(wheel, clock_now, 30, record_expiry, &fired);
+    if (fired > 30 || wheel->count != 100 - fired) {
+        fprintf(stderr, "TEST 4 FAILED: Fired %zu timers in 30 steps!\n", fired);
+        exit(EXIT_FAILURE);
+    }
+    while (wheel->count > 0)
+        advance_timer_wheel(wheel, clock_now, 30, record_expiry, &fired);
+    if (fired != 100) {
+        fprintf(stderr, "TEST 4 FAILED: Fired %zu of 100 timers!\n", fired);
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 4 PASSED\n");
+
+    /*
+     * Deadlines past the wheel's range wait in the top level
+     */
+    fired = 0;
+    u_int64_t far = (u_int64_t)1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS + 2);
+    schedule_timer(wheel, &timers[0], clock_now + far);
+    clock_now += far - 1;
+    advance_timer_wheel(wheel, clock_now, (size_t)-1, record_expiry, &fired);
+    if (fired != 0) {
+        fprintf(stderr, "TEST 5 FAILED: Far timer fired early!\n");
+        exit(EXIT_FAILURE);
+    }
+    clock_now += 1;
+    advance_timer_wheel(wheel, clock_now, (size_t)-1, record_expiry, &fired);
+    if (fired != 1) {
+        fprintf(stderr, "TEST 5 FAILED: Far timer did not fire!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 5 PASSED\n");
+
+    printf("ALL TESTS PASSED!\n");
+#endif
+
+    free_timer_wheel(wheel);
+
+    return 0;
+}
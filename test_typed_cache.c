@@ -0,0 +1,169 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "typed_cache.h"
+
+TYPED_CACHE_INIT(ids, u_int64_t, u_int64_t, typed_hash_u64, typed_equal)
+
+#ifdef TESTS
+typedef struct Point {
+    int x;
+    int y;
+} Point;
+
+static inline u_int32_t point_hash(Point point) {
+    return typed_hash_u64((u_int64_t)(u_int32_t)point.x << 32 | (u_int32_t)point.y);
+}
+
+#define point_equal(a, b) ((a).x == (b).x && (a).y == (b).y)
+
+TYPED_CACHE_INIT(points, Point, const char *, point_hash, point_equal)
+
+#define REFERENCE_CAPACITY 64
+
+/*
+ * Reference LRU cache, most recent first
+ */
+static u_int64_t reference_keys[REFERENCE_CAPACITY];
+static u_int64_t reference_values[REFERENCE_CAPACITY];
+static size_t reference_count;
+
+static int reference_find(u_int64_t key) {
+    for (size_t i = 0; i < reference_count; i++) {
+        if (reference_keys[i] == key)
+            return (int)i;
+    }
+    return FAILURE;
+}
+
+static void reference_erase(size_t index) {
+    memmove(&reference_keys[index], &reference_keys[index + 1], (reference_count - index - 1) * sizeof(u_int64_t));
+    memmove(&reference_values[index], &reference_values[index + 1], (reference_count - index - 1) * sizeof(u_int64_t));
+    reference_count--;
+}
+
+static void reference_push(u_int64_t key, u_int64_t value) {
+    if (reference_count == REFERENCE_CAPACITY)
+        reference_count--;
+    memmove(&reference_keys[1], &reference_keys[0], reference_count * sizeof(u_int64_t));
+    memmove(&reference_values[1], &reference_values[0], reference_count * sizeof(u_int64_t));
+    reference_keys[0] = key;
+    reference_values[0] = value;
+    reference_count++;
+}
+
+static unsigned long long rng_state = 13;
+
+static unsigned long long next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+#endif
+
+int main(void) {
+    ids_cache_t *cache = ids_init(3);
+    if (cache == NULL) {
+        printf("Failed to initialize typed cache!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /*
+     * TESTS
+     */
+#ifdef TESTS
+    u_int64_t value = 0;
+    ids_put(cache, 1, 10);
+    ids_put(cache, 2, 20);
+    ids_put(cache, 3, 30);
+    ids_put(cache, 2, 21);
+    if (ids_get(cache, 2, &value) != SUCCESS || value != 21 || ids_peek(cache, 4, &value) != FAILURE
+            || cache->count != 3) {
+        fprintf(stderr, "TEST 1 FAILED: Lookup returned wrong result!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 1 PASSED\n");
+
+    /*
+     * Least recently used goes first, peeking does not count as use
+     */
+    ids_get(cache, 1, NULL);
+    ids_peek(cache, 3, NULL);
+    ids_put(cache, 4, 40);
+    if (ids_peek(cache, 3, NULL) != FAILURE || ids_peek(cache, 1, NULL) != SUCCESS
+            || ids_remove(cache, 2) != SUCCESS || ids_remove(cache, 2) != FAILURE || cache->count != 2) {
+        fprintf(stderr, "TEST 2 FAILED: Wrong entry was evicted!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 2 PASSED\n");
+
+    /*
+     * Random gets, puts and removes agree with a naive LRU cache
+     */
+    ids_free(cache);
+    cache = ids_init(REFERENCE_CAPACITY);
+    for (int i = 0; i < 200000; i++) {
+        u_int64_t key = next_random() % 200;
+        int op = (int)(next_random() % 10);
+        int index = reference_find(key);
+        if (op < 5) {
+            int result = ids_get(cache, key, &value);
+            if ((result == SUCCESS) != (index >= 0) || (index >= 0 && value != reference_values[index])) {
+                fprintf(stderr, "TEST 3 FAILED: Get of %llu disagrees!\n", (unsigned long long)key);
+                exit(EXIT_FAILURE);
+            }
+            if (index >= 0) {
+                u_int64_t found = reference_values[index];
+                reference_erase((size_t)index);
+                reference_push(key, found);
+            }
+        } else if (op < 9) {
+            ids_put(cache, key, (u_int64_t)i);
+            if (index >= 0)
+                reference_erase((size_t)index);
+            reference_push(key, (u_int64_t)i);
+        } else {
+            if ((ids_remove(cache, key) == SUCCESS) != (index >= 0)) {
+                fprintf(stderr, "TEST 3 FAILED: Remove of %llu disagrees!\n", (unsigned long long)key);
+                exit(EXIT_FAILURE);
+            }
+            if (index >= 0)
+                reference_erase((size_t)index);
+        }
+        if (cache->count != reference_count) {
+            fprintf(stderr, "TEST 3 FAILED: %zu entries, expected %zu!\n", cache->count, reference_count);
+            exit(EXIT_FAILURE);
+        }
+    }
+    printf("TEST 3 PASSED\n");
+
+    /*
+     * Struct keys with their own hash and equality
+     */
+    points_cache_t *points = points_init(2);
+    if (points == NULL)
+        exit(EXIT_FAILURE);
+    const char *name = NULL;
+    points_put(points, (Point){ 1, 2 }, "a");
+    points_put(points, (Point){ 2, 1 }, "b");
+    points_put(points, (Point){ 1, 2 }, "c");
+    points_put(points, (Point){ 3, 3 }, "d");
+    if (points_get(points, (Point){ 1, 2 }, &name) != SUCCESS || strcmp(name, "c") != 0
+            || points_get(points, (Point){ 2, 1 }, &name) != FAILURE) {
+        fprintf(stderr, "TEST 4 FAILED: Struct keys mixed up!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 4 PASSED\n");
+
+    points_free(points);
+
+    printf("ALL TESTS PASSED!\n");
+#endif
+
+    ids_free(cache);
+
+    return 0;
+}
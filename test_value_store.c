@@ -0,0 +1,137 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "value_store.h"
+
+#define SEGMENT 4096
+#define VALUES 100
+
+/*
+ * Owners are slots of "refs", eviction releases the value and clears it
+ */
+static ValueRef refs[VALUES];
+static int evicted;
+
+static void evict_slot(void *owner, void *arg) {
+    ValueStore *store = *(ValueStore **)arg;
+    ValueRef *ref = (ValueRef *)owner;
+    release_value(store, *ref);
+    ref->segment = 0;
+    evicted++;
+}
+
+int main(void) {
+    static ValueStore *store;
+    store = init_value_store(SEGMENT, 4, NULL, evict_slot, &store);
+    if (store == NULL) {
+        printf("Failed to initialize value store!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /*
+     * TESTS
+     */
+#ifdef TESTS
+    char value[SEGMENT];
+    for (int i = 0; i < VALUES; i++) {
+        memset(value, 'a' + i % 26, 200);
+        if (store_value(store, value, 200, &refs[i], &refs[i]) != SUCCESS) {
+            fprintf(stderr, "TEST 1 FAILED: Could not store value %d!\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (evicted == 0 || store->live_bytes > 4 * SEGMENT) {
+        fprintf(stderr, "TEST 1 FAILED: Full store did not reclaim segments!\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < VALUES; i++) {
+        const char *stored = refs[i].segment ? (const char *)value_at(store, refs[i]) : NULL;
+        if ((i < evicted) != (stored == NULL) || (stored && (stored[0] != 'a' + i % 26 || stored[199] != stored[0]))) {
+            fprintf(stderr, "TEST 1 FAILED: Value %d is wrong or was evicted out of order!\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+    printf("TEST 1 PASSED\n");
+
+    /*
+     * Reading a value keeps its segment, the least recently used one goes.
+     * Releasing every value of a sealed segment frees it without evictions
+     */
+    int oldest = evicted;
+    touch_value(store, refs[oldest]);
+    int before = evicted;
+    for (int i = 0; i < 19; i++) {
+        ValueRef ref;
+        if (store_value(store, value, 200, NULL, &ref) != SUCCESS)
+            exit(EXIT_FAILURE);
+        release_value(store, ref);
+    }
+    if (evicted == before || refs[oldest].segment == 0 || refs[oldest + 18].segment != 0) {
+        fprintf(stderr, "TEST 2 FAILED: Reclaimed segment was not the least recently used!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    u_int32_t segment = refs[VALUES - 1].segment;
+    for (int i = 0; i < VALUES; i++) {
+        if (refs[i].segment == segment) {
+            release_value(store, refs[i]);
+            release_value(store, refs[i]);
+            refs[i].segment = 0;
+        }
+    }
+    if (store->segments[segment - 1].state != VALUE_SEGMENT_FREE || store->free_list != segment) {
+        fprintf(stderr, "TEST 2 FAILED: Emptied segment was not freed!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 2 PASSED\n");
+
+    /*
+     * Values larger than a segment are refused,
+     * owners are recognized by address
+     */
+    ValueRef ref;
+    if (store_value(store, value, SEGMENT, NULL, &ref) != FAILURE || value_store_owns(store, value)
+            || store_value(store, "x", 1, NULL, &ref) != SUCCESS || !value_store_owns(store, value_at(store, ref))) {
+        fprintf(stderr, "TEST 3 FAILED: Oversized or foreign values handled wrong!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 3 PASSED\n");
+    free_value_store(store);
+
+    /*
+     * File-backed store: the file is gone once mapped, values still work
+     */
+    char path[] = "/tmp/test_value_store.XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0)
+        exit(EXIT_FAILURE);
+    close(fd);
+    memset(refs, 0, sizeof(refs));
+    evicted = 0;
+    store = init_value_store(SEGMENT, 4, path, evict_slot, &store);
+    if (!store || !store->file_backed || access(path, F_OK) == 0) {
+        fprintf(stderr, "TEST 4 FAILED: File-backed store not created or file left behind!\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < VALUES; i++) {
+        memset(value, 'a' + i % 26, 100);
+        if (store_value(store, value, 100, &refs[i], &refs[i]) != SUCCESS)
+            exit(EXIT_FAILURE);
+    }
+    const char *last = (const char *)value_at(store, refs[VALUES - 1]);
+    if (last[0] != 'a' + (VALUES - 1) % 26 || last[99] != last[0]) {
+        fprintf(stderr, "TEST 4 FAILED: File-backed value is wrong!\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("TEST 4 PASSED\n");
+
+    printf("ALL TESTS PASSED!\n");
+#endif // TESTS
+
+    free_value_store(store);
+
+    return 0;
+}
@@ -0,0 +1,192 @@
+/*
+ * timer_wheel.c
+ * Hierarchical timing wheel with cascading levels
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "timer_wheel.h"
+
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+#define MAX_DELTA (((u_int64_t)1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1)
+
+TimerWheel *init_timer_wheel(u_int64_t now) {
+    TimerWheel *wheel = (TimerWheel *)calloc(1, sizeof(TimerWheel));
+    if (!wheel) {
+        fprintf(stderr, "Could not allocate memory for timer wheel!\n");
+        return NULL;
+    }
+
+    wheel->current = now;
+
+    return wheel;
+}
+
+void init_timer(Timer *timer, void *owner) {
+    timer->node.data = owner;
+    timer->node.prev = NULL;
+    timer->node.next = NULL;
+    timer->expires = 0;
+    timer->level = TIMER_IDLE;
+    timer->slot = 0;
+}
+
+/*
+ * Put timer into the slot its deadline falls in, relative to the current tick.
+ * Level "l" is the lowest one whose span still reaches the deadline,
+ * so the timer is cascaded down once per level on its way to firing
+ */
+static void place_timer(TimerWheel *wheel, Timer *timer) {
+    u_int64_t expires = timer->expires > wheel->current ? timer->expires : wheel->current;
+    u_int64_t delta = expires - wheel->current;
+    if (delta > MAX_DELTA)
+        expires = wheel->current + MAX_DELTA;
+
+    unsigned int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 && (delta >> (TIMER_WHEEL_BITS * (level + 1))))
+        level++;
+
+    unsigned int slot = (expires >> (TIMER_WHEEL_BITS * level)) & SLOT_MASK;
+    link_at_front(&wheel->slots[level][slot], &timer->node);
+    wheel->occupied[level] |= (u_int64_t)1 << slot;
+    timer->level = (unsigned char)level;
+    timer->slot = (unsigned char)slot;
+}
+
+static void unlink_timer(TimerWheel *wheel, Timer *timer) {
+    DLL *slot = &wheel->slots[timer->level][timer->slot];
+    unlink_node(slot, &timer->node);
+    if (slot->list_size == 0)
+        wheel->occupied[timer->level] &= ~((u_int64_t)1 << timer->slot);
+
+    timer->level = TIMER_IDLE;
+    wheel->count--;
+}
+
+int schedule_timer(TimerWheel *wheel, Timer *timer, u_int64_t expires) {
+    if (!wheel || !timer) {
+        fprintf(stderr, "Timer wheel or timer is not valid or is null!\n");
+        return IS_NULL;
+    }
+
+    if (timer->level != TIMER_IDLE)
+        unlink_timer(wheel, timer);
+
+    timer->expires = expires;
+    place_timer(wheel, timer);
+    wheel->count++;
+
+    return SUCCESS;
+}
+
+int cancel_timer(TimerWheel *wheel, Timer *timer) {
+    if (!wheel || !timer) {
+        fprintf(stderr, "Timer wheel or timer is not valid or is null!\n");
+        return IS_NULL;
+    }
+
+    if (timer->level != TIMER_IDLE)
+        unlink_timer(wheel, timer);
+
+    return SUCCESS;
+}
+
+/*
+ * Move every timer of a higher level slot closer to firing
+ */
+static void cascade(TimerWheel *wheel, unsigned int level, unsigned int slot) {
+    DLL pending = wheel->slots[level][slot];
+    memset(&wheel->slots[level][slot], 0, sizeof(DLL));
+    wheel->occupied[level] &= ~((u_int64_t)1 << slot);
+
+    Node *node = pending.head;
+    while (node) {
+        Node *next = node->next;
+        place_timer(wheel, (Timer *)node);
+        node = next;
+    }
+}
+
+/*
+ * Jump to "tick", cascading every level whose slot boundary it lands on
+ */
+static void move_to(TimerWheel *wheel, u_int64_t tick) {
+    wheel->current = tick;
+    for (unsigned int level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+        unsigned int shift = TIMER_WHEEL_BITS * level;
+        if (tick & (((u_int64_t)1 << shift) - 1))
+            break;
+        cascade(wheel, level, (tick >> shift) & SLOT_MASK);
+    }
+}
+
+/*
+ * First tick after the current one with timers to fire or cascade.
+ * Levels below the first non-empty one hold nothing, so it alone decides:
+ * its next occupied slot ahead, or the end of its rotation when the
+ * only occupied slots come around after it
+ */
+static u_int64_t next_event(const TimerWheel *wheel) {
+    u_int64_t tick = wheel->current;
+    for (unsigned int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        unsigned int shift = TIMER_WHEEL_BITS * level;
+        unsigned int index = (tick >> shift) & SLOT_MASK;
+        u_int64_t rotation = (tick >> (shift + TIMER_WHEEL_BITS)) << (shift + TIMER_WHEEL_BITS);
+        u_int64_t ahead = 0;
+        if (level == 0)
+            ahead = wheel->occupied[0] & (~(u_int64_t)0 << index);
+        else if (index < SLOT_MASK)
+            ahead = wheel->occupied[level] & (~(u_int64_t)0 << (index + 1));
+
+        if (ahead)
+            return rotation + ((u_int64_t)__builtin_ctzll(ahead) << shift);
+        if (wheel->occupied[level])
+            return rotation + ((u_int64_t)1 << (shift + TIMER_WHEEL_BITS));
+    }
+
+    return tick + 1;
+}
+
+size_t advance_timer_wheel(TimerWheel *wheel, u_int64_t now, size_t max_steps,
+                           void (*expire)(Timer *timer, void *arg), void *arg) {
+    if (!wheel || !expire) {
+        fprintf(stderr, "Timer wheel or expire callback is not valid or is null!\n");
+        return 0;
+    }
+
+    size_t fired = 0;
+    for (size_t step = 0; step < max_steps && wheel->current <= now; step++) {
+        if (wheel->count == 0) {
+            wheel->current = now + 1;
+            break;
+        }
+
+        DLL *slot = &wheel->slots[0][wheel->current & SLOT_MASK];
+        if (slot->tail) {
+            Timer *timer = (Timer *)slot->tail;
+            unlink_timer(wheel, timer);
+            expire(timer, arg);
+            fired++;
+            continue;
+        }
+
+        u_int64_t next = next_event(wheel);
+        move_to(wheel, next <= now ? next : now + 1);
+    }
+
+    return fired;
+}
+
+void free_timer_wheel(TimerWheel *wheel) {
+    if (!wheel) {
+        fprintf(stderr, "Timer wheel is not valid or is null!\n");
+        return;
+    }
+
+    /*
+     * Timers are owned by the caller, only the wheel itself is freed
+     */
+    free(wheel);
+}
@@ -0,0 +1,80 @@
+#ifndef _TIMER_WHEEL_H_
+#define _TIMER_WHEEL_H_
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "dll.h"
+
+/*
+ * Levels of the wheel and slots per level (2^TIMER_WHEEL_BITS).
+ * Level "l" slots span 64^l ticks, so five levels cover 64^5 ticks,
+ * about 12 days of milliseconds. Later deadlines wait in the top level
+ * and are placed again every time it comes around
+ */
+#define TIMER_WHEEL_LEVELS 5
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+
+/*
+ * Level of a timer that is not scheduled
+ */
+#define TIMER_IDLE 0xFF
+
+/*
+ * Intrusive timer
+ * node must stay the first member, node.data points to the owner
+ */
+typedef struct Timer {
+    Node node;
+    u_int64_t expires;
+    unsigned char level;
+    unsigned char slot;
+} Timer;
+
+/*
+ * Hierarchical timing wheel
+ * "current" is the next tick to process. A bitmap per level marks
+ * the non-empty slots, so idle stretches are skipped in one step
+ * instead of tick by tick
+ */
+typedef struct TimerWheel {
+    u_int64_t current;
+    size_t count;
+    u_int64_t occupied[TIMER_WHEEL_LEVELS];
+    DLL slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+} TimerWheel;
+
+/*
+ * Initialize empty wheel starting at tick "now"
+ */
+TimerWheel *init_timer_wheel(u_int64_t now);
+
+/*
+ * Prepare unscheduled "timer" belonging to "owner"
+ */
+void init_timer(Timer *timer, void *owner);
+
+/*
+ * Schedule "timer" to fire at tick "expires", rescheduling it if
+ * it is already on the wheel. Past deadlines fire on the next advance
+ */
+int schedule_timer(TimerWheel *wheel, Timer *timer, u_int64_t expires);
+
+/*
+ * Take "timer" off the wheel, no-op if it is not scheduled
+ */
+int cancel_timer(TimerWheel *wheel, Timer *timer);
+
+/*
+ * Process ticks up to and including "now", at most "max_steps" steps.
+ * A step fires one timer or jumps to the next tick with work to do.
+ * Fired timers are off the wheel when "expire" is called, so it may
+ * free or reschedule them. Returns the number of timers fired
+ */
+size_t advance_timer_wheel(TimerWheel *wheel, u_int64_t now, size_t max_steps,
+                           void (*expire)(Timer *timer, void *arg), void *arg);
+
+void free_timer_wheel(TimerWheel *wheel);
+
+#endif // _TIMER_WHEEL_H_
@@ -0,0 +1,278 @@
+#ifndef _TYPED_CACHE_H_
+#define _TYPED_CACHE_H_
+
+/*
+ * typed_cache.h
+ * Header-only LRU cache specialized per key and value type, in the
+ * style of klib's khash. TYPED_CACHE_INIT generates a cache whose
+ * entries hold the key and value themselves, so the hash and equality
+ * functions inline and a hit reads one index slot and one entry.
+ *
+ *     TYPED_CACHE_INIT(ids, u_int64_t, double, typed_hash_u64, typed_equal)
+ *
+ *     ids_cache_t *cache = ids_init(1000);
+ *     ids_put(cache, 42, 1.5);
+ *     double value;
+ *     if (ids_get(cache, 42, &value) == SUCCESS) ...
+ *     ids_free(cache);
+ *
+ * Generated for "name":
+ *   name_cache_t                         the cache
+ *   name_init(capacity)                  NULL on failure
+ *   name_get(cache, key, &value)         SUCCESS and most recently used, or FAILURE
+ *   name_peek(cache, key, &value)        same, recency untouched
+ *   name_put(cache, key, value)          insert or update, evicting the
+ *                                        least recently used entry when full
+ *   name_remove(cache, key)              SUCCESS, or FAILURE if not cached
+ *   name_free(cache)
+ * "value" out parameters may be NULL. Keys and values are copied by
+ * assignment: a pointer key stays the caller's to keep alive.
+ *
+ * Layout: entries live in one array of "capacity", linked into the LRU
+ * list by 32 bit indices. The index is a linear probing table of
+ * (hash, entry) pairs at most half full, probed on the stored hash
+ * before any entry is touched, with backward shift deletion instead
+ * of tombstones. Nothing is allocated after init
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+#define SUCCESS 0
+#define FAILURE -1
+#define IS_NULL -2
+
+#define TYPED_CACHE_NIL 0xFFFFFFFFu
+
+/*
+ * Hashes and equality for the common key types
+ */
+static inline u_int32_t typed_hash_u64(u_int64_t key) {
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDull;
+    key ^= key >> 33;
+    key *= 0xC4CEB9FE1A85EC53ull;
+    key ^= key >> 33;
+    return (u_int32_t)key;
+}
+
+static inline u_int32_t typed_hash_u32(u_int32_t key) {
+    key ^= key >> 16;
+    key *= 0x85EBCA6Bu;
+    key ^= key >> 13;
+    key *= 0xC2B2AE35u;
+    key ^= key >> 16;
+    return key;
+}
+
+#define typed_equal(a, b) ((a) == (b))
+
+#define TYPED_CACHE_INIT(name, key_t, value_t, hash_fn, equal_fn)                                 \
+    typedef struct name##_entry {                                                                 \
+        key_t key;                                                                                \
+        value_t value;                                                                            \
+        u_int32_t prev;                                                                           \
+        u_int32_t next;                                                                           \
+    } name##_entry_t;                                                                             \
+                                                                                                  \
+    /*                                                                                            \
+     * entry is the entry's index + 1, 0 marks an empty slot                                     \
+     */                                                                                           \
+    typedef struct name##_slot {                                                                  \
+        u_int32_t hash;                                                                           \
+        u_int32_t entry;                                                                          \
+    } name##_slot_t;                                                                              \
+                                                                                                  \
+    typedef struct name##_cache {                                                                 \
+        size_t capacity;                                                                          \
+        size_t count;                                                                             \
+        size_t mask;                                                                              \
+        u_int32_t head;                                                                           \
+        u_int32_t tail;                                                                           \
+        u_int32_t free_list;                                                                      \
+        name##_slot_t *slots;                                                                     \
+        name##_entry_t *entries;                                                                  \
+    } name##_cache_t;                                                                             \
+                                                                                                  \
+    static inline name##_cache_t *name##_init(size_t capacity) {                                  \
+        if (capacity == 0 || capacity >= TYPED_CACHE_NIL / 2) {                                   \
+            fprintf(stderr, "Typed cache capacity is out of range!\n");                          \
+            return NULL;                                                                          \
+        }                                                                                         \
+                                                                                                  \
+        name##_cache_t *cache = (name##_cache_t *)calloc(1, sizeof(name##_cache_t));              \
+        if (!cache) {                                                                             \
+            fprintf(stderr, "Could not allocate memory for typed cache!\n");                     \
+            return NULL;                                                                          \
+        }                                                                                         \
+                                                                                                  \
+        size_t slots = 16;                                                                        \
+        while (slots < 2 * capacity)                                                              \
+            slots <<= 1;                                                                          \
+        cache->capacity = capacity;                                                               \
+        cache->mask = slots - 1;                                                                  \
+        cache->head = cache->tail = TYPED_CACHE_NIL;                                              \
+        cache->slots = (name##_slot_t *)calloc(slots, sizeof(name##_slot_t));                     \
+        cache->entries = (name##_entry_t *)malloc(capacity * sizeof(name##_entry_t));             \
+        if (!cache->slots || !cache->entries) {                                                   \
+            fprintf(stderr, "Could not allocate memory for typed cache entries!\n");             \
+            free(cache->slots);                                                                   \
+            free(cache->entries);                                                                 \
+            free(cache);                                                                          \
+            return NULL;                                                                          \
+        }                                                                                         \
+                                                                                                  \
+        /*                                                                                        \
+         * Every entry starts on the free list                                                    \
+         */                                                                                       \
+        for (size_t i = 0; i < capacity; i++)                                                     \
+            cache->entries[i].next = i + 1 < capacity ? (u_int32_t)(i + 1) : TYPED_CACHE_NIL;     \
+        cache->free_list = 0;                                                                     \
+                                                                                                  \
+        return cache;                                                                             \
+    }                                                                                             \
+                                                                                                  \
+    static inline void name##_free(name##_cache_t *cache) {                                       \
+        if (!cache) {                                                                             \
+            fprintf(stderr, "Typed cache is not valid or is null!\n");                           \
+            return;                                                                               \
+        }                                                                                         \
+                                                                                                  \
+        free(cache->slots);                                                                       \
+        free(cache->entries);                                                                     \
+        free(cache);                                                                              \
+    }                                                                                             \
+                                                                                                  \
+    /*                                                                                            \
+     * Slot holding "key", or the empty slot ending its probe sequence                            \
+     */                                                                                           \
+    static inline size_t name##_find_slot(const name##_cache_t *cache, key_t key, u_int32_t hash) { \
+        size_t slot = hash & cache->mask;                                                         \
+        for (;;) {                                                                                \
+            const name##_slot_t *current = &cache->slots[slot];                                   \
+            if (current->entry == 0)                                                              \
+                return slot;                                                                      \
+            if (current->hash == hash && equal_fn(cache->entries[current->entry - 1].key, key))   \
+                return slot;                                                                      \
+            slot = (slot + 1) & cache->mask;                                                      \
+        }                                                                                         \
+    }                                                                                             \
+                                                                                                  \
+    /*                                                                                            \
+     * Empty "slot", shifting back later slots of its cluster                                     \
+     */                                                                                           \
+    static inline void name##_delete_slot(name##_cache_t *cache, size_t slot) {                   \
+        size_t next = slot;                                                                       \
+        for (;;) {                                                                                \
+            next = (next + 1) & cache->mask;                                                      \
+            if (cache->slots[next].entry == 0)                                                    \
+                break;                                                                            \
+                                                                                                  \
+            size_t home = cache->slots[next].hash & cache->mask;                                  \
+            if (((next - home) & cache->mask) >= ((next - slot) & cache->mask)) {                 \
+                cache->slots[slot] = cache->slots[next];                                          \
+                slot = next;                                                                      \
+            }                                                                                     \
+        }                                                                                         \
+                                                                                                  \
+        cache->slots[slot].entry = 0;                                                             \
+    }                                                                                             \
+                                                                                                  \
+    static inline void name##_unlink(name##_cache_t *cache, u_int32_t index) {                    \
+        name##_entry_t *entry = &cache->entries[index];                                           \
+        if (entry->prev != TYPED_CACHE_NIL)                                                       \
+            cache->entries[entry->prev].next = entry->next;                                       \
+        else                                                                                      \
+            cache->head = entry->next;                                                            \
+        if (entry->next != TYPED_CACHE_NIL)                                                       \
+            cache->entries[entry->next].prev = entry->prev;                                       \
+        else                                                                                      \
+            cache->tail = entry->prev;                                                            \
+    }                                                                                             \
+                                                                                                  \
+    static inline void name##_push_front(name##_cache_t *cache, u_int32_t index) {                \
+        name##_entry_t *entry = &cache->entries[index];                                           \
+        entry->prev = TYPED_CACHE_NIL;                                                            \
+        entry->next = cache->head;                                                                \
+        if (cache->head != TYPED_CACHE_NIL)                                                       \
+            cache->entries[cache->head].prev = index;                                             \
+        else                                                                                      \
+            cache->tail = index;                                                                  \
+        cache->head = index;                                                                      \
+    }                                                                                             \
+                                                                                                  \
+    static inline int name##_peek(const name##_cache_t *cache, key_t key, value_t *value) {       \
+        size_t slot = name##_find_slot(cache, key, hash_fn(key));                                 \
+        if (cache->slots[slot].entry == 0)                                                        \
+            return FAILURE;                                                                       \
+                                                                                                  \
+        if (value)                                                                                \
+            *value = cache->entries[cache->slots[slot].entry - 1].value;                          \
+        return SUCCESS;                                                                           \
+    }                                                                                             \
+                                                                                                  \
+    static inline int name##_get(name##_cache_t *cache, key_t key, value_t *value) {              \
+        size_t slot = name##_find_slot(cache, key, hash_fn(key));                                 \
+        if (cache->slots[slot].entry == 0)                                                        \
+            return FAILURE;                                                                       \
+                                                                                                  \
+        u_int32_t index = cache->slots[slot].entry - 1;                                           \
+        if (cache->head != index) {                                                               \
+            name##_unlink(cache, index);                                                          \
+            name##_push_front(cache, index);                                                      \
+        }                                                                                         \
+        if (value)                                                                                \
+            *value = cache->entries[index].value;                                                 \
+        return SUCCESS;                                                                           \
+    }                                                                                             \
+                                                                                                  \
+    static inline int name##_remove(name##_cache_t *cache, key_t key) {                           \
+        size_t slot = name##_find_slot(cache, key, hash_fn(key));                                 \
+        if (cache->slots[slot].entry == 0)                                                        \
+            return FAILURE;                                                                       \
+                                                                                                  \
+        u_int32_t index = cache->slots[slot].entry - 1;                                           \
+        name##_delete_slot(cache, slot);                                                          \
+        name##_unlink(cache, index);                                                              \
+        cache->entries[index].next = cache->free_list;                                            \
+        cache->free_list = index;                                                                 \
+        cache->count--;                                                                           \
+        return SUCCESS;                                                                           \
+    }                                                                                             \
+                                                                                                  \
+    static inline int name##_put(name##_cache_t *cache, key_t key, value_t value) {               \
+        u_int32_t hash = hash_fn(key);                                                            \
+        size_t slot = name##_find_slot(cache, key, hash);                                         \
+        if (cache->slots[slot].entry != 0) {                                                      \
+            u_int32_t index = cache->slots[slot].entry - 1;                                       \
+            cache->entries[index].value = value;                                                  \
+            if (cache->head != index) {                                                           \
+                name##_unlink(cache, index);                                                      \
+                name##_push_front(cache, index);                                                  \
+            }                                                                                     \
+            return SUCCESS;                                                                       \
+        }                                                                                         \
+                                                                                                  \
+        /*                                                                                        \
+         * Full: the tail entry makes room, its slot deletion may                                 \
+         * shift the empty slot found for the new key                                             \
+         */                                                                                       \
+        if (cache->count == cache->capacity) {                                                    \
+            name##_remove(cache, cache->entries[cache->tail].key);                                \
+            slot = name##_find_slot(cache, key, hash);                                            \
+        }                                                                                         \
+                                                                                                  \
+        u_int32_t index = cache->free_list;                                                       \
+        cache->free_list = cache->entries[index].next;                                            \
+        cache->entries[index].key = key;                                                          \
+        cache->entries[index].value = value;                                                      \
+        name##_push_front(cache, index);                                                          \
+        cache->slots[slot].hash = hash;                                                           \
+        cache->slots[slot].entry = index + 1;                                                     \
+        cache->count++;                                                                           \
+        return SUCCESS;                                                                           \
+    }
+
+#endif // _TYPED_CACHE_H_
@@ -0,0 +1,240 @@
+/*
+ * value_store.c
+ * Log-structured value segments in one memory or file mapping
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "value_store.h"
+
+#define PAGE_SIZE 4096
+
+/*
+ * Header in front of every value, records are 8 byte aligned.
+ * "live" is cleared when the value is released
+ */
+typedef struct ValueRecord {
+    void *owner;
+    u_int32_t len;
+    u_int32_t live;
+} ValueRecord;
+
+static inline size_t record_size(size_t len) {
+    return sizeof(ValueRecord) + ((len + 7) & ~(size_t)7);
+}
+
+static inline ValueRecord *record_at(const ValueStore *store, u_int32_t segment, size_t offset) {
+    return (ValueRecord *)(store->base + (size_t)(segment - 1) * store->segment_size + offset);
+}
+
+static void free_segment(ValueStore *store, u_int32_t index) {
+    ValueSegment *segment = &store->segments[index - 1];
+    segment->state = VALUE_SEGMENT_FREE;
+    segment->used = 0;
+    segment->live = 0;
+    segment->next_free = store->free_list;
+    store->free_list = index;
+}
+
+ValueStore *init_value_store(size_t segment_size, size_t segment_count, const char *path, ValueEvictor evict,
+                             void *evict_arg) {
+    if (segment_size == 0)
+        segment_size = VALUE_SEGMENT_SIZE;
+    segment_size = (segment_size + PAGE_SIZE - 1) & ~(size_t)(PAGE_SIZE - 1);
+    if (segment_size > UINT32_MAX || segment_count < 2 || segment_count >= UINT32_MAX
+            || segment_count > SIZE_MAX / segment_size || !evict) {
+        fprintf(stderr, "Value store segments are out of range or evictor is null!\n");
+        return NULL;
+    }
+
+    ValueStore *store = (ValueStore *)calloc(1, sizeof(ValueStore));
+    if (!store) {
+        fprintf(stderr, "Could not allocate memory for value store!\n");
+        return NULL;
+    }
+    store->segment_size = segment_size;
+    store->segment_count = segment_count;
+    store->map_size = segment_size * segment_count;
+    store->evict = evict;
+    store->evict_arg = evict_arg;
+
+    store->segments = (ValueSegment *)calloc(segment_count, sizeof(ValueSegment));
+    if (!store->segments) {
+        fprintf(stderr, "Could not allocate memory for value segments!\n");
+        free(store);
+        return NULL;
+    }
+
+    /*
+     * Reserved, not committed: pages are backed as values land on them
+     */
+    void *map = MAP_FAILED;
+    if (path) {
+        int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (fd >= 0 && ftruncate(fd, (off_t)store->map_size) == 0)
+            map = mmap(NULL, store->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (fd >= 0) {
+            close(fd);
+            unlink(path);
+        }
+        store->file_backed = true;
+    } else {
+        map = mmap(NULL, store->map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    }
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "Could not map %zu bytes of value segments%s%s!\n", store->map_size, path ? " in " : "",
+                path ? path : "");
+        free(store->segments);
+        free(store);
+        return NULL;
+    }
+    store->base = (char *)map;
+
+    /*
+     * Lowest segments are taken first
+     */
+    for (size_t i = segment_count; i > 0; i--)
+        free_segment(store, (u_int32_t)i);
+
+    return store;
+}
+
+/*
+ * Empty the least recently used sealed segment,
+ * evicting the values still live in it
+ */
+static int reclaim_segment(ValueStore *store) {
+    u_int32_t victim = 0;
+    for (size_t i = 0; i < store->segment_count; i++) {
+        ValueSegment *segment = &store->segments[i];
+        if (segment->state == VALUE_SEGMENT_SEALED
+                && (victim == 0 || segment->stamp < store->segments[victim - 1].stamp))
+            victim = (u_int32_t)(i + 1);
+    }
+    if (victim == 0) {
+        fprintf(stderr, "Value store: No sealed segment to reclaim!\n");
+        return FAILURE;
+    }
+
+    ValueSegment *segment = &store->segments[victim - 1];
+    segment->state = VALUE_SEGMENT_RECLAIMING;
+    for (size_t offset = 0; offset < segment->used;) {
+        ValueRecord *record = record_at(store, victim, offset);
+        if (record->live && record->owner)
+            store->evict(record->owner, store->evict_arg);
+
+        /*
+         * An owner that could not be evicted loses its value anyway
+         */
+        if (record->live)
+            release_value(store, (ValueRef){ victim, (u_int32_t)(offset + sizeof(ValueRecord)) });
+        offset += record_size(record->len);
+    }
+    free_segment(store, victim);
+
+    return SUCCESS;
+}
+
+/*
+ * Seal the active segment and open a free one, reclaiming if there is none
+ */
+static int open_segment(ValueStore *store) {
+    if (store->active) {
+        ValueSegment *active = &store->segments[store->active - 1];
+        active->state = VALUE_SEGMENT_SEALED;
+        if (active->live == 0)
+            free_segment(store, store->active);
+        store->active = 0;
+    }
+
+    if (store->free_list == 0 && reclaim_segment(store) != SUCCESS)
+        return FAILURE;
+
+    u_int32_t index = store->free_list;
+    ValueSegment *segment = &store->segments[index - 1];
+    store->free_list = segment->next_free;
+    segment->state = VALUE_SEGMENT_ACTIVE;
+    segment->stamp = __atomic_add_fetch(&store->epoch, 1, __ATOMIC_RELAXED);
+    store->active = index;
+
+    return SUCCESS;
+}
+
+int store_value(ValueStore *store, const void *value, size_t len, void *owner, ValueRef *ref) {
+    if (!store || !ref || (!value && len > 0)) {
+        fprintf(stderr, "Value store, value or reference are not valid or are null!\n");
+        return IS_NULL;
+    }
+
+    size_t size = record_size(len);
+    if (len > UINT32_MAX || size > store->segment_size) {
+        fprintf(stderr, "Value store: Value of %zu bytes does not fit into a segment!\n", len);
+        return FAILURE;
+    }
+
+    if (!store->active || store->segments[store->active - 1].used + size > store->segment_size) {
+        if (open_segment(store) != SUCCESS)
+            return FAILURE;
+    }
+
+    /*
+     * "value" may be a stored value in the segment just reclaimed and
+     * reopened: its bytes are moved before the header can cover them
+     */
+    ValueSegment *segment = &store->segments[store->active - 1];
+    ValueRecord *record = record_at(store, store->active, segment->used);
+    if (len > 0)
+        memmove(record + 1, value, len);
+    record->owner = owner;
+    record->len = (u_int32_t)len;
+    record->live = 1;
+
+    ref->segment = store->active;
+    ref->offset = (u_int32_t)(segment->used + sizeof(ValueRecord));
+    segment->used += size;
+    segment->live += size;
+    store->live_bytes += size;
+
+    return SUCCESS;
+}
+
+void set_value_owner(ValueStore *store, ValueRef ref, void *owner) {
+    record_at(store, ref.segment, ref.offset - sizeof(ValueRecord))->owner = owner;
+}
+
+void release_value(ValueStore *store, ValueRef ref) {
+    ValueRecord *record = record_at(store, ref.segment, ref.offset - sizeof(ValueRecord));
+    if (!record->live)
+        return;
+
+    size_t size = record_size(record->len);
+    record->live = 0;
+    record->owner = NULL;
+
+    ValueSegment *segment = &store->segments[ref.segment - 1];
+    segment->live -= size;
+    store->live_bytes -= size;
+    if (segment->state == VALUE_SEGMENT_SEALED && segment->live == 0)
+        free_segment(store, ref.segment);
+}
+
+bool value_store_owns(const ValueStore *store, const void *value) {
+    return (const char *)value >= store->base && (const char *)value < store->base + store->map_size;
+}
+
+void free_value_store(ValueStore *store) {
+    if (!store) {
+        fprintf(stderr, "Value store is not valid or is null!\n");
+        return;
+    }
+
+    munmap(store->base, store->map_size);
+    free(store->segments);
+    free(store);
+}
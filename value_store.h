@@ -0,0 +1,142 @@
+#ifndef _VALUE_STORE_H_
+#define _VALUE_STORE_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+#define SUCCESS 0
+#define FAILURE -1
+#define IS_NULL -2
+
+/*
+ * Default segment size, a value must fit into one segment
+ * together with its record header
+ */
+#ifndef VALUE_SEGMENT_SIZE
+#define VALUE_SEGMENT_SIZE (4 << 20)
+#endif
+
+/*
+ * Where a stored value lives: segment number (from 1, 0 means the value
+ * is not in a store) and byte offset of the value within the segment.
+ * Its length is kept by the owner
+ */
+typedef struct ValueRef {
+    u_int32_t segment;
+    u_int32_t offset;
+} ValueRef;
+
+/*
+ * Segment states
+ * VALUE_SEGMENT_FREE:       on the free list, empty
+ * VALUE_SEGMENT_ACTIVE:     values are appended to it
+ * VALUE_SEGMENT_SEALED:     full, space comes back when all values are released
+ * VALUE_SEGMENT_RECLAIMING: its values are being evicted
+ */
+typedef enum ValueSegmentState {
+    VALUE_SEGMENT_FREE,
+    VALUE_SEGMENT_ACTIVE,
+    VALUE_SEGMENT_SEALED,
+    VALUE_SEGMENT_RECLAIMING
+} ValueSegmentState;
+
+/*
+ * "used" bytes were appended, "live" of them belong to values not yet
+ * released. "stamp" is the store's epoch when one of its values was last
+ * read or written, so segments are ordered by recency
+ */
+typedef struct ValueSegment {
+    size_t used;
+    size_t live;
+    u_int64_t stamp;
+    u_int32_t next_free;
+    ValueSegmentState state;
+} ValueSegment;
+
+/*
+ * Called for every value still live in a segment being reclaimed.
+ * It must release the value (release_value) before returning
+ */
+typedef void (*ValueEvictor)(void *owner, void *arg);
+
+/*
+ * Log-structured store of value bytes
+ * One mapping of "segment_count" segments of "segment_size" bytes,
+ * anonymous or backed by a file. Values are copied, each behind a record
+ * header naming its owner, to the end of the active segment; a full one
+ * is sealed and the next taken from the free list. Releasing a value
+ * only marks its record dead: space is reused a whole segment at a time,
+ * once every value in it is released, or when the store runs out of free
+ * segments and reclaims the least recently used sealed one, evicting its
+ * live values through "evict".
+ * Pages are only backed once written, so memory or file space grows with
+ * use. A file-backed store lets the kernel write cold segments out,
+ * holding more values than fit in RAM
+ */
+typedef struct ValueStore {
+    char *base;
+    size_t segment_size;
+    size_t segment_count;
+    size_t map_size;
+    ValueSegment *segments;
+    u_int32_t active;
+    u_int32_t free_list;
+    u_int64_t epoch;
+    size_t live_bytes;
+    ValueEvictor evict;
+    void *evict_arg;
+    bool file_backed;
+} ValueStore;
+
+/*
+ * Initialize store of "segment_count" (at least 2) segments of "segment_size"
+ * bytes each (0 for VALUE_SEGMENT_SIZE), evicting through "evict".
+ * "path" names a file to back it with, NULL for anonymous memory.
+ * The file is unlinked once mapped, its space goes away with the store
+ */
+ValueStore *init_value_store(size_t segment_size, size_t segment_count, const char *path, ValueEvictor evict,
+                             void *evict_arg);
+
+/*
+ * Copy "len" bytes of "value" into the store for "owner" and set "ref".
+ * May reclaim a segment, evicting the values in it, but never the one
+ * being appended to. Fails if the value does not fit into a segment.
+ * "owner" may be set later with set_value_owner
+ */
+int store_value(ValueStore *store, const void *value, size_t len, void *owner, ValueRef *ref);
+
+void set_value_owner(ValueStore *store, ValueRef ref, void *owner);
+
+/*
+ * The value's bytes, valid until it is released and its segment reused
+ */
+static inline void *value_at(const ValueStore *store, ValueRef ref) {
+    return store->base + (size_t)(ref.segment - 1) * store->segment_size + ref.offset;
+}
+
+/*
+ * Note a read of the value, its segment becomes most recently used.
+ * Only writes when the segment is not already current,
+ * safe from concurrent readers
+ */
+static inline void touch_value(ValueStore *store, ValueRef ref) {
+    ValueSegment *segment = &store->segments[ref.segment - 1];
+    u_int64_t epoch = __atomic_load_n(&store->epoch, __ATOMIC_RELAXED);
+    if (__atomic_load_n(&segment->stamp, __ATOMIC_RELAXED) != epoch)
+        __atomic_store_n(&segment->stamp, epoch, __ATOMIC_RELAXED);
+}
+
+/*
+ * Drop the value, a sealed segment left without live values is free again
+ */
+void release_value(ValueStore *store, ValueRef ref);
+
+/*
+ * True if "value" points into the store
+ */
+bool value_store_owns(const ValueStore *store, const void *value);
+
+void free_value_store(ValueStore *store);
+
+#endif // _VALUE_STORE_H_